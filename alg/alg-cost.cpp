@@ -0,0 +1,117 @@
+/* static cost estimates */
+
+#include <algorithm>
+#include <unordered_map>
+#include <utility>
+
+#include "alg/alg-cost.hpp"
+#include "alg/alg-loop.hpp"
+#include "cgen.hpp"
+
+namespace zc::alg {
+
+   namespace {
+
+      long trips(int depth) {
+         long trips = 1;
+         for (int i = 0; i < depth; ++i) { trips *= CostReport::loop_trips; }
+         return trips;
+      }
+
+   }
+
+   long CostReport::BlockCost::weighted_cycles() const { return max_cycles() * trips(depth); }
+
+   CostReport::CostReport(const FunctionImpl& impl): entry_(impl.entry()) {
+      const Loops loops(impl);
+
+      Blocks visited;
+      auto fn = [&](Block *block) {
+                   const BlockCost& block_cost =
+                      blocks_.emplace_back(BlockCost {block, loops.depth(block), block->cost()});
+                   bytes_ += block_cost.cost.bytes;
+                   weighted_cycles_ += block_cost.weighted_cycles();
+
+                   for (const Instruction *instr : block->instrs()) {
+                      if (instr->opcode() != Opcode::CALL) { continue; }
+                      auto target = dynamic_cast<const LabelValue *>(instr->dst());
+                      if (target && g_crt.contains(target->label())) {
+                         CrtCalls& calls = crt_calls_[target->label()->name()];
+                         ++calls.calls;
+                         calls.weighted += trips(block_cost.depth);
+                      }
+                   }
+                };
+      impl.entry()->for_each_block(visited, fn);
+      impl.fin()->for_each_block(visited, fn);
+
+      ComputePaths(loops);
+   }
+
+   void CostReport::ComputePaths(const Loops& loops) {
+      std::unordered_map<const Block *, const BlockCost *> costs;
+      for (const BlockCost& block_cost : blocks_) {
+         costs[block_cost.block] = &block_cost;
+      }
+
+      const std::vector<Block *>& order = loops.order();
+      std::unordered_map<const Block *, std::size_t> index;
+      for (std::size_t i = 0; i < order.size(); ++i) {
+         index[order[i]] = i;
+      }
+
+      /* shortest and longest paths to the start of each block, over forward edges; every
+       * block but the entry has a predecessor earlier in reverse postorder */
+      std::unordered_map<const Block *, std::pair<int, int>> paths;
+      bool found_exit = false;
+      for (std::size_t i = 0; i < order.size(); ++i) {
+         const Block *block = order[i];
+         const BlockCost *block_cost = costs.at(block);
+         std::pair<int, int> path = paths[block];
+         path.first += block_cost->min_cycles();
+         path.second += block_cost->max_cycles();
+
+         bool exit = true;
+         for (const BlockTransition *trans : block->transitions().vec()) {
+            const Block *dst = trans->dst();
+            if (dst == nullptr) { continue; }
+            exit = false;
+            if (index.at(dst) <= i) { continue; } /* back edge */
+
+            auto it = paths.find(dst);
+            if (it == paths.end()) {
+               paths.emplace(dst, path);
+            } else {
+               it->second.first = std::min(it->second.first, path.first);
+               it->second.second = std::max(it->second.second, path.second);
+            }
+         }
+
+         if (exit) {
+            min_cycles_ = found_exit ? std::min(min_cycles_, path.first) : path.first;
+            max_cycles_ = found_exit ? std::max(max_cycles_, path.second) : path.second;
+            found_exit = true;
+         }
+      }
+   }
+
+   void CostReport::Dump(std::ostream& os) const {
+      os << entry_->label()->name() << ": " << bytes() << " bytes, " << min_cycles() << "-"
+         << max_cycles() << " cycles, " << weighted_cycles() << " loop-weighted" << std::endl
+         << "BLOCK\t\tDEPTH\tBYTES\tMIN\tMAX\tWEIGHTED" << std::endl;
+      for (const BlockCost& block : blocks()) {
+         os << block.block->label()->name() << "\t\t" << block.depth << "\t" << block.cost.bytes
+            << "\t" << block.min_cycles() << "\t" << block.max_cycles() << "\t"
+            << block.weighted_cycles() << std::endl;
+      }
+
+      if (!crt_calls().empty()) {
+         os << "CRT\t\tCALLS\tWEIGHTED" << std::endl;
+         for (const auto& pair : crt_calls()) {
+            os << pair.first << "\t\t" << pair.second.calls << "\t" << pair.second.weighted
+               << std::endl;
+         }
+      }
+   }
+
+}
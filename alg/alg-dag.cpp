@@ -20,6 +20,7 @@ namespace zc {
    void ExprStat::DAG() { expr_ = expr()->DAG(); }
    void ReturnStat::DAG() { expr_ = expr()->DAG(); }
    void IfStat::DAG() { cond_ = cond()->DAG(); if_body()->DAG(); else_body()->DAG(); }
+   void SwitchStat::DAG() { expr_ = expr()->DAG(); body()->DAG(); }
    void IterationStat::DAG() { pred_ = pred()->DAG(); body()->DAG(); }
    void ForStat::DAG() { IterationStat::DAG(); init_ = init()->DAG(); after_ = after()->DAG(); }
 
@@ -29,17 +30,27 @@ namespace zc {
    }
    
    ASTExpr *ASTExpr::DAG_aux(alg::DAGSet& dagset) {
-      auto it = std::find_if(dagset.begin(), dagset.end(),
-                          [&](ASTExpr *dagexpr) {
-                             return ExprEq(dagexpr);
-                          });
-      if (it != dagset.end()) {
-         /* return expression in DAG set */
-         return *it;
-      } else {
-         dagset.push_back(this);
-         return this;
+      return dagset.Intern(this);
+   }
+
+   namespace alg {
+
+      ASTExpr *DAGSet::Intern(ASTExpr *expr) {
+         const std::size_t hash = expr->ExprHash();
+         auto range = exprs_.equal_range(hash);
+         auto it = std::find_if(range.first, range.second,
+                                [&](const auto& pair) {
+                                   return expr->ExprEq(pair.second);
+                                });
+         if (it != range.second) {
+            /* return expression in DAG set */
+            return it->second;
+         } else {
+            exprs_.emplace(hash, expr);
+            return expr;
+         }
       }
+      
    }
    
 }
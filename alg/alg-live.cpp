@@ -1,9 +1,242 @@
 /* live range analysis */
 
-#inclue "alg/alg-live.hpp"
+#include <utility>
+#include <algorithm>
 
-namespace zc {
+#include "alg/alg-live.hpp"
+#include "alg.hpp"
+#include "asm.hpp"
+#include "cgen.hpp"
+
+namespace zc::alg {
+
+   /*** BIT VECTOR ***/
+
+   std::size_t BitVector::count() const {
+      std::size_t n = 0;
+      for (Word word : words_) {
+         n += __builtin_popcountll(word);
+      }
+      return n;
+   }
+
+   BitVector& BitVector::operator|=(const BitVector& other) {
+      for (std::size_t w = 0; w < words_.size(); ++w) {
+         words_[w] |= other.words_[w];
+      }
+      return *this;
+   }
+
+   BitVector& BitVector::operator-=(const BitVector& other) {
+      for (std::size_t w = 0; w < words_.size(); ++w) {
+         words_[w] &= ~other.words_[w];
+      }
+      return *this;
+   }
+
+
+   /*** SLOTS ***/
+
+   template <typename Func>
+   void LiveSlots::for_each_reg(const z80::Register *reg, Func func) const {
+      /* registers without byte registers (i.e. sp) are tracked whole */
+      z80::RegMask mask = reg->mask();
+      if (mask == 0) {
+         func(reg);
+      }
+      for (; mask; mask &= mask - 1) {
+         func(z80::byte_reg(static_cast<z80::RegIndex>(__builtin_ctz(mask))));
+      }
+   }
+
+   void LiveSlots::Add(const z80::Value *val) {
+      auto var = dynamic_cast<const z80::VariableValue *>(val);
+      if (var) {
+         if (vars_.find(var->id()) == vars_.end()) {
+            vars_[var->id()] = names_.size();
+            names_.push_back("%" + std::to_string(var->id()));
+         }
+         return;
+      }
+
+      if (val->reg()) {
+         for_each_reg(val->reg(), [&](const z80::Register *reg) {
+                                     if (regs_.find(reg) == regs_.end()) {
+                                        regs_[reg] = names_.size();
+                                        names_.push_back(reg->name());
+                                     }
+                                  });
+      }
+   }
+
+   void LiveSlots::Insert(const z80::Value *val, BitVector& bits) const {
+      auto var = dynamic_cast<const z80::VariableValue *>(val);
+      if (var) {
+         auto it = vars_.find(var->id());
+         if (it != vars_.end()) { bits.set(it->second); }
+         return;
+      }
+
+      if (val->reg()) {
+         for_each_reg(val->reg(), [&](const z80::Register *reg) {
+                                     auto it = regs_.find(reg);
+                                     if (it != regs_.end()) { bits.set(it->second); }
+                                  });
+      }
+   }
+
+   bool LiveSlots::Test(const z80::Value *val, const BitVector& bits) const {
+      auto var = dynamic_cast<const z80::VariableValue *>(val);
+      if (var) {
+         auto it = vars_.find(var->id());
+         return it != vars_.end() && bits.test(it->second);
+      }
+
+      bool any = false;
+      if (val->reg()) {
+         for_each_reg(val->reg(), [&](const z80::Register *reg) {
+                                     auto it = regs_.find(reg);
+                                     if (it != regs_.end() && bits.test(it->second)) {
+                                        any = true;
+                                     }
+                                  });
+      }
+      return any;
+   }
+
+
+   /*** LIVENESS ***/
+
+   Liveness::Liveness(const FunctionImpl& impl) {
+      ComputeOrder(impl);
+      ComputeLocal();
+      Solve();
+   }
+
+   void Liveness::ComputeOrder(const FunctionImpl& impl) {
+      /* iterative DFS; successors are the blocks targeted by transitions */
+      std::vector<std::pair<const Block *, std::size_t>> stack;
+      for (const Block *root : {impl.entry(), impl.fin()}) {
+         if (infos_.find(root) != infos_.end()) { continue; }
+         infos_[root];
+         stack.push_back({root, 0});
+
+         while (!stack.empty()) {
+            auto& top = stack.back();
+            const auto& transitions = top.first->transitions().vec();
+            if (top.second == transitions.size()) {
+               postorder_.push_back(top.first);
+               stack.pop_back();
+               continue;
+            }
+
+            const Block *succ = transitions[top.second++]->dst();
+            if (succ == nullptr) { continue; }
+            infos_.at(top.first).succs.push_back(succ);
+            if (infos_.find(succ) == infos_.end()) {
+               infos_[succ];
+               stack.push_back({succ, 0});
+            }
+         }
+      }
+   }
+
+   void Liveness::ComputeLocal() {
+      /* number all values referenced in function */
+      ValueSet vals;
+      for (const Block *block : postorder_) {
+         for (const z80::Instruction *instr : block->instrs()) {
+            instr->Kill(std::inserter(vals, vals.begin()));
+            instr->Gen(std::inserter(vals, vals.begin()));
+         }
+      }
+      for (const z80::Value *val : vals) {
+         slots_.Add(val);
+      }
+      slots_.Add(&z80::rv_b); /* counter of djnz transitions */
+
+      /* per-block upward-exposed uses and defs, walking instructions backwards */
+      for (const Block *block : postorder_) {
+         BlockInfo& info = infos_.at(block);
+         info.use = info.def = info.live_in = info.live_out = BitVector(slots_.size());
+
+         /* transitions follow the instructions; djnz reads and decrements b */
+         for (const BlockTransition *trans : block->transitions().vec()) {
+            if (dynamic_cast<const DjnzTransition *>(trans)) {
+               slots_.Insert(&z80::rv_b, info.use);
+               slots_.Insert(&z80::rv_b, info.def);
+            }
+         }
+
+         for (auto it = block->instrs().rbegin(); it != block->instrs().rend(); ++it) {
+            ValueSet kills, gens;
+            (*it)->Kill(std::inserter(kills, kills.begin()));
+            (*it)->Gen(std::inserter(gens, gens.begin()));
+
+            BitVector instr_def(slots_.size()), instr_use(slots_.size());
+            for (const z80::Value *val : kills) { slots_.Insert(val, instr_def); }
+            for (const z80::Value *val : gens) { slots_.Insert(val, instr_use); }
+
+            info.def |= instr_def;
+            info.use -= instr_def;
+            info.use |= instr_use;
+         }
+      }
+   }
+
+   void Liveness::Solve() {
+      /* postorder visits successors first, so most information flows within one pass */
+      for (bool changed = true; changed; ++iterations_) {
+         changed = false;
+         for (const Block *block : postorder_) {
+            BlockInfo& info = infos_.at(block);
+            for (const Block *succ : info.succs) {
+               info.live_out |= infos_.at(succ).live_in;
+            }
+
+            BitVector live_in = info.live_out;
+            live_in -= info.def;
+            live_in |= info.use;
+            if (live_in != info.live_in) {
+               info.live_in = std::move(live_in);
+               changed = true;
+            }
+         }
+      }
+   }
+
+   bool Liveness::test(const BitVector& bits, const z80::Value *val) const {
+      return slots_.Test(val, bits);
+   }
+
+   bool Liveness::live_in(const Block *block, const z80::Value *val) const {
+      return test(live_in(block), val);
+   }
+
+   bool Liveness::live_out(const Block *block, const z80::Value *val) const {
+      return test(live_out(block), val);
+   }
+
+   void Liveness::Dump(std::ostream& os) const {
+      /* sort by name, since slot numbering depends on set iteration order */
+      auto dump_set = [&](const char *name, const BitVector& bits) {
+                         std::vector<std::string> names;
+                         bits.for_each([&](std::size_t slot) {
+                                          names.push_back(slots_.name(slot));
+                                       });
+                         std::sort(names.begin(), names.end());
+                         os << "\t" << name << ":";
+                         for (const std::string& name : names) { os << " " << name; }
+                         os << std::endl;
+                      };
+
+      for (auto it = postorder_.rbegin(); it != postorder_.rend(); ++it) {
+         const BlockInfo& info = infos_.at(*it);
+         os << (*it)->label()->name() << ":" << std::endl;
+         dump_set("in", info.live_in);
+         dump_set("out", info.live_out);
+      }
+      os << "(" << slots_.size() << " slots, " << iterations_ << " iterations)" << std::endl;
+   }
 
-   
-   
 }
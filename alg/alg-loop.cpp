@@ -0,0 +1,164 @@
+/* loop detection */
+
+#include <algorithm>
+#include <utility>
+
+#include "alg/alg-loop.hpp"
+#include "asm.hpp"
+#include "cgen.hpp"
+
+namespace zc::alg {
+
+   Loops::Loops(const FunctionImpl& impl) {
+      ComputeOrder(impl);
+      ComputeDominators();
+      ComputeLoops();
+   }
+
+   void Loops::ComputeOrder(const FunctionImpl& impl) {
+      /* iterative DFS from entry, as in liveness analysis */
+      std::vector<Block *> postorder;
+      std::vector<std::pair<Block *, std::size_t>> stack;
+      preds_[impl.entry()];
+      stack.push_back({impl.entry(), 0});
+
+      while (!stack.empty()) {
+         auto& top = stack.back();
+         const auto& transitions = top.first->transitions().vec();
+         if (top.second == transitions.size()) {
+            postorder.push_back(top.first);
+            stack.pop_back();
+            continue;
+         }
+
+         Block *pred = top.first;
+         Block *succ = transitions[top.second++]->dst();
+         if (succ == nullptr) { continue; }
+         bool visited = preds_.find(succ) != preds_.end();
+         std::vector<Block *>& succ_preds = preds_[succ];
+         if (std::find(succ_preds.begin(), succ_preds.end(), pred) == succ_preds.end()) {
+            succ_preds.push_back(pred);
+         }
+         if (!visited) { stack.push_back({succ, 0}); }
+      }
+
+      rpo_.assign(postorder.rbegin(), postorder.rend());
+      for (std::size_t i = 0; i < rpo_.size(); ++i) {
+         index_[rpo_[i]] = i;
+      }
+   }
+
+   void Loops::ComputeDominators() {
+      /* Cooper, Harvey & Kennedy: iterate over reverse postorder, intersecting the dominator
+       * chains of processed predecessors */
+      idoms_.assign(rpo_.size(), -1);
+      idoms_[0] = 0;
+
+      auto intersect = [&](int a, int b) {
+                          while (a != b) {
+                             while (a > b) { a = idoms_[a]; }
+                             while (b > a) { b = idoms_[b]; }
+                          }
+                          return a;
+                       };
+
+      for (bool changed = true; changed; ) {
+         changed = false;
+         for (std::size_t i = 1; i < rpo_.size(); ++i) {
+            int idom = -1;
+            for (const Block *pred : preds_.at(rpo_[i])) {
+               int p = index_.at(pred);
+               if (idoms_[p] < 0) { continue; }
+               idom = idom < 0 ? p : intersect(p, idom);
+            }
+            if (idom != idoms_[i]) {
+               idoms_[i] = idom;
+               changed = true;
+            }
+         }
+      }
+   }
+
+   bool Loops::dominates(const Block *a, const Block *b) const {
+      auto a_it = index_.find(a), b_it = index_.find(b);
+      if (a_it == index_.end() || b_it == index_.end()) { return false; }
+
+      int i = b_it->second;
+      while (i > a_it->second) { i = idoms_[i]; }
+      return i == a_it->second;
+   }
+
+   void Loops::ComputeLoops() {
+      /* find back edges, merging loops with a common header */
+      std::unordered_map<const Block *, std::size_t> by_header;
+      for (Block *block : rpo_) {
+         for (const BlockTransition *trans : block->transitions().vec()) {
+            Block *header = trans->dst();
+            if (header == nullptr || !dominates(header, block)) { continue; }
+
+            auto it = by_header.find(header);
+            if (it == by_header.end()) {
+               it = by_header.insert({header, loops_.size()}).first;
+               loops_.push_back(Loop());
+               loops_.back().header = header;
+               loops_.back().members.insert(header);
+            }
+            Loop& loop = loops_[it->second];
+            if (std::find(loop.latches.begin(), loop.latches.end(), block) ==
+                loop.latches.end()) {
+               loop.latches.push_back(block);
+            }
+
+            /* walk predecessors back from latch to header */
+            std::vector<Block *> worklist {block};
+            while (!worklist.empty()) {
+               Block *member = worklist.back();
+               worklist.pop_back();
+               if (!loop.members.insert(member).second) { continue; }
+               for (Block *pred : preds_.at(member)) { worklist.push_back(pred); }
+            }
+         }
+      }
+
+      for (Loop& loop : loops_) {
+         std::copy_if(rpo_.begin(), rpo_.end(), std::back_inserter(loop.blocks),
+                      [&](const Block *block) { return loop.contains(block); });
+      }
+
+      /* inner loops are strictly smaller than the loops enclosing them */
+      std::stable_sort(loops_.begin(), loops_.end(), [](const Loop& a, const Loop& b) {
+                                                        return a.blocks.size() < b.blocks.size();
+                                                     });
+      for (std::size_t i = 0; i < loops_.size(); ++i) {
+         for (std::size_t j = i + 1; j < loops_.size(); ++j) {
+            if (loops_[j].contains(loops_[i].header)) {
+               loops_[i].parent = j;
+               break;
+            }
+         }
+      }
+      for (auto it = loops_.rbegin(); it != loops_.rend(); ++it) {
+         it->depth = it->parent < 0 ? 1 : loops_[it->parent].depth + 1;
+      }
+   }
+
+   int Loops::depth(const Block *block) const {
+      int depth = 0;
+      for (const Loop& loop : loops_) {
+         if (loop.contains(block)) { depth = std::max(depth, loop.depth); }
+      }
+      return depth;
+   }
+
+   void Loops::Dump(std::ostream& os) const {
+      for (const Loop& loop : loops_) {
+         os << loop.header->label()->name() << ": depth " << loop.depth << ", latches";
+         for (const Block *latch : loop.latches) { os << " " << latch->label()->name(); }
+         os << std::endl << "\tblocks:";
+         for (const Block *block : loop.blocks) { os << " " << block->label()->name(); }
+         os << std::endl;
+      }
+      os << "(" << rpo_.size() << " blocks, " << loops_.size() << " loops)" << std::endl;
+   }
+
+}
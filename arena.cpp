@@ -0,0 +1,52 @@
+#include <new>
+#include <cstdint>
+#include <algorithm>
+
+#include "arena.hpp"
+
+namespace zc {
+
+   void *Arena::Allocate(std::size_t size, std::size_t align) {
+      auto aligned = [&](char *ptr) {
+                        auto addr = reinterpret_cast<std::uintptr_t>(ptr);
+                        return reinterpret_cast<char *>((addr + align - 1) & ~(align - 1));
+                     };
+
+      char *ptr = aligned(cur_);
+      if (cur_ == nullptr || ptr + size > end_) {
+         /* oversized requests get a chunk of their own */
+         std::size_t chunk_size = std::max(chunk_size_, size + align);
+         char *chunk = static_cast<char *>(::operator new(chunk_size));
+         chunks_.push_back(chunk);
+         reserved_ += chunk_size;
+         cur_ = chunk;
+         end_ = chunk + chunk_size;
+         ptr = aligned(cur_);
+      }
+
+      cur_ = ptr + size;
+      bytes_ += size;
+      ++allocs_;
+      return ptr;
+   }
+
+   void Arena::Release() {
+      for (char *chunk : chunks_) {
+         ::operator delete(chunk);
+      }
+      chunks_.clear();
+      cur_ = end_ = nullptr;
+      bytes_ = reserved_ = allocs_ = 0;
+   }
+
+   Arena& ast_arena() {
+      static Arena arena;
+      return arena;
+   }
+
+   Arena& ir_arena() {
+      static Arena arena;
+      return arena;
+   }
+
+}
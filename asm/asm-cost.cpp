@@ -0,0 +1,239 @@
+#include "asm.hpp"
+#include "cgen.hpp"
+
+namespace zc::z80 {
+
+   AddrMode addr_mode(const Value *val) {
+      if (val == nullptr) { return AddrMode::NONE; }
+
+      if (auto rv = dynamic_cast<const RegisterValue *>(val)) {
+         const Register *reg = rv->reg();
+         if (reg->kind() == Register::Kind::REG_BYTE) {
+            return (reg->mask() & (mask_ix | mask_iy)) ? AddrMode::IDX_REG : AddrMode::REG;
+         }
+         if (reg->Eq(&r_sp)) { return AddrMode::SP; }
+         return (reg->Eq(&r_ix) || reg->Eq(&r_iy)) ? AddrMode::IDX_PAIR : AddrMode::PAIR;
+      }
+
+      if (auto var = dynamic_cast<const VariableValue *>(val)) {
+         return (var->size() == byte_size) ? AddrMode::REG : AddrMode::PAIR;
+      }
+
+      if (dynamic_cast<const ImmediateValue *>(val) || dynamic_cast<const LabelValue *>(val) ||
+          dynamic_cast<const FrameValue *>(val)) {
+         return AddrMode::IMM;
+      }
+
+      if (dynamic_cast<const IndexedRegisterValue *>(val)) { return AddrMode::IDX_OFF; }
+
+      if (auto offset = dynamic_cast<const OffsetValue *>(val)) {
+         AddrMode mode = addr_mode(offset->base());
+         return (mode == AddrMode::IDX_PAIR) ? AddrMode::IDX_OFF : mode;
+      }
+
+      if (auto byte = dynamic_cast<const ByteValue *>(val)) {
+         switch (AddrMode mode = addr_mode(byte->all())) {
+         case AddrMode::PAIR:     return AddrMode::REG;
+         case AddrMode::IDX_PAIR: return AddrMode::IDX_REG;
+         default:                 return mode;
+         }
+      }
+
+      if (auto mem = dynamic_cast<const MemoryValue *>(val)) {
+         switch (addr_mode(mem->addr())) {
+         case AddrMode::PAIR:     return AddrMode::IND_PAIR;
+         case AddrMode::SP:       return AddrMode::IND_SP;
+         case AddrMode::IDX_PAIR:
+         case AddrMode::IDX_OFF:  return AddrMode::IND_IDX;
+         default:                 return AddrMode::IND_ABS;
+         }
+      }
+
+      return AddrMode::NONE; /* flags */
+   }
+
+   namespace {
+
+      bool is_indexed(AddrMode mode) {
+         return mode == AddrMode::IDX_REG || mode == AddrMode::IDX_PAIR ||
+            mode == AddrMode::IND_IDX;
+      }
+
+      bool is_pair(AddrMode mode) {
+         return mode == AddrMode::PAIR || mode == AddrMode::IDX_PAIR || mode == AddrMode::SP;
+      }
+
+      bool is_mem(AddrMode mode) {
+         return mode == AddrMode::IND_PAIR || mode == AddrMode::IND_SP ||
+            mode == AddrMode::IND_IDX || mode == AddrMode::IND_ABS;
+      }
+
+      /* hl has short forms of `ld hl,(Mmn)' and `ld (Mmn),hl'; unallocated variables are
+       * assumed to get it */
+      bool is_hl(const Value *val) {
+         auto rv = dynamic_cast<const RegisterValue *>(val);
+         return rv ? rv->reg()->Eq(&r_hl) : dynamic_cast<const VariableValue *>(val) != nullptr;
+      }
+
+   }
+
+   Cost Instruction::cost(CpuMode mode) const {
+      const int word = (mode == CpuMode::ADL) ? 3 : 2; /* width of addresses and pairs */
+      const AddrMode dst_mode = addr_mode(dst()), src_mode = addr_mode(src());
+      const bool cond = cond_ && *cond_ != Cond::ANY;
+
+      /* encoding: [prefix] opcode [displacement] [immediate] */
+      bool prefix = is_indexed(dst_mode) || is_indexed(src_mode);
+      int opcode = 1;
+      int disp = (dst_mode == AddrMode::IND_IDX || src_mode == AddrMode::IND_IDX) ? 1 : 0;
+      int data = (is_pair(dst_mode) || is_pair(src_mode)) ? word : byte_size;
+      int imm = 0;
+      for (AddrMode operand : {dst_mode, src_mode}) {
+         if (operand == AddrMode::IMM) { imm = data; }
+         if (operand == AddrMode::IND_ABS) { imm = word; }
+      }
+
+      /* execution: memory bytes read or written, internal cycles, extra cycles when taken */
+      int mem = (is_mem(dst_mode) || is_mem(src_mode)) ? data : 0;
+      int internal = 0;
+      int taken = 0;
+
+      switch (opcode_) {
+      case Opcode::LABEL:
+         return Cost();
+
+      case Opcode::ADD:
+      case Opcode::SUB:
+      case Opcode::AND:
+      case Opcode::OR:
+      case Opcode::XOR:
+      case Opcode::CP:
+         break;
+
+      case Opcode::ADC:
+      case Opcode::SBC:
+         if (data != byte_size) { opcode = 2; } /* adc/sbc hl,rr are extended */
+         break;
+
+      case Opcode::INC:
+      case Opcode::DEC:
+         if (mem) {
+            mem = 2 * byte_size; /* read-modify-write */
+            internal = 1;
+         }
+         break;
+
+      case Opcode::RL:
+      case Opcode::RLC:
+      case Opcode::RR:
+      case Opcode::RRC:
+      case Opcode::SLA:
+      case Opcode::SRA:
+      case Opcode::SRL:
+         opcode = 2;
+         if (mem) {
+            mem = 2 * byte_size;
+            internal = 1;
+         }
+         break;
+
+      case Opcode::CCF:
+      case Opcode::CPL:
+      case Opcode::SCF:
+         break;
+
+      case Opcode::NEG:
+         opcode = 2;
+         break;
+
+      case Opcode::MLT:
+         opcode = 2;
+         internal = 4;
+         break;
+
+      case Opcode::LEA:
+         /* ed op d; the index register is encoded in the opcode */
+         return Cost {3, 3, 0};
+
+      case Opcode::PEA:
+         return Cost {3, 3 + word + 1, 0};
+
+      case Opcode::PUSH:
+      case Opcode::POP:
+         mem = word;
+         break;
+
+      case Opcode::EX:
+         /* ex (sp),hl reads and writes a word; ex de,hl is a register swap */
+         mem = (dst_mode == AddrMode::IND_SP) ? 2 * word : 0;
+         break;
+
+      case Opcode::CALL:
+         /* pushes return address */
+         imm = word;
+         if (cond) {
+            mem = 0;
+            taken = word;
+         } else {
+            mem = word;
+         }
+         break;
+
+      case Opcode::JP:
+         if (is_mem(dst_mode)) {
+            /* jp (hl), jp (ix): no displacement, no memory access */
+            disp = 0;
+            mem = 0;
+            internal = 2;
+         } else {
+            imm = word;
+            if (cond) { taken = 1; } else { internal = 1; }
+         }
+         break;
+
+      case Opcode::JR:
+         imm = 1;
+         if (cond) { taken = 1; } else { internal = 1; }
+         break;
+
+      case Opcode::DJNZ:
+         imm = 1;
+         internal = 1;
+         taken = 1;
+         break;
+
+      case Opcode::RET:
+         mem = word;
+         internal = 2;
+         break;
+
+      case Opcode::RET_CC:
+         taken = word + 2;
+         break;
+
+      case Opcode::LD:
+         if (is_pair(dst_mode) && is_pair(src_mode) && dst_mode != AddrMode::SP) {
+            /* pseudo-instruction: push <src> \ pop <dst> */
+            int bytes = 2 + is_indexed(dst_mode) + is_indexed(src_mode);
+            return Cost {bytes, bytes + 2 * word, 0};
+         }
+         if ((is_pair(dst_mode) && src_mode == AddrMode::IND_PAIR) ||
+             (is_pair(src_mode) && dst_mode == AddrMode::IND_PAIR)) {
+            /* ld rr,(hl) / ld (hl),rr are extended, including for ix and iy */
+            prefix = false;
+            opcode = 2;
+         } else if ((dst_mode == AddrMode::IND_ABS && !is_hl(src()) && is_pair(src_mode) &&
+                     src_mode != AddrMode::IDX_PAIR) ||
+                    (src_mode == AddrMode::IND_ABS && !is_hl(dst()) && is_pair(dst_mode) &&
+                     dst_mode != AddrMode::IDX_PAIR)) {
+            /* ld bc/de/sp,(Mmn) / ld (Mmn),bc/de/sp are extended */
+            opcode = 2;
+         }
+         break;
+      }
+
+      const int bytes = prefix + opcode + disp + imm;
+      return Cost {bytes, bytes + mem + internal, taken};
+   }
+
+}
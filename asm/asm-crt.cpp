@@ -27,6 +27,16 @@ namespace zc::z80 {
       }
    }
 
+   bool CRT::preserves_regs(const Label *label) const {
+      if (label->name() == "__indcall") { return false; }
+      auto it = map_.find(label->name());
+      return it != map_.end() && it->second.first == label;
+   }
+
+   bool CRT::contains(const Label *label) const {
+      return map_.find(label->name()) != map_.end();
+   }
+
    const LabelValue *CRT::val(const std::string& name) {
       auto it = map_.find(name);
       if (it == map_.end()) {
@@ -7,6 +7,14 @@
 namespace zc::z80 {
    
    using alg::ValueInserter;
+
+   const char *mnemonic(Opcode opcode) {
+      static const char *mnemonics[opcode_count] =
+         {"adc", "add", "and", "call", "ccf", "cp", "cpl", "dec", "djnz", "ex", "inc", "jp", "jr",
+          "ld", "lea", "mlt", "neg", "or", "pea", "pop", "push", "ret", "ret", "rl", "rlc", "rr",
+          "rrc", "sbc", "scf", "sla", "sra", "srl", "sub", "xor", "%label"};
+      return mnemonics[static_cast<std::size_t>(opcode)];
+   }
     
     void Instruction::Emit(std::ostream& os) const {
        os << "\t" << name();
@@ -36,7 +44,7 @@ namespace zc::z80 {
     }
 
     bool Instruction::Eq(const Instruction *other) const {
-       if (name() != other->name()) {
+       if (opcode() != other->opcode()) {
           return false;
        }
 
@@ -52,7 +60,7 @@ namespace zc::z80 {
     }
 
     bool Instruction::Match(const Instruction *other) const {
-       if (name() != other->name()) {
+       if (opcode() != other->opcode()) {
           return false;
        }
 
@@ -99,10 +107,26 @@ namespace zc::z80 {
    void CallInstruction::Kill(ValueInserter vals) const {
       rv_hl.Kill(vals);
       rv_bc.Kill(vals);
+
+      /* compiled functions may clobber any scratch register */
+      auto target = dynamic_cast<const LabelValue *>(dst());
+      if (target == nullptr || !g_crt.preserves_regs(target->label())) {
+         rv_a.Kill(vals);
+         rv_de.Kill(vals);
       }
+   }
    void CallInstruction::Gen(ValueInserter vals) const {
       rv_hl.Gen(vals);
       rv_bc.Gen(vals);
+
+      /* register-convention arguments */
+      for (const RegisterValue *rv : {&rv_a, &rv_de}) {
+         if (args() & rv->reg()->mask()) { rv->Gen(vals); }
+      }
+   }
+   
+   void JumpInstruction::Gen(ValueInserter vals) const {
+      if (dynamic_cast<const MemoryValue *>(dst())) { dst()->Gen(vals); }
    }
    
    void CplInstruction::Kill(ValueInserter vals) const { rv_a.Kill(vals); }
@@ -140,7 +164,7 @@ namespace zc::z80 {
    
    /*** VARS ***/
    void Instruction::ReplaceVar(const VariableValue *var, const Value *with) {
-      for (Values::iterator operand_it = operands_.begin(), operand_end = operands_.end();
+      for (Operands::iterator operand_it = operands_.begin(), operand_end = operands_.end();
            operand_it != operand_end;
            ++operand_it) {
          *operand_it = (**operand_it)->ReplaceVar(var, with);
@@ -167,6 +191,10 @@ namespace zc::z80 {
       const RegisterValue rv2(&r2, &sz2);
       const LoadInstruction instr(&rv1, &rv2);
       if (instr.Match(this) && r1 != &r_sp) {
+         /* a load into the same register does nothing; `ld b,b' through `ld e,e' aren't even
+          * no-ops on the eZ80, but mode suffixes applying to the next instruction */
+         if (r1->Eq(r2)) { return; }
+
          if (sz1 == sz2 && (sz1 == word_size || sz1 == long_size)) {
             /* push rr1 \ pop rr2 */
             out.push_back(new PushInstruction(src()));
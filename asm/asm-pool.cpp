@@ -0,0 +1,66 @@
+#include "asm.hpp"
+
+namespace zc::z80 {
+
+   ValuePool& value_pool() {
+      static ValuePool pool;
+      return pool;
+   }
+
+   std::size_t ValuePool::size() const {
+      return imms_.size() + regs_.size() + indexeds_.size() + frames_.size() + mems_.size();
+   }
+
+   const ImmediateValue *ValuePool::Imm(intmax_t imm, int size) {
+      const ImmediateValue *& val = imms_[{imm, size}];
+      if (val == nullptr) { val = new ImmediateValue(imm, size); }
+      return val;
+   }
+
+   const RegisterValue *ValuePool::Reg(const Register *reg) {
+      return Reg(reg, reg->size());
+   }
+
+   const RegisterValue *ValuePool::Reg(const Register *reg, int size) {
+      const RegisterValue *& val = regs_[{reg, size}];
+      if (val == nullptr) { val = new RegisterValue(reg, size); }
+      return val;
+   }
+
+   const IndexedRegisterValue *ValuePool::Indexed(const RegisterValue *val,
+                                                  const IndexedRegisterValue::Index& index) {
+      val = Reg(val->reg(), val->size());
+      const IndexedRegisterValue *& ir = indexeds_[{val, index}];
+      if (ir == nullptr) { ir = new IndexedRegisterValue(val, index); }
+      return ir;
+   }
+
+   const FrameValue *ValuePool::Frame(FrameValue::FrameIndices *indices,
+                                      FrameValue::FrameIndices::iterator pos, bool negate) {
+      const FrameValue *& val = frames_[{indices, &*pos, negate}];
+      if (val == nullptr) { val = new FrameValue(indices, pos, negate); }
+      return val;
+   }
+
+   const MemoryValue *ValuePool::Mem(const Value *addr, int size) {
+      const MemoryValue *& val = mems_[{addr, size}];
+      if (val == nullptr) { val = new MemoryValue(addr, size); }
+      return val;
+   }
+
+   void ValuePool::Clear() {
+      imms_.clear();
+      regs_.clear();
+      indexeds_.clear();
+      frames_.clear();
+      mems_.clear();
+
+      /* fixed register values are canonical, so pool lookups agree with the globals */
+      for (const RegisterValue *rv : {&rv_a, &rv_b, &rv_c, &rv_d, &rv_e, &rv_f, &rv_h, &rv_l,
+                                      &rv_ixh, &rv_ixl, &rv_iyh, &rv_iyl, &rv_af, &rv_bc,
+                                      &rv_de, &rv_hl, &rv_ix, &rv_iy, &rv_sp}) {
+         regs_[{rv->reg(), rv->size()}] = rv;
+      }
+   }
+
+}
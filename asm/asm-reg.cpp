@@ -4,16 +4,17 @@
 
 namespace zc::z80 {
    
-   const ByteRegister r_a("a"), r_b("b"), r_c("c"), r_d("d"), r_e("e"), r_f("f"), r_h("h"),
-      r_l("l"), r_ixh("ixh"), r_ixl("ixl"), r_iyh("iyh"), r_iyl("iyl");
-
-   const MultibyteRegister r_af(MultibyteRegister::ByteRegs{&r_a, &r_f}, "af"),
-      r_bc(MultibyteRegister::ByteRegs{&r_b, &r_c}, "bc"),
-      r_de(MultibyteRegister::ByteRegs{&r_d, &r_e}, "de"),
-      r_hl(MultibyteRegister::ByteRegs{&r_h, &r_l}, "hl"),
-      r_ix(MultibyteRegister::ByteRegs{&r_ixh, &r_ixl}, "ix"),
-      r_iy(MultibyteRegister::ByteRegs{&r_iyh, &r_iyl}, "iy"),
-      r_sp(MultibyteRegister::ByteRegs{nullptr, nullptr}, "sp");
+   const ByteRegister r_a("a", REG_A), r_b("b", REG_B), r_c("c", REG_C), r_d("d", REG_D),
+      r_e("e", REG_E), r_f("f", REG_F), r_h("h", REG_H), r_l("l", REG_L), r_ixh("ixh", REG_IXH),
+      r_ixl("ixl", REG_IXL), r_iyh("iyh", REG_IYH), r_iyl("iyl", REG_IYL);
+
+   const MultibyteRegister r_af(MultibyteRegister::ByteRegs{&r_a, &r_f}, "af", mask_af),
+      r_bc(MultibyteRegister::ByteRegs{&r_b, &r_c}, "bc", mask_bc),
+      r_de(MultibyteRegister::ByteRegs{&r_d, &r_e}, "de", mask_de),
+      r_hl(MultibyteRegister::ByteRegs{&r_h, &r_l}, "hl", mask_hl),
+      r_ix(MultibyteRegister::ByteRegs{&r_ixh, &r_ixl}, "ix", mask_ix),
+      r_iy(MultibyteRegister::ByteRegs{&r_iyh, &r_iyl}, "iy", mask_iy),
+      r_sp(MultibyteRegister::ByteRegs{nullptr, nullptr}, "sp", 0);
 
    const RegisterValue rv_a(&r_a, byte_size),
       rv_b(&r_b),
@@ -35,29 +36,16 @@ namespace zc::z80 {
       rv_iy(&r_iy),
       rv_sp(&r_sp);
 
-   bool MultibyteRegister::contains(const Register *reg) const {
-      if (reg->kind() != Kind::REG_BYTE) {
-         return false;
-      }
-
-      const ByteRegister *byte_reg = dynamic_cast<const ByteRegister *>(reg);
-      return std::find(regs().begin(), regs().end(), byte_reg) != regs().end();
-   }
-
-   bool MultibyteRegister::Eq_aux(const MultibyteRegister *other) const {
-      for (auto it = regs().begin(), other_it = other->regs().begin(), end = regs().end();
-           it != end; ++it, ++other_it) {
-         if (*it == *other_it) { continue; }
-         if (*it == nullptr || *other_it == nullptr) { return false; }
-         if (!(*it)->Eq(*other_it)) {
-            return false;
-         }
-      }
-      return true;
+   const ByteRegister *byte_reg(RegIndex index) {
+      static const std::array<const ByteRegister *, REG_COUNT> byte_regs =
+         {&r_a, &r_b, &r_c, &r_d, &r_e, &r_f, &r_h, &r_l, &r_ixh, &r_ixl, &r_iyh, &r_iyl};
+      return byte_regs[index];
    }
 
    bool Register::Eq(const Register *other) const {
-      return strcmp(name(), other->name()) == 0 && size() == other->size() && Eq_(other);
+      return this == other ||
+         (mask() == other->mask() && kind() == other->kind() &&
+          strcmp(name(), other->name()) == 0);
    }
    
 }
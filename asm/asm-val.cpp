@@ -1,4 +1,5 @@
 #include <stdexcept>
+#include <cassert>
 
 #include "asm.hpp"
 #include "cgen.hpp"
@@ -34,8 +35,11 @@ namespace zc::z80 {
 
    void IndexedRegisterValue::Emit(std::ostream& os) const {
       val()->Emit(os);
-      os << "+";
-      os << (int) index(); 
+      if (index() < 0) {
+         os << "-" << -(int) index();
+      } else {
+         os << "+" << (int) index();
+      }
    }
 
    void FrameValue::Emit(std::ostream& os) const { os << (int) index(); }
@@ -54,44 +58,66 @@ namespace zc::z80 {
 
    /*** ADD ***/
    
-   Value *ImmediateValue::Add(const intmax_t& offset) const {
-      return new ImmediateValue(imm() + offset, size());
+   const Value *ImmediateValue::Add(const intmax_t& offset) const {
+      return value_pool().Imm(imm() + offset, size());
    }
 
-   Value *LabelValue::Add(const intmax_t& offset) const {
+   const Value *LabelValue::Add(const intmax_t& offset) const {
       return new OffsetValue(this, offset, size());
    }
 
-   Value *RegisterValue::Add(const intmax_t& offset) const {
-      return new IndexedRegisterValue(this, offset);
+   const Value *RegisterValue::Add(const intmax_t& offset) const {
+      return value_pool().Indexed(this, IndexedRegisterValue::Index(int8_t(offset)));
    }
 
-   Value *IndexedRegisterValue::Add(const intmax_t& offset) const {
-      return new IndexedRegisterValue(val(), index() + offset);
+   const Value *IndexedRegisterValue::Add(const intmax_t& offset) const {
+      return value_pool().Indexed(val(), IndexedRegisterValue::Index(int8_t(index() + offset)));
    }
 
-   Value *FrameValue::Add(const intmax_t& offset) const {
+   const Value *FrameValue::Add(const intmax_t& offset) const {
       if (offset > std::numeric_limits<int8_t>::max() ||
           offset < std::numeric_limits<int8_t>::min()) {
          throw std::logic_error("offset too large");
       }
-      return new FrameValue(indices_, indices_->insert(pos_, offset));
+      return value_pool().Frame(indices_, indices_->insert(pos_, offset));
    }
 
-   Value *OffsetValue::Add(const intmax_t& new_offset) const {
+   const Value *OffsetValue::Add(const intmax_t& new_offset) const {
       return new OffsetValue(base(), offset() + new_offset, size());
    }
 
-   Value *MemoryValue::Add(const intmax_t& offset) const {
+   const Value *MemoryValue::Add(const intmax_t& offset) const {
       throw std::logic_error("attempted to offset a memory value");
    }
 
-   MemoryValue *MemoryValue::Next(int next_size) const {
-      return new MemoryValue(addr()->Add(size()), next_size);
+   const MemoryValue *MemoryValue::Next(int next_size) const {
+      return value_pool().Mem(addr()->Add(size()), next_size);
+   }
+
+   const MemoryValue *MemoryValue::Prev(int next_size) const {
+      return value_pool().Mem(addr()->Add(-next_size), next_size);
    }
 
-   MemoryValue *MemoryValue::Prev(int next_size) const {
-      return new MemoryValue(addr()->Add(-next_size), next_size);
+   /*** BYTES ***/
+
+   const Value *ImmediateValue::high() const {
+      return value_pool().Imm((imm() & 0x00ff00) >> 8, byte_size);
+   }
+
+   const Value *ImmediateValue::low() const {
+      return value_pool().Imm((imm() & 0x0000ff), byte_size);
+   }
+
+   const Value *RegisterValue::high() const { return value_pool().Reg(reg()->high()); }
+   const Value *RegisterValue::low() const { return value_pool().Reg(reg()->low()); }
+
+   const Value *MemoryValue::high() const {
+      assert(size() == long_size);
+      return value_pool().Mem(addr()->Add(1), byte_size);
+   }
+
+   const Value *MemoryValue::low() const {
+      return value_pool().Mem(addr(), byte_size);
    }
 
 
@@ -215,6 +241,19 @@ namespace zc::z80 {
       return std::visit(IndexVisitor(), *index_);
    }
 
+   const Value *IndexedRegisterValue::Resolve() const {
+      return value_pool().Indexed(val(), Index(index()));
+   }
+
+   const Value *FrameValue::Resolve() const {
+      return value_pool().Imm(index(), byte_size);
+   }
+
+   const Value *MemoryValue::ReplaceVar(const VariableValue *var, const Value *with) const {
+      const Value *new_addr = addr()->ReplaceVar(var, with);
+      return new_addr == addr() ? this : value_pool().Mem(new_addr, size());
+   }
+
    const Value *ByteValue::Resolve() const {
       if (dynamic_cast<const VariableValue *>(all())) {
          return this;
@@ -73,6 +73,19 @@ namespace zc {
 
    int VarDeclaration::bytes() const { return type()->bytes(); }
 
+   bool VarDeclaration::is_reg_candidate() const {
+      if (addr_taken()) { return false; }
+
+      switch (type()->kind()) {
+      case ASTType::Kind::TYPE_INTEGRAL:
+      case ASTType::Kind::TYPE_POINTER:
+         return bytes() == z80::byte_size || bytes() == z80::word_size ||
+            bytes() == z80::long_size;
+      default:
+         return false;
+      }
+   }
+
    Symbol *ExternalDecl::sym() const {
       const auto var = dynamic_cast<const VarDeclaration *>(decl());
       return var ? var->sym() : nullptr;
@@ -176,9 +189,19 @@ namespace zc {
          return VarDeclaration::Create(declarator->sym(), false, type, loc());
       } else if (sc_size == 1) {
          StorageClassSpec *sc = storage_class_specs.front();
-         if (sc->kind() == StorageClassSpec::Kind::SC_TYPEDEF) {
+         switch (sc->kind()) {
+         case StorageClassSpec::Kind::SC_TYPEDEF:
             return TypenameDeclaration::Create(declarator->sym(), type, loc());
-         } else {
+
+         case StorageClassSpec::Kind::SC_STATIC:
+            {
+               VarDeclaration *decl = VarDeclaration::Create(declarator->sym(), false, type,
+                                                             loc());
+               decl->set_static();
+               return decl;
+            }
+
+         default:
             throw std::logic_error("unimplemented storage class spec");
          }
       } else {
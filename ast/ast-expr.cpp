@@ -310,10 +310,18 @@ namespace zc {
       for (auto it = this_subexprs.begin(), end = this_subexprs.end(),
               other_it = other_subexprs.begin();
            it != end; ++it, ++other_it) {
-         if (!(**it)->ExprEq(**other_it)) { return false; }
+         if (**it != **other_it && !(**it)->ExprEq(**other_it)) { return false; }
       }
       if (!type()->TypeEq(other->type())) { return false; }
       return true;
    }
+
+   std::size_t ASTExpr::ExprHash() {
+      std::size_t hash = typeid(*this).hash_code();
+      for (ASTExpr **subexpr : subexprs()) {
+         hash = hash_combine(hash, *subexpr);
+      }
+      return hash;
+   }
    
 }
@@ -1,4 +1,5 @@
 #include "ast.hpp"
+#include "asm.hpp"
 
 namespace zc {
 
@@ -24,6 +25,26 @@ namespace zc {
       os << "LabelDefStat '" << *label_id()->id() << "'";
    }
 
+   std::optional<intmax_t> SwitchStat::case_value(intmax_t val) const {
+      const IntegralType *int_type = expr()->type()->int_type();
+      if (int_type == nullptr) { return std::nullopt; }
+
+      const int bits = int_type->bytes() * 8;
+      const intmax_t modulus = static_cast<intmax_t>(1) << bits;
+      const intmax_t min = int_type->is_signed() ? -modulus / 2 : 0;
+      const intmax_t max = min + modulus - 1;
+      
+      /* narrower types are promoted to int, so out-of-range values never match */
+      if (int_type->bytes() < z80::long_size) {
+         if (val < min || val > max) { return std::nullopt; }
+         return val;
+      }
+
+      /* otherwise the case value is converted to the controlling type */
+      val &= modulus - 1;
+      return val > max ? val - modulus : val;
+   }
+
    void LabeledStat::DumpChildren(std::ostream& os, int level, bool with_types) const {
       stat()->Dump(os, level, with_types);
    }
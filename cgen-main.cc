@@ -41,8 +41,10 @@ limitations under the License.
 
 #include "ast.hpp"
 #include "cgen.hpp"
+#include "asm.hpp"
 #include "optim.hpp"
 #include "symtab.hpp"
+#include "pass-stats.hpp"
 
 // Lexer and parser associated variables
 extern int yy_flex_debug;                // Control Flex debugging (set to 1 to turn on)
@@ -62,10 +64,23 @@ namespace {
       std::cerr << "Usage: " << program << " [-Ah] [-O <optims>] [-p print_opts] [-o file]"
                 << std::endl;
    }
+
+   void dump_pass_stats() {
+      if (zc::g_print.time_passes || zc::g_print.mem_stats) {
+         zc::g_pass_stats.Dump(std::cerr);
+      }
+   }
 }
 
 zc::PrintOpts zc::g_print({{"peephole-stats", &PrintOpts::peephole_stats},
                            {"ralloc-info", &PrintOpts::ralloc_info},
+                           {"live-info", &PrintOpts::live_info},
+                           {"loop-info", &PrintOpts::loop_info},
+                           {"cost-stats", &PrintOpts::cost_stats},
+                           {"cost-report", &PrintOpts::cost_report},
+                           {"time-passes", &PrintOpts::time_passes},
+                           {"mem-stats", &PrintOpts::mem_stats},
+                           {"stats-json", &PrintOpts::stats_json},
    });
 
 int main(int argc, char *argv[]) {
@@ -130,25 +145,38 @@ int main(int argc, char *argv[]) {
      g_istream = &ifs;
   }
 
-  if (yyparse()) {
-     std::cout << "parsing failed; terminating..." << std::endl;
-     exit(1);
+  {
+     zc::PassStats::Timer timer(zc::g_pass_stats, "parse");
+     if (yyparse()) {
+        std::cout << "parsing failed; terminating..." << std::endl;
+        exit(1);
+     }
   }
 
-  Semant(g_AST_root);
+  {
+     zc::PassStats::Timer timer(zc::g_pass_stats, "semant");
+     Semant(g_AST_root);
+  }
 
   if (zc::g_semant_error.errors() > 0) {
      std::cerr << "Encountered semantic errors, exiting..." << std::endl;
      exit(0);
   }
 
-  if (stage == Stage::SEMANT) { exit(0); }  
+  if (stage == Stage::SEMANT) {
+     dump_pass_stats();
+     exit(0);
+  }  
 
   /* first optimization pass */
-  OptimizeAST(g_AST_root);
+  {
+     zc::PassStats::Timer timer(zc::g_pass_stats, "optimize-ast");
+     OptimizeAST(g_AST_root);
+  }
 
   /* DAG */
   if (zc::g_optim.DAG) {
+     zc::PassStats::Timer timer(zc::g_pass_stats, "dag");
      g_AST_root->DAG();
   }
 
@@ -170,6 +198,10 @@ int main(int argc, char *argv[]) {
   if (out_filename.empty()) {
      g_outpath = std::string("<stdout>");
      Cgen(g_AST_root, std::cout, g_outpath.c_str());
+     dump_pass_stats();
+     zc::z80::value_pool().Clear();
+     zc::ir_arena().Release();
+     zc::ast_arena().Release();
      exit(0);
   } 
   
@@ -182,6 +214,12 @@ int main(int argc, char *argv[]) {
 
   /* code generation: 1st pass (code gen) */
   Cgen(g_AST_root, output_stream, out_filename.c_str());
+  dump_pass_stats();
+
+  /* free translation unit in bulk */
+  zc::z80::value_pool().Clear();
+  zc::ir_arena().Release();
+  zc::ast_arena().Release();
   
   return 0;
 }
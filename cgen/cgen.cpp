@@ -1,3 +1,4 @@
+#include <limits>
 #include <numeric>
 #include <string>
 #include <unordered_set>
@@ -9,7 +10,11 @@
 #include "cgen.hpp"
 #include "ralloc.hpp"
 #include "emit.hpp"
+#include "alg/alg-live.hpp"
+#include "alg/alg-loop.hpp"
+#include "alg/alg-cost.hpp"
 #include "crt.hpp"
+#include "pass-stats.hpp"
 
 namespace zc {
 
@@ -21,23 +26,77 @@ namespace zc {
    void Cgen(TranslationUnit *root, std::ostream& os, const char *filename) {
       
       CgenEnv env;
-      root->CodeGen(env);
+      {
+         PassStats::Timer timer(g_pass_stats, "codegen");
+         root->CodeGen(env);
+      }
 
       // env.Serialize();
-      env.Resolve();
+      {
+         PassStats::Timer timer(g_pass_stats, "resolve");
+         env.Resolve();
+      }
+
+      if (g_optim.licm && g_optim.function_ralloc) {
+         PassStats::Timer timer(g_pass_stats, "licm");
+         for (FunctionImpl& impl : env.impls().impls()) {
+            HoistInvariants(impl);
+         }
+      }
+
+      if (g_print.loop_info) {
+         for (const FunctionImpl& impl : env.impls().impls()) {
+            alg::Loops(impl).Dump(std::cerr);
+         }
+      }
+
+      if (g_print.live_info) {
+         for (const FunctionImpl& impl : env.impls().impls()) {
+            alg::Liveness(impl).Dump(std::cerr);
+         }
+      }
 
       if (g_print.ralloc_info) {
          env.DumpAsm(std::cerr);
       }
       
-      RegisterAllocator::Ralloc(env);
+      {
+         PassStats::Timer timer(g_pass_stats, "ralloc");
+         RegisterAllocator::Ralloc(env);
+      }
       
       /* resolve */
-      env.Resolve();
+      {
+         PassStats::Timer timer(g_pass_stats, "resolve");
+         env.Resolve();
+      }
       
-      OptimizeIR(env);
+      {
+         PassStats::Timer timer(g_pass_stats, "optimize-ir");
+         OptimizeIR(env);
+      }
+
+      if (g_print.cost_stats) {
+         Cost cost;
+         for (const FunctionImpl& impl : env.impls().impls()) {
+            cost += impl.cost();
+         }
+         std::cerr << "cost-stats:" << std::endl
+                   << "BYTES\tCYCLES" << std::endl
+                   << cost.bytes << "\t" << cost.cycles << std::endl;
+      }
+
+      if (g_print.cost_report) {
+         std::cerr << "cost-report:" << std::endl;
+         for (const FunctionImpl& impl : env.impls().impls()) {
+            alg::CostReport(impl).Dump(std::cerr);
+         }
+      }
 
-      env.DumpAsm(os);
+      {
+         PassStats::Timer timer(g_pass_stats, "dump-asm");
+         env.DumpAsm(os);
+      }
    }
 
    FunctionImpl::FunctionImpl(CgenEnv& env, Block *entry, Block *fin):
@@ -49,11 +108,11 @@ namespace zc {
    }
 
    const FrameValue *StackFrame::saved_fp() {
-      return new FrameValue(sizes_, saved_fp_);
+      return value_pool().Frame(sizes_, saved_fp_);
    }
 
    const FrameValue *StackFrame::saved_ra() {
-      return new FrameValue(sizes_, saved_ra_);
+      return value_pool().Frame(sizes_, saved_ra_);
    }
    
    void CgenExtEnv::Enter(Symbol *sym, const VarDeclarations *args) {
@@ -84,7 +143,7 @@ namespace zc {
             addr_ = val_ = label_val;
       } else {
          addr_ = label_val;
-         val_ = new MemoryValue(label_val, type->bytes());
+         val_ = value_pool().Mem(label_val, type->bytes());
       }
    }
 
@@ -93,7 +152,7 @@ namespace zc {
           decl->type()->kind() == ASTType::Kind::TYPE_ARRAY) {
          val_ = addr;
       } else {
-         val_ = new MemoryValue(addr, decl->bytes());
+         val_ = value_pool().Mem(addr, decl->bytes());
       }
    }
    
@@ -147,9 +206,19 @@ namespace zc {
       /* initialize stack frame */
       FrameGen(env.ext_env().frame());
 
-      /* assign argument stack locations */
+      /* assign argument locations: registers are copied into promoted variables on entry */
+      const auto arg_regs = reg_call_args(dynamic_cast<const VarDeclaration *>(decl()));
+      Instructions arg_loads;
+      auto arg_reg_it = arg_regs.begin();
       for (const VarDeclaration *arg : *args) {
-         VarSymInfo *info = env.ext_env().frame().next_arg(arg);
+         VarSymInfo *info;
+         if (arg_regs.empty()) {
+            info = env.ext_env().frame().next_arg(arg);
+         } else {
+            auto var = new VariableValue(arg->bytes());
+            arg_loads.push_back(new LoadInstruction(var, *arg_reg_it++));
+            info = new VarSymInfo(nullptr, var, arg);
+         }
          env.symtab().AddToScope(arg->sym(), info);
       }
       
@@ -157,8 +226,12 @@ namespace zc {
       Block *ret_block = new Block(start_block->label()->Prepend("__frameunset"));
 
       /* emit prologue and epilogue */
+      const auto fn_decl = dynamic_cast<const VarDeclaration *>(decl());
+      int pop_bytes = (arg_regs.empty() && callee_pops(fn_decl)) ? args->size() * long_size : 0;
       emit_frameset(env, start_block);
-      emit_frameunset(env, ret_block);
+      emit_frameunset(env, ret_block, pop_bytes);
+      start_block->instrs().insert(start_block->instrs().end(), arg_loads.begin(),
+                                   arg_loads.end());
       
       Block *end_block = comp_stat()->CodeGen(env, start_block, false);
 
@@ -242,6 +315,33 @@ namespace zc {
       return join_block;
    }
 
+   Block *SwitchStat::CodeGen(CgenEnv& env, Block *block) {
+      const Value *var;
+      block = expr()->CodeGen(env, block, &var, ASTExpr::ExprKind::EXPR_RVALUE);
+
+      /* code preceding the first label is unreachable */
+      Label *body_label = new_label("switch_body");
+      Block *body_block = new Block(body_label);
+
+      Label *join_label = new_label("switch_join");
+      Block *join_block = new Block(join_label);
+
+      /* generate body first to collect case labels */
+      SwitchInfo *switch_info = new SwitchInfo(this, join_block);
+      env.stat_stack().Push(switch_info);
+      
+      Block *end_block = body()->CodeGen(env, body_block);
+      end_block->transitions().vec().push_back(new JumpTransition(join_block, Cond::ANY));
+
+      env.stat_stack().Pop();
+
+      Block *default_block = switch_info->default_block();
+      emit_switch(block, var, expr()->type()->int_type()->is_signed(), switch_info->cases(),
+                  default_block ? default_block : join_block);
+      
+      return join_block;
+   }
+
    Block *LoopStat::CodeGen(CgenEnv& env, Block *block) {
       Label *body_label = new_label("loop_body");
       Block *body_block = new Block(body_label);
@@ -290,6 +390,141 @@ namespace zc {
       return join_block;
    }
 
+   /**
+    * Convert integer as by assignment to integral type.
+    */
+   static intmax_t convert_int(intmax_t val, const IntegralType *type) {
+      if (type->int_kind() == IntegralType::IntKind::SPEC_BOOL) { return val != 0; }
+      const intmax_t modulus = static_cast<intmax_t>(1) << (type->bytes() * 8);
+      val &= modulus - 1;
+      return type->is_signed() && val >= modulus / 2 ? val - modulus : val;
+   }
+
+   /**
+    * Evaluate expression built from integer literals, integral casts, and a loop counter.
+    * @param var loop counter; nullptr if expression may not refer to it
+    * @param var_val current value of loop counter
+    * @return whether expression could be evaluated
+    */
+   static bool eval_counted(const CgenEnv& env, ASTExpr *expr, const VariableValue *var,
+                            intmax_t var_val, intmax_t& out) {
+      if (auto lit = dynamic_cast<LiteralExpr *>(expr)) {
+         out = lit->val();
+         return true;
+      }
+
+      if (auto id = dynamic_cast<IdentifierExpr *>(expr)) {
+         out = var_val;
+         return var && id->val_var(env) == var;
+      }
+
+      if (auto cast = dynamic_cast<CastExpr *>(expr)) {
+         const IntegralType *type = cast->type()->int_type();
+         if (cast->type()->kind() != ASTType::Kind::TYPE_INTEGRAL ||
+             !eval_counted(env, cast->expr(), var, var_val, out)) {
+            return false;
+         }
+         out = convert_int(out, type);
+         return true;
+      }
+
+      return false;
+   }
+
+   /**
+    * Compute trip count of a loop of the form
+    *    for (<var> = <const>; <var> <relop> <const>; ++<var>)
+    * where <var> is a promoted local, stepping up or down by one. The caller must check that the
+    * body doesn't assign <var>.
+    * @param var output loop counter
+    * @return number of iterations; 0 if not a counted loop or if it runs more than 256 times
+    */
+   static int trip_count(const CgenEnv& env, ForStat *stat, const VariableValue *& var) {
+      /* step */
+      auto step = dynamic_cast<UnaryExpr *>(stat->after());
+      auto step_id = step ? dynamic_cast<IdentifierExpr *>(step->expr()) : nullptr;
+      if (step_id == nullptr || step_id->type()->kind() != ASTType::Kind::TYPE_INTEGRAL) {
+         return 0;
+      }
+      const IntegralType *type = step_id->type()->int_type();
+      int delta;
+      switch (step->kind()) {
+      case UnaryExpr::Kind::UOP_INC_PRE:
+      case UnaryExpr::Kind::UOP_INC_POST:
+         delta = 1;
+         break;
+      case UnaryExpr::Kind::UOP_DEC_PRE:
+      case UnaryExpr::Kind::UOP_DEC_POST:
+         delta = -1;
+         break;
+      default: return 0;
+      }
+      if ((var = step_id->val_var(env)) == nullptr) { return 0; }
+
+      /* initial value */
+      auto init = dynamic_cast<AssignmentExpr *>(stat->init());
+      auto init_id = init ? dynamic_cast<IdentifierExpr *>(init->lhs()) : nullptr;
+      intmax_t val;
+      if (init_id == nullptr || init_id->val_var(env) != var ||
+          !eval_counted(env, init->rhs(), nullptr, 0, val)) {
+         return 0;
+      }
+      val = convert_int(val, type);
+
+      /* comparison against constant; the boolean conversion of its result is irrelevant */
+      ASTExpr *pred = stat->pred();
+      while (auto cast = dynamic_cast<CastExpr *>(pred)) { pred = cast->expr(); }
+      auto cmp = dynamic_cast<BinaryExpr *>(pred);
+      if (cmp == nullptr) { return 0; }
+
+      /* simulate */
+      for (int trips = 0; trips <= 256; ++trips) {
+         intmax_t lhs, rhs;
+         if (!eval_counted(env, cmp->lhs(), var, val, lhs) ||
+             !eval_counted(env, cmp->rhs(), var, val, rhs)) {
+            return 0;
+         }
+
+         bool taken;
+         switch (cmp->kind()) {
+         case BinaryExpr::Kind::BOP_EQ:  taken = lhs == rhs; break;
+         case BinaryExpr::Kind::BOP_NEQ: taken = lhs != rhs; break;
+         case BinaryExpr::Kind::BOP_LT:  taken = lhs <  rhs; break;
+         case BinaryExpr::Kind::BOP_LEQ: taken = lhs <= rhs; break;
+         case BinaryExpr::Kind::BOP_GT:  taken = lhs >  rhs; break;
+         case BinaryExpr::Kind::BOP_GEQ: taken = lhs >= rhs; break;
+         default: return 0;
+         }
+         if (!taken) { return trips; }
+
+         val = convert_int(val + delta, type);
+      }
+
+      return 0;
+   }
+
+   /**
+    * Check whether loop body may be counted down in a register: it must not assign the loop
+    * counter, and it must not be entered other than at the top (i.e. via goto or case labels).
+    * @param body entry block of body
+    * @param exits blocks that leave the body (continue and break targets)
+    */
+   static bool countable_body(Block *body, Blocks exits, const VariableValue *var) {
+      bool countable = true;
+      body->for_each_block(exits, [&](Block *block) {
+         if (block->label()->name().rfind("__LABEL_", 0) != 0) { countable = false; }
+         for (const Instruction *instr : block->instrs()) {
+            alg::ValueSet kills;
+            instr->Kill(std::inserter(kills, kills.begin()));
+            for (const Value *kill : kills) {
+               if (auto byte = dynamic_cast<const ByteValue *>(kill)) { kill = byte->all(); }
+               countable &= !kill->Eq(var);
+            }
+         }
+      });
+      return countable;
+   }
+   
    Block *ForStat::CodeGen(CgenEnv& env, Block *block) {
       Label *cond_label = new_label("for_cond");
       Block *cond_block = new Block(cond_label);
@@ -307,18 +542,55 @@ namespace zc {
       Block *join_block = new Block(join_label);
       // BlockTransition *join_trans = new JumpTransition(join_block, Cond::ANY);
 
+      /* case labels in the body would enter the loop without loading the counter */
+      auto switch_info = static_cast<SwitchInfo *>
+         (env.stat_stack().Find([](auto info) {
+                                   return dynamic_cast<SwitchStat *>(info->stat()) != nullptr;
+                                }));
+      std::size_t ncases = switch_info ? switch_info->cases().size() : 0;
+      Block *default_block = switch_info ? switch_info->default_block() : nullptr;
+
       StatInfo *stat_info = new StatInfo(this, after_block, join_block);
       env.stat_stack().Push(stat_info);
       
       block = init()->CodeGen(env, block, nullptr, ASTExpr::ExprKind::EXPR_RVALUE);
-      block->transitions().vec().push_back(cond_trans);
 
-      emit_predicate(env, cond_block, pred(), body_block, join_block);
-      
-      block = body()->CodeGen(env, body_block);
-      block->transitions().vec().push_back(after_trans);
-      block = after()->CodeGen(env, after_block, nullptr, ASTExpr::ExprKind::EXPR_RVALUE);
-      block->transitions().vec().push_back(cond_trans);
+      Block *body_end = body()->CodeGen(env, body_block);
+      body_end->transitions().vec().push_back(after_trans);
+
+      const VariableValue *var;
+      int trips = g_optim.counted_loops ? trip_count(env, this, var) : 0;
+      if (trips > 0 &&
+          (switch_info == nullptr || (switch_info->cases().size() == ncases &&
+                                      switch_info->default_block() == default_block)) &&
+          countable_body(body_block, {after_block, join_block}, var)) {
+         /* counted loop; the predicate holds on entry and the counter is loaded through b so
+          * that it is allocated there, which later lets the loop close with djnz:
+          *    ld b,<trips>    ; 0 for 256 trips
+          *    ld <cnt>,b
+          * body:
+          *    ...
+          * after:
+          *    <after>
+          *    dec <cnt>
+          *    jp nz,body
+          */
+         const VariableValue *cnt = new VariableValue(byte_size);
+         block->instrs().push_back(new LoadInstruction(&rv_b, value_pool().Imm(trips & 0xff,
+                                                                                byte_size)));
+         block->instrs().push_back(new LoadInstruction(cnt, &rv_b));
+         block->transitions().vec().push_back(new JumpTransition(body_block, Cond::ANY));
+
+         block = after()->CodeGen(env, after_block, nullptr, ASTExpr::ExprKind::EXPR_RVALUE);
+         block->instrs().push_back(new DecInstruction(cnt));
+         block->transitions().vec().push_back(new JumpTransition(body_block, Cond::NZ));
+         block->transitions().vec().push_back(new JumpTransition(join_block, Cond::ANY));
+      } else {
+         block->transitions().vec().push_back(cond_trans);
+         emit_predicate(env, cond_block, pred(), body_block, join_block);
+         block = after()->CodeGen(env, after_block, nullptr, ASTExpr::ExprKind::EXPR_RVALUE);
+         block->transitions().vec().push_back(cond_trans);
+      }
       
       env.stat_stack().Pop();
       
@@ -332,7 +604,9 @@ namespace zc {
    }
 
    Block *ContinueStat::CodeGen(CgenEnv& env, Block *block) {
-      StatInfo *stat_info = env.stat_stack().Find([](auto info){return info->stat()->can_break(); });
+      StatInfo *stat_info = env.stat_stack().Find([](auto info){
+                                                     return info->stat()->can_continue();
+                                                  });
       block->transitions().vec().push_back(new JumpTransition(stat_info->enter(), Cond::ANY));
       return &dead_block;
    }
@@ -361,6 +635,42 @@ namespace zc {
       return LabeledStat::CodeGen(env, block);
    }
 
+   /**
+    * Find info of innermost switch statement enclosing case label.
+    */
+   static SwitchInfo *enclosing_switch(CgenEnv& env) {
+      return static_cast<SwitchInfo *>
+         (env.stat_stack().Find([](auto info) {
+                                   return dynamic_cast<SwitchStat *>(info->stat()) != nullptr;
+                                }));
+   }
+
+   Block *CaseStat::CodeGen(CgenEnv& env, Block *block) {
+      SwitchInfo *switch_info = enclosing_switch(env);
+
+      /* fall through from preceding statements */
+      Block *case_block = new Block(new_label("switch_case"));
+      block->transitions().vec().push_back(new JumpTransition(case_block, Cond::ANY));
+
+      /* values the controlling expression can't take are only reached by falling through */
+      std::optional<intmax_t> case_val = switch_info->switch_stat()->case_value(val()->int_const());
+      if (case_val) {
+         switch_info->cases().push_back({*case_val, case_block});
+      }
+      
+      return LabeledStat::CodeGen(env, case_block);
+   }
+
+   Block *DefaultStat::CodeGen(CgenEnv& env, Block *block) {
+      SwitchInfo *switch_info = enclosing_switch(env);
+
+      Block *default_block = new Block(new_label("switch_default"));
+      block->transitions().vec().push_back(new JumpTransition(default_block, Cond::ANY));
+      switch_info->default_block(default_block);
+
+      return LabeledStat::CodeGen(env, default_block);
+   }
+
    Block *AssignmentExpr::CodeGen(CgenEnv& env, Block *block, const Value **out,
                                   ExprKind mode) {
       assert(mode == ExprKind::EXPR_RVALUE);
@@ -369,13 +679,31 @@ namespace zc {
       const Value *lhs_lval, *rhs_rval;
       block = rhs()->CodeGen(env, block, &rhs_rval, ExprKind::EXPR_RVALUE);
 
-      /* compute left-hand lvalue */
-      block = lhs()->CodeGen(env, block, &lhs_lval, ExprKind::EXPR_LVALUE);
+      auto lhs_id = dynamic_cast<IdentifierExpr *>(lhs());
+      const VariableValue *lhs_var = lhs_id ? lhs_id->val_var(env) : nullptr;
+      if (lhs_var) {
+         /* assign directly to promoted local */
+         block->instrs().push_back(new LoadInstruction(lhs_var, rhs_rval));
+      } else {
+         /* compute left-hand lvalue */
+         block = lhs()->CodeGen(env, block, &lhs_lval, ExprKind::EXPR_LVALUE);
       
-      /* assign */
-      block->instrs().push_back(new LoadInstruction(&rv_hl, lhs_lval));
-      const MemoryValue *memval = new MemoryValue(&rv_hl, type()->bytes());
-      block->instrs().push_back(new LoadInstruction(memval, rhs_rval));
+         /* assign */
+         if (type()->bytes() == word_size) {
+            /* ld <tmp>,<rhs>
+             * ld hl,<lhs>
+             * ld (hl),low(<tmp>) \ inc hl \ ld (hl),high(<tmp>)
+             */
+            const Value *tmp = new VariableValue(word_size, true);
+            block->instrs().push_back(new LoadInstruction(tmp, rhs_rval));
+            block->instrs().push_back(new LoadInstruction(&rv_hl, lhs_lval));
+            emit_store_word(block, tmp);
+         } else {
+            block->instrs().push_back(new LoadInstruction(&rv_hl, lhs_lval));
+            const MemoryValue *memval = value_pool().Mem(&rv_hl, type()->bytes());
+            block->instrs().push_back(new LoadInstruction(memval, rhs_rval));
+         }
+      }
 
       /* propogate result */
       if (out) {
@@ -408,7 +736,7 @@ namespace zc {
             block->instrs().push_back(new LoadInstruction(&rv_hl, var));
             *out = new VariableValue(type()->bytes());
             block->instrs().push_back
-               (new LoadInstruction(*out, new MemoryValue(&rv_hl, type()->bytes())));
+               (new LoadInstruction(*out, value_pool().Mem(&rv_hl, type()->bytes())));
             break;
          }
          break;
@@ -426,7 +754,7 @@ namespace zc {
             const RegisterValue *reg;
             switch (bytes) {
             case byte_size: reg = &rv_a; break;
-            case word_size: abort();
+            case word_size:
             case long_size: reg = crt_arg1(bytes); break;
             default:        abort();
             }
@@ -440,10 +768,10 @@ namespace zc {
                /* neg */
                block->instrs().push_back(new NegInstruction());
                break;
-            case word_size: abort();
+            case word_size:
             case long_size:
-               /* call __ineg */
-               emit_crt("__ineg", block);
+               /* call __sneg/__ineg */
+               emit_crt(crt_prefix(bytes) + "neg", block);
                break;
             default: abort();
             }
@@ -460,7 +788,7 @@ namespace zc {
             const RegisterValue *reg;
             switch (bytes) {
             case byte_size: reg = &rv_a; break;
-            case word_size: abort();
+            case word_size:
             case long_size: reg = crt_arg1(bytes); break;
             default:        abort();
             }
@@ -474,10 +802,10 @@ namespace zc {
                /* cpl */
                block->instrs().push_back(new CplInstruction());
                break;
-            case word_size: abort();
+            case word_size:
             case long_size:
-               /* call __inot */
-               emit_crt("__inot", block);
+               /* call __snot/__inot */
+               emit_crt(crt_prefix(bytes) + "not", block);
                break;
             default: abort();
             }
@@ -571,7 +899,21 @@ namespace zc {
                block->instrs().push_back(new CompInstruction(&rv_a, rhs_var));
                break;
 
-            case word_size: abort();
+            case word_size:
+               /* ld hl,<lhs>
+                * or a,a
+                * sbc hl,<rhs>
+                * ld a,h
+                * or a,l
+                * NOTE: Only the low 16 bits of the difference are significant.
+                */
+               block->instrs().push_back(new LoadInstruction(&rv_hl, lhs_var));
+               block->instrs().push_back(new OrInstruction(&rv_a, &rv_a));
+               block->instrs().push_back(new SbcInstruction(&rv_hl, rhs_var));
+               block->instrs().push_back(new LoadInstruction(&rv_a, &rv_h));
+               block->instrs().push_back(new OrInstruction(&rv_a, &rv_l));
+               break;
+               
             case long_size:
                /* ld hl,<lhs>
                 * or a,a
@@ -626,7 +968,24 @@ namespace zc {
                block->instrs().push_back(new CompInstruction(&rv_a, rev_vars ? rhs_var : lhs_var));
                break;
                                   
-            case word_size: abort();
+            case word_size:
+               /* ld hl,<lhs>/<rhs>
+                * ld bc,<rhs>/<lhs>
+                * ld a,l
+                * sub a,c
+                * ld a,h
+                * sbc a,b
+                * NOTE: The upper bytes of word registers are undefined, so the borrow and sign
+                *       are taken from a bytewise 16-bit subtraction.
+                */
+               block->instrs().push_back(new LoadInstruction(&rv_hl, rev_vars ? lhs_var : rhs_var));
+               block->instrs().push_back(new LoadInstruction(&rv_bc, rev_vars ? rhs_var : lhs_var));
+               block->instrs().push_back(new LoadInstruction(&rv_a, &rv_l));
+               block->instrs().push_back(new SubInstruction(&rv_a, &rv_c));
+               block->instrs().push_back(new LoadInstruction(&rv_a, &rv_h));
+               block->instrs().push_back(new SbcInstruction(&rv_a, &rv_b));
+               break;
+               
             case long_size:
                /* ld hl,<lhs>
                 * or a,a
@@ -683,7 +1042,7 @@ namespace zc {
             block->instrs().push_back(new SubInstruction(&rv_a, rhs_var));
             break;
             
-         case word_size: abort();
+         case word_size:
          case long_size:
             /* or a,a
              * ld hl,<lhs>
@@ -704,6 +1063,20 @@ namespace zc {
          break;
 
       case Kind::BOP_TIMES:
+         if (g_optim.strength_reduce && (lhs()->is_const() || rhs()->is_const())) {
+            /* strength-reduce multiplication by constant */
+            ASTExpr *factor = rhs()->is_const() ? rhs() : lhs();
+            ASTExpr *multiplicand = (factor == rhs()) ? lhs() : rhs();
+            bool is_signed = lhs()->type()->int_type()->is_signed();
+            block = multiplicand->CodeGen(env, block, &lhs_var, ExprKind::EXPR_RVALUE);
+            emit_mul_const(block, lhs_var, factor->int_const(), is_signed);
+            if (out) {
+               *out = new VariableValue(lhs_var->size());
+               block->instrs().push_back(new LoadInstruction(*out, accumulator(lhs_var)));
+            }
+            break;
+         }
+         
          block = emit_binop(env, block, this, &lhs_var, &rhs_var);
          switch (lhs_var->size()) {
          case byte_size:
@@ -727,20 +1100,20 @@ namespace zc {
             }
             break;
             
-         case word_size: abort();
+         case word_size:
          case long_size:
             /* ld hl,<lhs>
              * ld bc,<rhs>
-             * call __imulu
+             * call __smulu/__imulu
              * ld <out>,hl
              */
             {
                bool is_signed = lhs()->type()->int_type()->is_signed();
                block->instrs().push_back(new LoadInstruction(&rv_hl, lhs_var));
                block->instrs().push_back(new LoadInstruction(&rv_bc, rhs_var));
-               emit_crt("__imul" + crt_suffix(is_signed), block);
+               emit_crt(crt_prefix(lhs_var) + "mul" + crt_suffix(is_signed), block);
                if (out) {
-                  *out = new VariableValue(long_size);
+                  *out = new VariableValue(lhs_var->size());
                   block->instrs().push_back(new LoadInstruction(*out, &rv_hl));
                }
             }
@@ -753,7 +1126,17 @@ namespace zc {
          {
             bool div_not_mod = (kind() == Kind::BOP_DIVIDE);
             bool is_signed = lhs()->type()->int_type()->is_signed();
-            block = emit_binop(env, block, this, &lhs_var, &rhs_var);
+            block = lhs()->CodeGen(env, block, &lhs_var, ExprKind::EXPR_RVALUE);
+            if (g_optim.strength_reduce && rhs()->is_const() &&
+                emit_div_const(block, lhs_var, rhs()->int_const(), is_signed, div_not_mod)) {
+               if (out) {
+                  *out = new VariableValue(lhs_var->size());
+                  block->instrs().push_back(new LoadInstruction(*out, accumulator(lhs_var)));
+               }
+               break;
+            }
+            
+            block = rhs()->CodeGen(env, block, &rhs_var, ExprKind::EXPR_RVALUE);
             block->instrs().push_back(new LoadInstruction(crt_arg1(lhs_var), lhs_var));
             block->instrs().push_back(new LoadInstruction(crt_arg2(rhs_var), rhs_var));
             emit_crt(crt_prefix(lhs_var) + "div" + crt_suffix(is_signed), block);
@@ -794,23 +1177,23 @@ namespace zc {
             }
             break;
             
-         case word_size: abort();
+         case word_size:
          case long_size:
             /* ld hl,<lhs>
              * ld bc,<rhs>
-             * call __iand/__ior/__ixor
+             * call __sand/__sor/__sxor (word) or __iand/__ior/__ixor (long)
              * ld <out>,hl
              */
             block->instrs().push_back(new LoadInstruction(&rv_hl, lhs_var));
             block->instrs().push_back(new LoadInstruction(&rv_bc, rhs_var));
             switch (kind()) {
-            case Kind::BOP_BITWISE_AND: emit_crt("__iand", block); break;
-            case Kind::BOP_BITWISE_OR:  emit_crt("__ior", block);  break;
-            case Kind::BOP_BITWISE_XOR: emit_crt("__ixor", block); break;
+            case Kind::BOP_BITWISE_AND: emit_crt(crt_prefix(lhs_var) + "and", block); break;
+            case Kind::BOP_BITWISE_OR:  emit_crt(crt_prefix(lhs_var) + "or", block);  break;
+            case Kind::BOP_BITWISE_XOR: emit_crt(crt_prefix(lhs_var) + "xor", block); break;
             default: abort();
             }
             if (out) {
-               *out = new VariableValue(long_size);
+               *out = new VariableValue(lhs_var->size());
                block->instrs().push_back(new LoadInstruction(*out, &rv_hl));
             }
             break;
@@ -828,7 +1211,7 @@ namespace zc {
    
    Block *LiteralExpr::CodeGen(CgenEnv& env, Block *block, const Value **out,
                                ExprKind mode) {
-      const ImmediateValue *imm = new ImmediateValue(val(), type()->bytes());
+      const ImmediateValue *imm = value_pool().Imm(val(), type()->bytes());
       if (out) {
          *out = new VariableValue(imm->size());
          block->instrs().push_back(new LoadInstruction(*out, imm));
@@ -855,6 +1238,7 @@ namespace zc {
       if (mode == ExprKind::EXPR_LVALUE || type()->kind() == ASTType::Kind::TYPE_ARRAY) {
          /* obtain address of identifier */
          const Value *id_addr = dynamic_cast<const VarSymInfo *>(id_info)->addr();
+         assert(id_addr); /* promoted locals are never address-taken */
          *out = new VariableValue(id_addr->size());
          block->instrs().push_back(new LeaInstruction(*out, id_addr));
       } else {
@@ -867,6 +1251,43 @@ namespace zc {
    }
 
    Block *CallExpr::CodeGen(CgenEnv& env, Block *block, const Value **out, ExprKind mode) {
+      auto fn_id = dynamic_cast<IdentifierExpr *>(fn());
+      std::vector<const RegisterValue *> arg_regs;
+      if (fn_id) {
+         arg_regs = reg_call_args(fn_id->decl());
+      }
+      if (!arg_regs.empty()) {
+         /* register calling convention:
+          * ld <arg>,<param>     ; for each param, in order
+          * ld hl/de/bc/a,<arg>  ; for each arg
+          * call <fn>
+          */
+         std::vector<const Value *> arg_vars;
+         for (ASTExpr *param : *params()) {
+            const Value *param_var;
+            block = param->CodeGen(env, block, &param_var, ExprKind::EXPR_RVALUE);
+            const Value *arg_var = new VariableValue(param_var->size());
+            block->instrs().push_back(new LoadInstruction(arg_var, param_var));
+            arg_vars.push_back(arg_var);
+         }
+
+         RegMask arg_mask = 0;
+         for (std::size_t i = 0; i < arg_vars.size(); ++i) {
+            block->instrs().push_back(new LoadInstruction(arg_regs[i], arg_vars[i]));
+            arg_mask |= arg_regs[i]->reg()->mask();
+         }
+         const Value *target = fn()->val_const(env);
+         block->instrs().push_back(new CallInstruction(target, arg_mask));
+
+         if (out) {
+            int ret_bytes = type()->bytes();
+            *out = new VariableValue(ret_bytes);
+            block->instrs().push_back(new LoadInstruction(*out, accumulator(ret_bytes)));
+         }
+         
+         return block;
+      }
+      
       /* codegen params */
       for (auto it = params()->rbegin(), end = params()->rend(); it != end; ++it) {
          auto param = *it;
@@ -881,8 +1302,9 @@ namespace zc {
             block->instrs().push_back(new LoadInstruction(&rv_a, param_var));
             push_src = &rv_af;
             break;
-         case word_size: abort();
+         case word_size:
          case long_size:
+            /* words are pushed as 3 bytes; the callee ignores the upper byte */
             push_src = param_var;
             break;
          }
@@ -903,10 +1325,9 @@ namespace zc {
          emit_crt("__indcall", block);
       }
       
-      /* pop off args */
-      for (ASTExpr *param : *params()) {
-         /* TODO: this could be optimized. */
-         block->instrs().push_back(new PopInstruction(&rv_de)); /* pop off into scrap register */
+      /* pop off args, unless callee does; each occupies a 3-byte slot */
+      if (!(fn_id && callee_pops(fn_id->decl()))) {
+         emit_stack_cleanup(block, params()->size() * long_size, &rv_de, &rv_iy);
       }
 
       /* load result */
@@ -927,8 +1348,6 @@ namespace zc {
       bool expr_signed = expr()->type()->Decay()->int_type()->is_signed();
       bool out_signed = type()->Decay()->int_type()->is_signed();
 
-      assert(expr_bytes != word_size && out_bytes != word_size);
-
       if (expr_bytes == out_bytes) {
          /* NOTE: Can ignore sign due to how two's complement works. */
          return expr()->CodeGen(env, block, out, mode);
@@ -953,7 +1372,7 @@ namespace zc {
                emit_booleanize_flag_byte(env, block, dynamic_cast<const FlagValue *>(var), out);
                break;
                
-            case word_size: abort();
+            case word_size:
             case long_size:
                {
                   *out = new VariableValue(out_bytes);            
@@ -965,11 +1384,16 @@ namespace zc {
          }
          break;
 
-      case word_size: abort();
+      case word_size:
       case long_size:
          switch (expr_bytes) {
          case flag_size:
             emit_booleanize_flag_long(env, block, dynamic_cast<const FlagValue *>(var), out);
+            if (out_bytes == word_size) {
+               const Value *wide = *out;
+               *out = new VariableValue(out_bytes);
+               block->instrs().push_back(new LoadInstruction(*out, wide));
+            }
             break;
          case byte_size:
             {
@@ -997,7 +1421,21 @@ namespace zc {
                block->instrs().push_back(new LoadInstruction(*out, &rv_hl));
             }
             break;
-         case word_size: abort();            
+         case word_size:
+            /* ld hl,<var>
+             * call __stoi/__stoiu
+             * ld <out>,hl
+             */
+            *out = new VariableValue(out_bytes);
+            block->instrs().push_back(new LoadInstruction(&rv_hl, var));
+            emit_crt(expr_signed ? "__stoi" : "__stoiu", block);
+            block->instrs().push_back(new LoadInstruction(*out, &rv_hl));
+            break;
+         case long_size:
+            /* truncate to word: the upper byte of a word register is ignored */
+            *out = new VariableValue(out_bytes);
+            block->instrs().push_back(new LoadInstruction(*out, var));
+            break;
          default: abort();
          }
          break;
@@ -1016,7 +1454,7 @@ namespace zc {
       
       /* get internal offset */
       int offset = dynamic_cast<CompoundType *>(expr()->type())->offset(memb());
-      ImmediateValue *imm = new ImmediateValue(offset, long_size);
+      const ImmediateValue *imm = value_pool().Imm(offset, long_size);
 
       const Value *offset_var = new VariableValue(long_size);
       /* ld <off>,#off
@@ -1035,7 +1473,7 @@ namespace zc {
       case ExprKind::EXPR_RVALUE:
          /* ld <out>,(hl) */
          block->instrs().push_back
-            (new LoadInstruction(*out, new MemoryValue(&rv_hl, type()->bytes())));
+            (new LoadInstruction(*out, value_pool().Mem(&rv_hl, type()->bytes())));
          break;
 
       case ExprKind::EXPR_NONE: abort();
@@ -1055,7 +1493,7 @@ namespace zc {
       };
 
       int imm = std::visit(CodeGenVisitor(), variant_);
-      block->instrs().push_back(new LoadInstruction(*out, new ImmediateValue(imm, (*out)->size())));
+      block->instrs().push_back(new LoadInstruction(*out, value_pool().Imm(imm, (*out)->size())));
       
       return block;
    }
@@ -1072,10 +1510,14 @@ namespace zc {
 
       if (out == nullptr) { return block; }
 
-      block->instrs().push_back(new LoadInstruction(&rv_hl, index_var));
-      block->instrs().push_back
-         (new LoadInstruction(&rv_bc, new ImmediateValue(type()->bytes(), long_size)));
-      emit_crt("__imuls", block);
+      if (g_optim.strength_reduce) {
+         emit_mul_const(block, index_var, type()->bytes(), true);
+      } else {
+         block->instrs().push_back(new LoadInstruction(&rv_hl, index_var));
+         block->instrs().push_back
+            (new LoadInstruction(&rv_bc, value_pool().Imm(type()->bytes(), long_size)));
+         emit_crt("__imuls", block);
+      }
       block->instrs().push_back(new AddInstruction(&rv_hl, base_var));
 
       switch (mode) {
@@ -1087,7 +1529,7 @@ namespace zc {
       case ExprKind::EXPR_RVALUE:
          *out = new VariableValue(type()->bytes());
          block->instrs().push_back
-            (new LoadInstruction(*out, new MemoryValue(&rv_hl, type()->bytes())));
+            (new LoadInstruction(*out, value_pool().Mem(&rv_hl, type()->bytes())));
          break;
          
       case ExprKind::EXPR_NONE: abort();
@@ -1122,11 +1564,56 @@ namespace zc {
    }
 
 
+   /**
+    * Whether every call to function is a direct call generated by zc, so the function may use
+    * a calling convention of its own. Functions with external linkage, and main, may also be
+    * called by code zc did not compile.
+    */
+   static bool only_called_directly(const VarDeclaration *fn) {
+      return g_optim.direct_call && fn->is_defined() && fn->is_static() && !fn->addr_taken() &&
+         *fn->sym() != "main";
+   }
+
+   bool callee_pops(const VarDeclaration *fn) {
+      return g_optim.callee_pop && only_called_directly(fn);
+   }
+
+   std::vector<const RegisterValue *> reg_call_args(const VarDeclaration *fn) {
+      /* argument registers are live across blocks, which only function ralloc handles */
+      if (!g_optim.reg_call || !g_optim.function_ralloc || !only_called_directly(fn)) {
+         return {};
+      }
+
+      /* multibyte args take hl, de, bc in order; one byte arg takes a */
+      std::vector<const RegisterValue *> regs;
+      const std::array<const RegisterValue *, 3> pairs = {&rv_hl, &rv_de, &rv_bc};
+      auto pair_it = pairs.begin();
+      bool a_free = true;
+      for (const VarDeclaration *param : *fn->type()->get_callable()->params()) {
+         if (!param->is_reg_candidate()) { return {}; }
+         switch (param->bytes()) {
+         case byte_size:
+            if (!a_free) { return {}; }
+            regs.push_back(&rv_a);
+            a_free = false;
+            break;
+         case word_size:
+         case long_size:
+            if (pair_it == pairs.end()) { return {}; }
+            regs.push_back(*pair_it++);
+            break;
+         default: return {};
+         }
+      }
+      
+      return regs;
+   }
+
    const RegisterValue *accumulator(const Value *val) { return accumulator(val->size()); }
    const RegisterValue *accumulator(int bytes) {
       switch (bytes) {
       case byte_size: return &rv_a;
-      case word_size: abort();
+      case word_size: return &rv_hl;
       case long_size: return &rv_hl;
       default:        abort();
       }
@@ -1149,8 +1636,8 @@ namespace zc {
          {
             const MultibyteRegister *from_mb = dynamic_cast<const MultibyteRegister *>(from);
             const ByteRegister *from_lsb = from_mb->regs().back();
-            const RegisterValue *from_rv = new RegisterValue(from_lsb);
-            block->instrs().push_back(new LoadInstruction(new RegisterValue(this), from_rv));
+            const RegisterValue *from_rv = value_pool().Reg(from_lsb);
+            block->instrs().push_back(new LoadInstruction(value_pool().Reg(this), from_rv));
          }
          break;
       }
@@ -1162,9 +1649,9 @@ namespace zc {
          /* ensure long register being cast to does not contain given register. */
          assert(!contains(from));
 
-         block->instrs().push_back(new LoadInstruction(new RegisterValue(this), &imm_l<0>));
-         block->instrs().push_back(new LoadInstruction(new RegisterValue(regs()[1]),
-                                                       new RegisterValue(from)));
+         block->instrs().push_back(new LoadInstruction(value_pool().Reg(this), &imm_l<0>));
+         block->instrs().push_back(new LoadInstruction(value_pool().Reg(regs()[1]),
+                                                       value_pool().Reg(from)));
 
          break;
          
@@ -1212,6 +1699,33 @@ namespace zc {
       fin()->for_each_block(visited, fn, *instrs_, visited);
    }
 
+   void FunctionImpl::Deserialize() {
+      /* map labels to blocks and note which jumps belong to blocks rather than transitions */
+      std::unordered_map<std::string, Block *> blocks;
+      std::unordered_set<const Instruction *> block_instrs;
+      Blocks visited;
+      auto fn = [&](Block *block) {
+                   blocks[block->label()->name()] = block;
+                   block_instrs.insert(block->instrs().begin(), block->instrs().end());
+                };
+      entry()->for_each_block(visited, fn);
+      fin()->for_each_block(visited, fn);
+
+      Block *block = nullptr;
+      for (Instruction *instr : *instrs_) {
+         if (instr->opcode() == Opcode::LABEL) {
+            auto label_instr = static_cast<const LabelInstruction *>(instr);
+            block = blocks.at(label_instr->label()->name());
+            block->instrs().clear();
+         } else if (instr->opcode() != Opcode::JP ||
+                    block_instrs.find(instr) != block_instrs.end()) {
+            block->instrs().push_back(instr);
+         }
+      }
+
+      instrs_ = std::nullopt;
+   }
+
    void Block::Resolve(Block *block, const FunctionImpl *impl) {
       /* resolve instructions */
       Instructions resolved_instrs;
@@ -1244,6 +1758,10 @@ namespace zc {
    }
    
 
+   void DjnzTransition::Serialize(Instructions& out) {
+      out.push_back(new DjnzInstruction(new LabelValue(dst()->label())));
+   }
+
    void Block::DumpAsm(Block *block, std::ostream& os, Blocks& visited) {
       /* emit label */
       block->label()->EmitDef(os);
@@ -1256,6 +1774,23 @@ namespace zc {
       block->transitions().DumpAsm(os, visited);
    }
 
+   Cost Block::cost() const {
+      Cost cost;
+      for (const Instruction *instr : instrs()) {
+         cost += instr->cost();
+      }
+
+      Instructions jumps;
+      for (BlockTransition *trans : transitions().vec()) {
+         trans->Serialize(jumps);
+      }
+      for (const Instruction *instr : jumps) {
+         cost += instr->cost();
+      }
+
+      return cost;
+   }
+
    void FunctionImpl::Resolve() {
       Blocks visited;
       void (*fn)(Block *, const FunctionImpl *) = Block::Resolve;
@@ -1272,6 +1807,15 @@ namespace zc {
       fin()->for_each_block(visited, fn, os, visited);      
    }
 
+   Cost FunctionImpl::cost() const {
+      Cost cost;
+      Blocks visited;
+      auto fn = [&](Block *block) { cost += block->cost(); };
+      entry()->for_each_block(visited, fn);
+      fin()->for_each_block(visited, fn);
+      return cost;
+   }
+
    std::ostream& operator<<(std::ostream& os, Cond cond) {
       switch (cond) {
       case Cond::Z: return os << "z";
@@ -1302,6 +1846,9 @@ namespace zc {
       auto end = vec().end();
 
       for (; it != end; ++it) {
+         /* computed jumps reach all their targets */
+         if (dynamic_cast<const IndirectTransition *>(*it)) { continue; }
+         
          Cond cond = (*it)->cond();
          if (conds.find(cond) != conds.end()) {
             /* reduntant jump */
@@ -1379,6 +1926,12 @@ namespace zc {
       os << std::endl;
    }
 
+   void DjnzTransition::DumpAsm(std::ostream& os) const {
+      os << "\tdjnz\t";
+      dst()->label()->EmitRef(os);
+      os << std::endl;
+   }
+
    BlockTransition *ReturnTransition::Resolve(const FunctionImpl *impl) {
       return new JumpTransition(impl->fin(), cond());
    }
@@ -1414,34 +1967,42 @@ namespace zc {
          it = sizes_->insert(sizes_->end(), byte_size);
          sizes_->insert(sizes_->end(), byte_size);         
          break;
-      case word_size: abort();
+      case word_size:
+         /* pushed as 3 bytes; value occupies the low 2 */
+         it = sizes_->insert(sizes_->end(), word_size);
+         sizes_->insert(sizes_->end(), byte_size);
+         break;
       case long_size:
          it = sizes_->insert(sizes_->end(), long_size);
          break;
       default: abort();
       }
 
-      auto offset = new FrameValue(sizes_, it);
-      auto val = new IndexedRegisterValue(&rv_ix, IndexedRegisterValue::Index(offset));
+      auto offset = value_pool().Frame(sizes_, it);
+      auto val = value_pool().Indexed(&rv_ix, IndexedRegisterValue::Index(offset));
       return new VarSymInfo(val, arg);
    }
 
    VarSymInfo *StackFrame::next_local(const VarDeclaration *decl) {
       auto it = sizes_->insert(saved_fp_, decl->bytes());
-      auto offset = new FrameValue(sizes_, it);
-      auto val = new IndexedRegisterValue(&rv_ix, IndexedRegisterValue::Index(offset));
+      auto offset = value_pool().Frame(sizes_, it);
+      auto val = value_pool().Indexed(&rv_ix, IndexedRegisterValue::Index(offset));
       return new VarSymInfo(val, decl);
    }
 
    const Value *StackFrame::next_tmp(const Value *tmp) {
-      auto it = sizes_->insert(sizes_->begin(), tmp->size());
-      auto offset = new FrameValue(sizes_, it);
-      return new IndexedRegisterValue(&rv_ix, IndexedRegisterValue::Index(offset));
+      /* spilled words are stored from 24-bit registers, so pad their slot to 3 bytes */
+      spill_bytes_ += tmp->size() == word_size ? long_size : tmp->size();
+      if (spill_bytes_ > std::numeric_limits<int8_t>::max()) {
+         throw std::logic_error("offset too large");
+      }
+      auto index = IndexedRegisterValue::Index(static_cast<int8_t>(-spill_bytes_));
+      return value_pool().Mem(value_pool().Indexed(&rv_ix, index), tmp->size());
    }
 
-   const FrameValue *StackFrame::callee_bytes() { return new FrameValue(sizes_, saved_fp_); }
+   const FrameValue *StackFrame::callee_bytes() { return value_pool().Frame(sizes_, saved_fp_); }
    const FrameValue *StackFrame::neg_callee_bytes() {
-      return new FrameValue(sizes_, saved_fp_, true);
+      return value_pool().Frame(sizes_, saved_fp_, true);
    }
 
     void FunctionDef::FrameGen(StackFrame& frame) const {
@@ -1464,6 +2025,10 @@ namespace zc {
       }
    }
 
+   void SwitchStat::FrameGen(StackFrame& frame) const {
+      body()->FrameGen(frame);
+   }
+
    void WhileStat::FrameGen(StackFrame& frame) const {
       body()->FrameGen(frame);
    }
@@ -1482,7 +2047,13 @@ namespace zc {
    }
 
    void VarDeclaration::Declare(CgenEnv& env) {
-      SymInfo *info = env.ext_env().frame().next_local(this);
+      SymInfo *info;
+      if (g_optim.function_ralloc && is_reg_candidate()) {
+         /* promote to variable; function-level ralloc decides where it lives */
+         info = new VarSymInfo(nullptr, new VariableValue(bytes()), this);
+      } else {
+         info = env.ext_env().frame().next_local(this);
+      }
       env.symtab().AddToScope(sym(), info);
    }
 
@@ -1491,7 +2062,7 @@ namespace zc {
    }
 
    void Enumerator::Declare(CgenEnv& env) {
-      const Value *val = new ImmediateValue(eval(), enum_type()->bytes());
+      const Value *val = value_pool().Imm(eval(), enum_type()->bytes());
       
       env.symtab().AddToScope
          (sym(),
@@ -1537,4 +2108,10 @@ namespace zc {
 
       return dynamic_cast<const LabelValue *>(var_info->addr());
    }
+
+   const VariableValue *IdentifierExpr::val_var(const CgenEnv& env) const {
+      const SymInfo *id_info = env.symtab().Lookup(id()->id());
+      assert(id_info);
+      return dynamic_cast<const VariableValue *>(id_info->val());
+   }
 }
@@ -1,6 +1,11 @@
+#include <algorithm>
+#include <limits>
+
 #include "cgen.hpp"
 #include "emit.hpp"
 #include "asm.hpp"
+#include "crt.hpp"
+#include "optim.hpp"
 
 namespace zc {
 
@@ -15,13 +20,23 @@ namespace zc {
          /* ld a,<out>
           * or a,a
           */
-         block->instrs().push_back(new LoadInstruction(new RegisterValue(&r_a), in));
+         block->instrs().push_back(new LoadInstruction(value_pool().Reg(&r_a), in));
          block->instrs().push_back
-            (new OrInstruction(new RegisterValue(&r_a), new RegisterValue(&r_a)));
+            (new OrInstruction(value_pool().Reg(&r_a), value_pool().Reg(&r_a)));
+         *out = new FlagValue(Cond::Z, Cond::NZ);
+         return;
+         
+      case word_size:
+         /* ld hl,<in>
+          * ld a,h
+          * or a,l
+          */
+         block->instrs().push_back(new LoadInstruction(&rv_hl, in));
+         block->instrs().push_back(new LoadInstruction(&rv_a, &rv_h));
+         block->instrs().push_back(new OrInstruction(&rv_a, &rv_l));
          *out = new FlagValue(Cond::Z, Cond::NZ);
          return;
          
-      case word_size: abort();
       case long_size:
          /* ld hl,<in> 
           * call _icmpzero
@@ -77,7 +92,23 @@ namespace zc {
          is.push_back(new LoadInstruction(*out, &rv_a));
          return;
 
-      case word_size: abort();
+      case word_size:
+         /* ld hl,<in>
+          * ld a,h
+          * or a,l
+          * cp a,1
+          * ld a,0
+          * adc a,a
+          * ld <out>,a
+          */
+         is.push_back(new LoadInstruction(&rv_hl, in));
+         is.push_back(new LoadInstruction(&rv_a, &rv_h));
+         is.push_back(new OrInstruction(&rv_a, &rv_l));
+         is.push_back(new CompInstruction(&rv_a, &imm_b<1>));
+         is.push_back(new LoadInstruction(&rv_a, &imm_b<0>));
+         is.push_back(new AdcInstruction(&rv_a, &rv_a));
+         is.push_back(new LoadInstruction(*out, &rv_a));
+         return;
          
       case long_size:
          /* or a,a
@@ -104,7 +135,14 @@ namespace zc {
         case byte_size:
             emit_booleanize_flag_byte(env, block, in, out);
             break;
-        case word_size: abort();
+        case word_size:
+            {
+               const Value *wide;
+               emit_booleanize_flag_long(env, block, in, &wide);
+               *out = new VariableValue(word_size);
+               block->instrs().push_back(new LoadInstruction(*out, wide));
+            }
+            break;
         case long_size:
             emit_booleanize_flag_long(env, block, in, out);
             break;
@@ -125,7 +163,7 @@ namespace zc {
           * _
           */
          block->instrs().push_back(new LoadInstruction(&rv_a, &imm_b<0>));
-         block->instrs().push_back(new JrInstruction(new ImmediateValue(3), in->cond_0()));
+         block->instrs().push_back(new JrInstruction(value_pool().Imm(3, byte_size), in->cond_0()));
          block->instrs().push_back(new IncInstruction(&rv_a));
          break;
          
@@ -169,7 +207,7 @@ namespace zc {
           */
          *out = new VariableValue(long_size);         
          block->instrs().push_back(new LoadInstruction(*out, &imm_l<0>));
-         block->instrs().push_back(new JrInstruction(new ImmediateValue(3), in->cond_0()));
+         block->instrs().push_back(new JrInstruction(value_pool().Imm(3, byte_size), in->cond_0()));
          block->instrs().push_back(new IncInstruction(*out));
          break;
          
@@ -202,8 +240,55 @@ namespace zc {
       
    }
 
+   void emit_store_word(Block *block, const Value *val) {
+      /* ld (hl),low(<val>)
+       * inc hl
+       * ld (hl),high(<val>)
+       */
+      const MemoryValue *memval = value_pool().Mem(&rv_hl, byte_size);
+      block->instrs().push_back
+         (new LoadInstruction(memval, new ByteValue(val, ByteValue::Kind::BYTE_LOW)));
+      block->instrs().push_back(new IncInstruction(&rv_hl));
+      block->instrs().push_back
+         (new LoadInstruction(memval, new ByteValue(val, ByteValue::Kind::BYTE_HIGH)));
+   }
+
    Block *emit_incdec(CgenEnv& env, Block *block, bool inc_not_dec, bool pre_not_post,
                       ASTExpr *subexpr, const Value **out) {
+      /* pointers step by the size of what they point to */
+      int step = 1;
+      if (auto ptr_type = dynamic_cast<const PointerType *>(subexpr->type())) {
+         step = ptr_type->depth() > 1 ? long_size : std::max(ptr_type->pointee()->bytes(), 1);
+      }
+      const auto emit_step = [&](Instructions& is, const Value *rval) {
+         for (int i = 0; i < step; ++i) {
+            if (inc_not_dec) { is.push_back(new IncInstruction(rval)); }
+            else { is.push_back(new DecInstruction(rval)); }
+         }
+      };
+
+      auto subexpr_id = dynamic_cast<IdentifierExpr *>(subexpr);
+      const VariableValue *var = subexpr_id ? subexpr_id->val_var(env) : nullptr;
+      if (var) {
+         /* promoted local:
+          * ld <out>,<var>    ; if post
+          * inc/dec <var>     ; through register if long, in case <var> is frame-spilled
+          * ld <out>,<var>    ; if pre
+          */
+         Instructions& is = block->instrs();
+         if (out) { *out = new VariableValue(var->size()); }
+         if (out && !pre_not_post) { is.push_back(new LoadInstruction(*out, var)); }
+         const Value *rval = var;
+         if (var->size() != byte_size) {
+            rval = new VariableValue(var->size(), true);
+            is.push_back(new LoadInstruction(rval, var));
+         }
+         emit_step(is, rval);
+         if (rval != var) { is.push_back(new LoadInstruction(var, rval)); }
+         if (out && pre_not_post) { is.push_back(new LoadInstruction(*out, var)); }
+         return block;
+      }
+      
       const Value *lval = new VariableValue(long_size);
       block = subexpr->CodeGen(env, block, &lval, ASTExpr::ExprKind::EXPR_LVALUE);
       Instructions& is = block->instrs();
@@ -224,17 +309,31 @@ namespace zc {
              * NOTE: Target for peephole optimization.
              */
             {
-               const MemoryValue *memval = new MemoryValue(lval, subexpr->type()->bytes());
+               const MemoryValue *memval = value_pool().Mem(lval, subexpr->type()->bytes());
                is.push_back(new LoadInstruction(&rv_a, memval));
-               if (inc_not_dec) { is.push_back(new IncInstruction(&rv_a)); }
-               else { is.push_back(new DecInstruction(&rv_a)); }
+               emit_step(is, &rv_a);
                is.push_back(new LoadInstruction(memval, &rv_a));
                if (out) {
                   is.push_back(new LoadInstruction(*out, &rv_a));
                }
             }
             break;
-         case word_size: abort();
+         case word_size:
+            /* ld hl,<lval>
+             * ld <rval>,(hl)
+             * inc/dec <rval>
+             * ld (hl),low(<rval>) \ inc hl \ ld (hl),high(<rval>)
+             * ld <out>,<rval>
+             */
+            {
+               const Value *rval = new VariableValue(word_size, true);
+               is.push_back(new LoadInstruction(&rv_hl, lval));
+               is.push_back(new LoadInstruction(rval, value_pool().Mem(&rv_hl, word_size)));
+               emit_step(is, rval);
+               emit_store_word(block, rval);
+               if (out) { is.push_back(new LoadInstruction(*out, rval)); }
+            }
+            break;
          case long_size:
             /* ld hl,<lval>
              * ld <rval>,(hl)
@@ -244,11 +343,10 @@ namespace zc {
              */
             {
                const Value *rval = new VariableValue(long_size);
-               const MemoryValue *memval = new MemoryValue(&rv_hl, long_size);
+               const MemoryValue *memval = value_pool().Mem(&rv_hl, long_size);
                is.push_back(new LoadInstruction(&rv_hl, lval));
                is.push_back(new LoadInstruction(rval, memval));
-               if (inc_not_dec) { is.push_back(new IncInstruction(rval)); }
-               else { is.push_back(new DecInstruction(rval)); }
+               emit_step(is, rval);
                is.push_back(new LoadInstruction(memval, rval));
                if (out) { is.push_back(new LoadInstruction(*out, rval)); }
             }
@@ -264,15 +362,29 @@ namespace zc {
              * ld (<lval>),a
              */
             {
-               const MemoryValue *memval = new MemoryValue(lval, byte_size);
+               const MemoryValue *memval = value_pool().Mem(lval, byte_size);
                is.push_back(new LoadInstruction(&rv_a, memval));
-               is.push_back(new LoadInstruction(*out, &rv_a));
-               if (inc_not_dec) { is.push_back(new IncInstruction(&rv_a)); }
-               else { is.push_back(new DecInstruction(&rv_a)); }
+               if (out) { is.push_back(new LoadInstruction(*out, &rv_a)); }
+               emit_step(is, &rv_a);
                is.push_back(new LoadInstruction(memval, &rv_a));
             }
             break;
-         case word_size: abort();
+         case word_size:
+            /* ld hl,<lval>
+             * ld <rval>,(hl)
+             * ld <out>,<rval>
+             * inc/dec <rval>
+             * ld (hl),low(<rval>) \ inc hl \ ld (hl),high(<rval>)
+             */
+            {
+               const Value *rval = new VariableValue(word_size, true);
+               is.push_back(new LoadInstruction(&rv_hl, lval));
+               is.push_back(new LoadInstruction(rval, value_pool().Mem(&rv_hl, word_size)));
+               if (out) { is.push_back(new LoadInstruction(*out, rval)); }
+               emit_step(is, rval);
+               emit_store_word(block, rval);
+            }
+            break;
          case long_size:
             /* ld hl,<lval>
              * ld <rval>,(hl)
@@ -282,12 +394,11 @@ namespace zc {
              */
             {
                const Value *rval = new VariableValue(long_size);
-               const MemoryValue *memval = new MemoryValue(&rv_hl, long_size);
+               const MemoryValue *memval = value_pool().Mem(&rv_hl, long_size);
                is.push_back(new LoadInstruction(&rv_hl, lval));
                is.push_back(new LoadInstruction(rval, memval));
-               is.push_back(new LoadInstruction(*out, rval));
-               if (inc_not_dec) { is.push_back(new IncInstruction(rval)); }
-               else { is.push_back(new DecInstruction(rval)); }
+               if (out) { is.push_back(new LoadInstruction(*out, rval)); }
+               emit_step(is, rval);
                is.push_back(new LoadInstruction(memval, rval));
             }
             break;
@@ -332,21 +443,927 @@ namespace zc {
       block->instrs().insert(block->instrs().begin(), instrs.begin(), instrs.end());
    }
    
-   void emit_frameunset(CgenEnv& env, Block *block) {
+   void emit_spillset(const StackFrame& frame, Block *entry, Block *fin) {
+      /* push ix
+       * ld ix,-<locals>
+       * add ix,sp
+       * lea ix,ix-<spills>
+       * ld sp,ix
+       * lea ix,ix+<spills>
+       */
+      if (frame.spill_bytes() == 0) { return; }
+      const LoadInstruction set_sp(&rv_sp, &rv_ix);
+      auto it = std::find_if(entry->instrs().begin(), entry->instrs().end(),
+                             [&](const Instruction *instr) { return instr->Eq(&set_sp); });
+      assert(it != entry->instrs().end());
+      const int8_t spills = frame.spill_bytes();
+      it = entry->instrs().insert(it, new LeaInstruction
+                                  (&rv_ix, value_pool().Indexed(&rv_ix, int8_t(-spills))));
+      entry->instrs().insert(std::next(it, 2), new LeaInstruction
+                             (&rv_ix, value_pool().Indexed(&rv_ix, spills)));
+
+      /* sp no longer equals ix on exit from a frame without locals, so drop the no-op
+       * `lea ix,ix+0' that would let `ld sp,ix' be peepholed away with it */
+      static const IndexedRegisterValue idx_0(&rv_ix, 0);
+      static const LeaInstruction unset_0(&rv_ix, &idx_0);
+      if (!fin->instrs().empty() && fin->instrs().front()->Eq(&unset_0)) {
+         fin->instrs().erase(fin->instrs().begin());
+      }
+   }
+   
+   void emit_frameunset(CgenEnv& env, Block *block, int pop_bytes) {
       /* lea ix,ix+locals_bytes
        * ld sp,ix
        * pop ix
        * ret
        */
       block->instrs().push_back(new LeaInstruction
-                                (&rv_ix, new IndexedRegisterValue
+                                (&rv_ix, value_pool().Indexed
                                  (&rv_ix,
                                   IndexedRegisterValue::Index(env.ext_env().frame().saved_fp()))));
       block->instrs().push_back(new LoadInstruction(&rv_sp, &rv_ix));
       block->instrs().push_back(new PopInstruction(&rv_ix));
+      if (pop_bytes > 0) {
+         /* pop de         ; return address
+          * <cleanup>     ; release arguments
+          * push de
+          */
+         block->instrs().push_back(new PopInstruction(&rv_de));
+         emit_stack_cleanup(block, pop_bytes, &rv_iy, &rv_iy);
+         block->instrs().push_back(new PushInstruction(&rv_de));
+      }
       block->instrs().push_back(new RetInstruction());
    }
 
+   void emit_stack_cleanup(Block *block, int bytes, const RegisterValue *pop_scratch,
+                           const RegisterValue *add_scratch) {
+      /* cost is bytes + cycles (ADL mode, no wait states); index registers add a prefix byte
+       * and a cycle to each instruction */
+      const auto prefix = [](const RegisterValue *rv) {
+                             return rv->reg()->Eq(&r_ix) || rv->reg()->Eq(&r_iy) ? 1 : 0;
+                          };
+      const int slots = bytes / long_size;
+      /* pop rr */
+      const int pop_cost = slots * (1 + 4 + 2 * prefix(pop_scratch));
+      /* inc sp */
+      const int inc_cost = bytes * (1 + 1);
+      /* ld rr,<bytes> \ add rr,sp \ ld sp,rr */
+      const int add_cost = (4 + 4) + (1 + 1) + (1 + 1) + 6 * prefix(add_scratch);
+
+      if (pop_cost <= inc_cost && pop_cost <= add_cost) {
+         for (int i = 0; i < slots; ++i) {
+            block->instrs().push_back(new PopInstruction(pop_scratch));
+         }
+      } else if (inc_cost <= add_cost) {
+         for (int i = 0; i < bytes; ++i) {
+            block->instrs().push_back(new IncInstruction(&rv_sp));
+         }
+      } else {
+         block->instrs().push_back(new LoadInstruction(add_scratch,
+                                                       value_pool().Imm(bytes, long_size)));
+         block->instrs().push_back(new AddInstruction(add_scratch, &rv_sp));
+         block->instrs().push_back(new LoadInstruction(&rv_sp, add_scratch));
+      }
+   }
+
+   namespace {
+
+      /**
+       * Candidate instruction sequence with its estimated cost, in bytes + cycles
+       * (@see Instruction::cost()).
+       * @param crt_cycles cycles spent inside the called CRT routine, for calls
+       */
+      struct CostedInstrs {
+         Instructions instrs;
+         int cost = 0;
+
+         void add(Instruction *instr, int crt_cycles = 0) {
+            instrs.push_back(instr);
+            Cost instr_cost = instr->cost();
+            cost += instr_cost.bytes + instr_cost.cycles + crt_cycles;
+         }
+
+         bool operator<(const CostedInstrs& other) const { return cost < other.cost; }
+      };
+
+      /* rough average cycles spent inside CRT arithmetic routines */
+      constexpr int crt_mul_cycles = 150;
+      constexpr int crt_div_cycles[] = {0, 100, 350, 600}; /* indexed by operand size */
+      int crt_shift_cycles(int shift) { return 10 + 8 * shift; }
+
+      uintmax_t size_mask(int bytes) { return (uintmax_t(1) << (bytes * 8)) - 1; }
+
+      /**
+       * @return k if value is 2^k, otherwise -1
+       */
+      int exact_log2(uintmax_t value) {
+         return (value != 0 && (value & (value - 1)) == 0) ? __builtin_ctzll(value) : -1;
+      }
+
+   }
+
+   /**
+    * Signed-digit representation of multiplier, most significant digit first.
+    * @param naf use non-adjacent form (digits -1, 0, 1), which replaces runs of ones with a
+    *        subtraction
+    */
+   static std::vector<int> mul_digits(uintmax_t factor, bool naf) {
+      std::vector<int> digits;
+      for (; factor; factor >>= 1) {
+         int digit = 0;
+         if (factor & 1) {
+            digit = (naf && (factor & 3) == 3) ? -1 : 1;
+            factor -= digit;
+         }
+         digits.push_back(digit);
+      }
+      std::reverse(digits.begin(), digits.end());
+      return digits;
+   }
+
+   /**
+    * Shift-and-add chain: accumulator (a or hl) doubles per digit, adding or subtracting a copy
+    * of the multiplicand kept in e or de.
+    */
+   static CostedInstrs mul_chain(const Value *val, const std::vector<int>& digits) {
+      CostedInstrs seq;
+      const bool multibyte = (val->size() != byte_size);
+      const RegisterValue *acc = accumulator(val);
+      const RegisterValue *copy = multibyte ? &rv_de : &rv_e;
+
+      seq.add(new LoadInstruction(acc, val));
+      if (std::any_of(digits.begin() + 1, digits.end(), [](int digit) { return digit != 0; })) {
+         /* register pairs are copied through the stack */
+         seq.add(new LoadInstruction(copy, val));
+      }
+      for (auto it = digits.begin() + 1; it != digits.end(); ++it) {
+         seq.add(new AddInstruction(acc, acc));
+         if (*it > 0) {
+            seq.add(new AddInstruction(acc, copy));
+         } else if (*it < 0) {
+            if (multibyte) {
+               seq.add(new OrInstruction(&rv_a, &rv_a));
+               seq.add(new SbcInstruction(acc, copy));
+            } else {
+               seq.add(new SubInstruction(acc, copy));
+            }
+         }
+      }
+      return seq;
+   }
+
+   /**
+    * mlt partial products; factor must fit in a byte.
+    */
+   static CostedInstrs mul_mlt(const Value *val, uintmax_t factor) {
+      CostedInstrs seq;
+      const ImmediateValue *imm = value_pool().Imm(factor, byte_size);
+      if (val->size() == byte_size) {
+         /* ld h,<val>
+          * ld l,<factor>
+          * mlt hl
+          * ld a,l
+          */
+         seq.add(new LoadInstruction(&rv_h, val));
+         seq.add(new LoadInstruction(&rv_l, imm));
+         seq.add(new MultInstruction(&rv_hl));
+         seq.add(new LoadInstruction(&rv_a, &rv_l));
+      } else {
+         /* low byte times factor, plus low byte of high byte times factor shifted up:
+          * ld de,<val>
+          * ld h,e
+          * ld l,<factor>
+          * mlt hl
+          * ld e,<factor>
+          * mlt de
+          * ld a,h
+          * add a,e
+          * ld h,a
+          */
+         seq.add(new LoadInstruction(&rv_de, val));
+         seq.add(new LoadInstruction(&rv_h, &rv_e));
+         seq.add(new LoadInstruction(&rv_l, imm));
+         seq.add(new MultInstruction(&rv_hl));
+         seq.add(new LoadInstruction(&rv_e, imm));
+         seq.add(new MultInstruction(&rv_de));
+         seq.add(new LoadInstruction(&rv_a, &rv_h));
+         seq.add(new AddInstruction(&rv_a, &rv_e));
+         seq.add(new LoadInstruction(&rv_h, &rv_a));
+      }
+      return seq;
+   }
+
+   static CostedInstrs mul_crt(const Value *val, uintmax_t factor, bool is_signed) {
+      /* ld hl,<val>
+       * ld bc,<factor>
+       * call __smulu/__imulu
+       */
+      CostedInstrs seq;
+      seq.add(new LoadInstruction(&rv_hl, val));
+      seq.add(new LoadInstruction(&rv_bc, value_pool().Imm(factor, long_size)));
+      seq.add(new CallInstruction(g_crt.val(crt_prefix(val) + "mul" + crt_suffix(is_signed))),
+              crt_mul_cycles);
+      return seq;
+   }
+
+   static CostedInstrs mul_const(const Value *val, intmax_t factor, bool is_signed) {
+      const int bytes = val->size();
+      const uintmax_t ufactor = static_cast<uintmax_t>(factor) & size_mask(bytes);
+
+      if (ufactor == 0) {
+         CostedInstrs seq;
+         const RegisterValue *acc = accumulator(bytes);
+         seq.add(new LoadInstruction(acc, value_pool().Imm(0, acc->size())));
+         return seq;
+      }
+
+      std::vector<CostedInstrs> candidates;
+      for (bool naf : {false, true}) {
+         candidates.push_back(mul_chain(val, mul_digits(ufactor, naf)));
+      }
+      if (bytes == byte_size ||
+          (bytes == word_size && ufactor <= std::numeric_limits<uint8_t>::max())) {
+         candidates.push_back(mul_mlt(val, ufactor));
+      }
+      if (bytes != byte_size) {
+         candidates.push_back(mul_crt(val, ufactor, is_signed));
+      }
+      return *std::min_element(candidates.begin(), candidates.end());
+   }
+
+   void emit_mul_const(Block *block, const Value *val, intmax_t factor, bool is_signed) {
+      CostedInstrs seq = mul_const(val, factor, is_signed);
+      block->instrs().splice(block->instrs().end(), seq.instrs);
+   }
+
+   /**
+    * Find multiply-high reciprocal: the smallest shift s for which m = ceil(2^(bits+s)/d)
+    * gives floor(x*m / 2^(bits+s)) = floor(x/d) for every bits-wide x. The magic number may
+    * need bits+1 bits.
+    */
+   static void div_magic(uintmax_t divisor, int bits, uintmax_t& magic, int& shift) {
+      for (shift = 0; ; ++shift) {
+         const uintmax_t pow = uintmax_t(1) << (bits + shift);
+         magic = (pow + divisor - 1) / divisor;
+         if (magic * divisor - pow <= (uintmax_t(1) << shift)) { return; }
+      }
+   }
+
+   /* srl h \ rr l (sra h for arithmetic shifts) */
+   static void shr_word(CostedInstrs& seq, bool arith) {
+      if (arith) {
+         seq.add(new SraInstruction(&rv_h));
+      } else {
+         seq.add(new SrlInstruction(&rv_h));
+      }
+      seq.add(new RrInstruction(&rv_l));
+   }
+
+   /* and low 16 bits of hl with mask */
+   static void mask_word(CostedInstrs& seq, uintmax_t mask) {
+      const uintmax_t low = mask & 0xff, high = (mask >> 8) & 0xff;
+      if (low != 0xff) {
+         seq.add(new LoadInstruction(&rv_a, &rv_l));
+         seq.add(new AndInstruction(&rv_a, value_pool().Imm(low, byte_size)));
+         seq.add(new LoadInstruction(&rv_l, &rv_a));
+      }
+      if (high == 0) {
+         seq.add(new LoadInstruction(&rv_h, &imm_b<0>));
+      } else if (high != 0xff) {
+         seq.add(new LoadInstruction(&rv_a, &rv_h));
+         seq.add(new AndInstruction(&rv_a, value_pool().Imm(high, byte_size)));
+         seq.add(new LoadInstruction(&rv_h, &rv_a));
+      }
+   }
+
+   /* and hl with mask of at most 16 bits; `and' clears carry, so sbc hl,hl zeroes the upper
+    * byte */
+   static void mask_long(CostedInstrs& seq, uintmax_t mask) {
+      if (mask <= 0xff) {
+         /* ld a,l
+          * and a,<mask>
+          * sbc hl,hl
+          * ld l,a
+          */
+         seq.add(new LoadInstruction(&rv_a, &rv_l));
+         seq.add(new AndInstruction(&rv_a, value_pool().Imm(mask, byte_size)));
+         seq.add(new SbcInstruction(&rv_hl, &rv_hl));
+         seq.add(new LoadInstruction(&rv_l, &rv_a));
+      } else {
+         /* ld e,l
+          * ld a,h
+          * and a,<mask>>8>
+          * sbc hl,hl
+          * ld h,a
+          * ld l,e
+          */
+         seq.add(new LoadInstruction(&rv_e, &rv_l));
+         seq.add(new LoadInstruction(&rv_a, &rv_h));
+         seq.add(new AndInstruction(&rv_a, value_pool().Imm(mask >> 8, byte_size)));
+         seq.add(new SbcInstruction(&rv_hl, &rv_hl));
+         seq.add(new LoadInstruction(&rv_h, &rv_a));
+         seq.add(new LoadInstruction(&rv_l, &rv_e));
+      }
+   }
+
+   /**
+    * High 16 bits of 16-bit value in bc times 16-bit constant, from four mlt partial products;
+    * left in hl. Preserves bc.
+    */
+   static void mulhi_word(CostedInstrs& seq, uintmax_t magic) {
+      const ImmediateValue *mlow = value_pool().Imm(magic & 0xff, byte_size);
+      const ImmediateValue *mhigh = value_pool().Imm((magic >> 8) & 0xff, byte_size);
+
+      /* d = high byte of xl*ml */
+      seq.add(new LoadInstruction(&rv_d, &rv_c));
+      seq.add(new LoadInstruction(&rv_e, mlow));
+      seq.add(new MultInstruction(&rv_de));
+      /* hl = xh*ml + d */
+      seq.add(new LoadInstruction(&rv_h, &rv_b));
+      seq.add(new LoadInstruction(&rv_l, mlow));
+      seq.add(new MultInstruction(&rv_hl));
+      seq.add(new LoadInstruction(&rv_a, &rv_l));
+      seq.add(new AddInstruction(&rv_a, &rv_d));
+      seq.add(new LoadInstruction(&rv_l, &rv_a));
+      seq.add(new LoadInstruction(&rv_a, &rv_h));
+      seq.add(new AdcInstruction(&rv_a, &imm_b<0>));
+      seq.add(new LoadInstruction(&rv_h, &rv_a));
+      /* hl = (hl + xl*mh) >> 8, keeping the carry out of the high byte */
+      seq.add(new LoadInstruction(&rv_d, &rv_c));
+      seq.add(new LoadInstruction(&rv_e, mhigh));
+      seq.add(new MultInstruction(&rv_de));
+      seq.add(new LoadInstruction(&rv_a, &rv_l));
+      seq.add(new AddInstruction(&rv_a, &rv_e));
+      seq.add(new LoadInstruction(&rv_a, &rv_h));
+      seq.add(new AdcInstruction(&rv_a, &rv_d));
+      seq.add(new LoadInstruction(&rv_l, &rv_a));
+      seq.add(new LoadInstruction(&rv_h, &imm_b<0>));
+      seq.add(new RlInstruction(&rv_h));
+      /* hl += xh*mh */
+      seq.add(new LoadInstruction(&rv_d, &rv_b));
+      seq.add(new LoadInstruction(&rv_e, mhigh));
+      seq.add(new MultInstruction(&rv_de));
+      seq.add(new AddInstruction(&rv_hl, &rv_de));
+   }
+
+   static bool div_const_byte(CostedInstrs& seq, const Value *val, uintmax_t divisor,
+                              bool is_signed, bool div_not_mod) {
+      const int log = exact_log2(divisor);
+      const ImmediateValue *mask = value_pool().Imm(divisor - 1, byte_size);
+
+      if (is_signed) {
+         if (log < 0) { return false; }
+         /* bias negative dividends by divisor - 1 so the shift rounds toward zero:
+          * ld a,<val>
+          * rl a
+          * sbc a,a
+          * and a,<divisor-1>
+          */
+         seq.add(new LoadInstruction(&rv_a, val));
+         seq.add(new RlInstruction(&rv_a));
+         seq.add(new SbcInstruction(&rv_a, &rv_a));
+         seq.add(new AndInstruction(&rv_a, mask));
+         if (div_not_mod) {
+            /* add a,<val>
+             * sra a (log times)
+             */
+            seq.add(new AddInstruction(&rv_a, val));
+            for (int i = 0; i < log; ++i) {
+               seq.add(new SraInstruction(&rv_a));
+            }
+         } else {
+            /* ld b,a
+             * add a,<val>
+             * and a,<divisor-1>
+             * sub a,b
+             */
+            seq.add(new LoadInstruction(&rv_b, &rv_a));
+            seq.add(new AddInstruction(&rv_a, val));
+            seq.add(new AndInstruction(&rv_a, mask));
+            seq.add(new SubInstruction(&rv_a, &rv_b));
+         }
+         return true;
+      }
+
+      if (log >= 0) {
+         seq.add(new LoadInstruction(&rv_a, val));
+         if (div_not_mod) {
+            for (int i = 0; i < log; ++i) {
+               seq.add(new SrlInstruction(&rv_a));
+            }
+         } else {
+            seq.add(new AndInstruction(&rv_a, mask));
+         }
+         return true;
+      }
+
+      uintmax_t magic;
+      int shift;
+      div_magic(divisor, 8, magic, shift);
+
+      /* ld h,<val>
+       * ld l,<magic>
+       * mlt hl
+       */
+      seq.add(new LoadInstruction(&rv_h, val));
+      seq.add(new LoadInstruction(&rv_l, value_pool().Imm(magic & 0xff, byte_size)));
+      seq.add(new MultInstruction(&rv_hl));
+      if (magic <= 0xff) {
+         /* ld a,h */
+         seq.add(new LoadInstruction(&rv_a, &rv_h));
+      } else {
+         /* 9-bit magic: q = (t + ((x - t) >> 1)) >> (shift - 1), where t = high(x * (m - 256))
+          * ld a,<val>
+          * sub a,h
+          * srl a
+          * add a,h
+          */
+         seq.add(new LoadInstruction(&rv_a, val));
+         seq.add(new SubInstruction(&rv_a, &rv_h));
+         seq.add(new SrlInstruction(&rv_a));
+         seq.add(new AddInstruction(&rv_a, &rv_h));
+         --shift;
+      }
+      for (int i = 0; i < shift; ++i) {
+         seq.add(new SrlInstruction(&rv_a));
+      }
+
+      if (!div_not_mod) {
+         /* ld h,a
+          * ld l,<divisor>
+          * mlt hl
+          * ld a,<val>
+          * sub a,l
+          */
+         seq.add(new LoadInstruction(&rv_h, &rv_a));
+         seq.add(new LoadInstruction(&rv_l, value_pool().Imm(divisor, byte_size)));
+         seq.add(new MultInstruction(&rv_hl));
+         seq.add(new LoadInstruction(&rv_a, val));
+         seq.add(new SubInstruction(&rv_a, &rv_l));
+      }
+      return true;
+   }
+
+   static bool div_const_word(CostedInstrs& seq, const Value *val, uintmax_t divisor,
+                              bool is_signed, bool div_not_mod) {
+      const int log = exact_log2(divisor);
+
+      if (is_signed) {
+         if (log < 0) { return false; }
+         /* bias = sign ? divisor - 1 : 0
+          * ld hl,<val>
+          * ld a,h
+          * rl a
+          * sbc hl,hl
+          * <mask>
+          */
+         seq.add(new LoadInstruction(&rv_hl, val));
+         seq.add(new LoadInstruction(&rv_a, &rv_h));
+         seq.add(new RlInstruction(&rv_a));
+         seq.add(new SbcInstruction(&rv_hl, &rv_hl));
+         mask_word(seq, divisor - 1);
+         if (div_not_mod) {
+            seq.add(new LoadInstruction(&rv_de, val));
+            seq.add(new AddInstruction(&rv_hl, &rv_de));
+            for (int i = 0; i < log; ++i) {
+               shr_word(seq, true);
+            }
+         } else {
+            /* ((val + bias) & (divisor - 1)) - bias */
+            seq.add(new LoadInstruction(&rv_bc, &rv_hl));
+            seq.add(new LoadInstruction(&rv_de, val));
+            seq.add(new AddInstruction(&rv_hl, &rv_de));
+            mask_word(seq, divisor - 1);
+            seq.add(new OrInstruction(&rv_a, &rv_a));
+            seq.add(new SbcInstruction(&rv_hl, &rv_bc));
+         }
+         return true;
+      }
+
+      if (log >= 0) {
+         seq.add(new LoadInstruction(&rv_hl, val));
+         if (div_not_mod) {
+            for (int i = 0; i < log; ++i) {
+               shr_word(seq, false);
+            }
+         } else {
+            mask_word(seq, divisor - 1);
+         }
+         return true;
+      }
+
+      uintmax_t magic;
+      int shift;
+      div_magic(divisor, 16, magic, shift);
+
+      seq.add(new LoadInstruction(&rv_bc, val));
+      mulhi_word(seq, magic);
+      if (magic > 0xffff) {
+         /* 17-bit magic: q = (t + ((x - t) >> 1)) >> (shift - 1)
+          * ld d,h
+          * ld e,l
+          * ld a,c
+          * sub a,e
+          * ld l,a
+          * ld a,b
+          * sbc a,d
+          * ld h,a
+          * srl h
+          * rr l
+          * add hl,de
+          */
+         seq.add(new LoadInstruction(&rv_d, &rv_h));
+         seq.add(new LoadInstruction(&rv_e, &rv_l));
+         seq.add(new LoadInstruction(&rv_a, &rv_c));
+         seq.add(new SubInstruction(&rv_a, &rv_e));
+         seq.add(new LoadInstruction(&rv_l, &rv_a));
+         seq.add(new LoadInstruction(&rv_a, &rv_b));
+         seq.add(new SbcInstruction(&rv_a, &rv_d));
+         seq.add(new LoadInstruction(&rv_h, &rv_a));
+         shr_word(seq, false);
+         seq.add(new AddInstruction(&rv_hl, &rv_de));
+         --shift;
+      }
+      for (int i = 0; i < shift; ++i) {
+         shr_word(seq, false);
+      }
+
+      if (!div_not_mod) {
+         /* val - quotient * divisor
+          * ld <q>,hl
+          * <multiply>
+          * ld de,hl
+          * ld hl,<val>
+          * or a,a
+          * sbc hl,de
+          */
+         auto quot = new VariableValue(word_size);
+         seq.add(new LoadInstruction(quot, &rv_hl));
+         CostedInstrs mul = mul_const(quot, divisor, false);
+         seq.instrs.splice(seq.instrs.end(), mul.instrs);
+         seq.cost += mul.cost;
+         seq.add(new LoadInstruction(&rv_de, &rv_hl));
+         seq.add(new LoadInstruction(&rv_hl, val));
+         seq.add(new OrInstruction(&rv_a, &rv_a));
+         seq.add(new SbcInstruction(&rv_hl, &rv_de));
+      }
+      return true;
+   }
+
+   static bool div_const_long(CostedInstrs& seq, const Value *val, uintmax_t divisor,
+                              bool is_signed, bool div_not_mod) {
+      const int log = exact_log2(divisor);
+      const ImmediateValue *imm_log = value_pool().Imm(log, byte_size);
+
+      /* masks wider than 16 bits would need the inaccessible upper byte */
+      if (log < 0 || (log > 16 && (is_signed || !div_not_mod))) { return false; }
+
+      if (is_signed) {
+         /* bias = sign ? divisor - 1 : 0
+          * ld hl,<val>
+          * add hl,hl
+          * sbc hl,hl
+          * <mask>
+          */
+         seq.add(new LoadInstruction(&rv_hl, val));
+         seq.add(new AddInstruction(&rv_hl, &rv_hl));
+         seq.add(new SbcInstruction(&rv_hl, &rv_hl));
+         mask_long(seq, divisor - 1);
+         if (div_not_mod) {
+            /* ld de,<val>
+             * add hl,de
+             * ld c,<log>
+             * call __ishrs
+             */
+            seq.add(new LoadInstruction(&rv_de, val));
+            seq.add(new AddInstruction(&rv_hl, &rv_de));
+            seq.add(new LoadInstruction(&rv_c, imm_log));
+            seq.add(new CallInstruction(g_crt.val("__ishrs")), crt_shift_cycles(log));
+         } else {
+            /* ((val + bias) & (divisor - 1)) - bias */
+            seq.add(new LoadInstruction(&rv_bc, &rv_hl));
+            seq.add(new LoadInstruction(&rv_de, val));
+            seq.add(new AddInstruction(&rv_hl, &rv_de));
+            mask_long(seq, divisor - 1);
+            seq.add(new OrInstruction(&rv_a, &rv_a));
+            seq.add(new SbcInstruction(&rv_hl, &rv_bc));
+         }
+         return true;
+      }
+
+      seq.add(new LoadInstruction(&rv_hl, val));
+      if (div_not_mod) {
+         /* ld c,<log>
+          * call __ishru
+          */
+         seq.add(new LoadInstruction(&rv_c, imm_log));
+         seq.add(new CallInstruction(g_crt.val("__ishru")), crt_shift_cycles(log));
+      } else {
+         mask_long(seq, divisor - 1);
+      }
+      return true;
+   }
+
+   bool emit_div_const(Block *block, const Value *val, intmax_t divisor, bool is_signed,
+                       bool div_not_mod) {
+      const int bytes = val->size();
+      const RegisterValue *acc = accumulator(bytes);
+      uintmax_t udivisor;
+      if (is_signed) {
+         /* negative divisors are left to the CRT */
+         if (divisor <= 0 || static_cast<uintmax_t>(divisor) > (size_mask(bytes) >> 1)) {
+            return false;
+         }
+         udivisor = divisor;
+      } else {
+         udivisor = static_cast<uintmax_t>(divisor) & size_mask(bytes);
+         if (udivisor == 0) { return false; }
+      }
+
+      CostedInstrs seq;
+      if (udivisor == 1) {
+         if (div_not_mod) {
+            seq.add(new LoadInstruction(acc, val));
+         } else {
+            seq.add(new LoadInstruction(acc, value_pool().Imm(0, acc->size())));
+         }
+      } else {
+         bool (*lower)(CostedInstrs&, const Value *, uintmax_t, bool, bool);
+         switch (bytes) {
+         case byte_size: lower = div_const_byte; break;
+         case word_size: lower = div_const_word; break;
+         case long_size: lower = div_const_long; break;
+         default: abort();
+         }
+         if (!lower(seq, val, udivisor, is_signed, div_not_mod)) { return false; }
+      }
+
+      /* ld <arg1>,<val>
+       * ld <arg2>,<divisor>
+       * call __bdivu/__sdivs/...
+       */
+      CostedInstrs crt;
+      crt.add(new LoadInstruction(crt_arg1(bytes), val));
+      crt.add(new LoadInstruction(crt_arg2(bytes), value_pool().Imm(udivisor, bytes)));
+      crt.add(new CallInstruction(g_crt.val(crt_prefix(bytes) + "div" + crt_suffix(is_signed))),
+              crt_div_cycles[bytes]);
+      if (seq.cost > crt.cost) { return false; }
+
+      block->instrs().splice(block->instrs().end(), seq.instrs);
+      return true;
+   }
+
+   /**
+    * Estimated cost of binary search dispatch over given number of cases.
+    */
+   static int switch_tree_cost(int bytes, std::size_t ncases) {
+      /* per node: ld a,c; cp a,<case>; jp z; jp c
+       *       or: ld hl,bc; ld de,<case>; or a,a; sbc hl,de; jp z; jp c
+       * Every node is emitted, but only one per level is executed.
+       */
+      const int node_bytes = bytes == byte_size ? 11 : 16;
+      const int node_cycles = bytes == byte_size ? 13 : 18;
+      int depth = 0;
+      for (std::size_t n = ncases; n; n >>= 1) { ++depth; }
+      return node_bytes * ncases + node_cycles * depth;
+   }
+
+   /**
+    * Estimated cost of jump table dispatch over given range of case values.
+    */
+   static int switch_table_cost(int bytes, intmax_t range) {
+      /* bounds check, table index and `jp (hl)' (17 bytes, 20 cycles), plus a `jp' per entry:
+       * byte: ld a,c; sub a,<lo>; ld c,a; cp a,<range>; jp nc (10 bytes, 10 cycles)
+       * word, long: ld hl,bc; ld de,<-lo>; add hl,de; ld c,l; ld de,<range>; or a,a;
+       *             sbc hl,de; jp nc (18 bytes, 18 cycles)
+       */
+      const int check = bytes == byte_size ? 10 : 18;
+      return (check + 17 + 4 * range) + (check + 20);
+   }
+
+   /**
+    * Emit binary search over case keys, sorted in ascending order. Each node compares the key
+    * with its middle case, then continues in the lower or upper half.
+    */
+   static void switch_tree(Block *block, const Value *key, SwitchCases::const_iterator begin,
+                           SwitchCases::const_iterator end, Block *default_block) {
+      if (begin == end) {
+         block->transitions().vec().push_back(new JumpTransition(default_block, Cond::ANY));
+         return;
+      }
+
+      auto mid = begin + (end - begin) / 2;
+      const ImmediateValue *imm = value_pool().Imm(mid->first, key->size());
+      if (key->size() == byte_size) {
+         /* ld a,c
+          * cp a,<case>
+          */
+         block->instrs().push_back(new LoadInstruction(&rv_a, key));
+         block->instrs().push_back(new CompInstruction(&rv_a, imm));
+      } else {
+         /* ld hl,bc
+          * ld de,<case>
+          * or a,a
+          * sbc hl,de
+          */
+         block->instrs().push_back(new LoadInstruction(&rv_hl, key));
+         block->instrs().push_back(new LoadInstruction(&rv_de, imm));
+         block->instrs().push_back(new OrInstruction(&rv_a, &rv_a));
+         block->instrs().push_back(new SbcInstruction(&rv_hl, &rv_de));
+      }
+      block->transitions().vec().push_back(new JumpTransition(mid->second, Cond::Z));
+
+      Block *lower = default_block;
+      if (begin != mid) {
+         lower = new Block(new_label("switch_lt"));
+         switch_tree(lower, key, begin, mid, default_block);
+      }
+
+      Block *upper = default_block;
+      if (mid + 1 != end) {
+         upper = new Block(new_label("switch_gt"));
+         switch_tree(upper, key, mid + 1, end, default_block);
+      }
+
+      if (lower != upper) {
+         block->transitions().vec().push_back(new JumpTransition(lower, Cond::C));
+      }
+      block->transitions().vec().push_back(new JumpTransition(upper, Cond::ANY));
+   }
+
+   /**
+    * Emit jump table dispatch: a bounds check, then a jump into a table of `jp' instructions,
+    * one per value in the range of case keys.
+    */
+   static void switch_table(Block *block, const Value *key, const SwitchCases& cases,
+                            Block *default_block) {
+      const intmax_t lo = cases.front().first;
+      const intmax_t range = cases.back().first - lo + 1;
+      const Value *idx = &rv_c; /* carried into the jump block, like the key */
+
+      if (key->size() == byte_size) {
+         /* ld a,c
+          * sub a,<lo>
+          * ld c,a
+          * cp a,<range>
+          */
+         block->instrs().push_back(new LoadInstruction(&rv_a, key));
+         if (lo != 0) {
+            block->instrs().push_back(new SubInstruction(&rv_a, value_pool().Imm(lo, byte_size)));
+         }
+         block->instrs().push_back(new LoadInstruction(idx, &rv_a));
+         if (range <= 0xff) {
+            block->instrs().push_back
+               (new CompInstruction(&rv_a, value_pool().Imm(range, byte_size)));
+            block->transitions().vec().push_back(new JumpTransition(default_block, Cond::NC));
+         }
+      } else {
+         /* ld hl,bc
+          * ld de,<-lo>
+          * add hl,de
+          * ld c,l
+          * ld de,<range>
+          * or a,a
+          * sbc hl,de
+          */
+         block->instrs().push_back(new LoadInstruction(&rv_hl, key));
+         if (lo != 0) {
+            const intmax_t neg_lo = (-lo) & size_mask(long_size);
+            block->instrs().push_back(new LoadInstruction(&rv_de,
+                                                          value_pool().Imm(neg_lo, long_size)));
+            block->instrs().push_back(new AddInstruction(&rv_hl, &rv_de));
+         }
+         block->instrs().push_back(new LoadInstruction(idx, &rv_l));
+         block->instrs().push_back(new LoadInstruction(&rv_de,
+                                                       value_pool().Imm(range, long_size)));
+         block->instrs().push_back(new OrInstruction(&rv_a, &rv_a));
+         block->instrs().push_back(new SbcInstruction(&rv_hl, &rv_de));
+         block->transitions().vec().push_back(new JumpTransition(default_block, Cond::NC));
+      }
+
+      /* entries are `jp <case>' (4 bytes each):
+       * ld hl,0
+       * ld l,c
+       * add hl,hl
+       * add hl,hl
+       * ld de,<table>
+       * add hl,de
+       * jp (hl)
+       */
+      Block *table = new Block(new_label("switch_table"));
+      Block *jump = new Block(new_label("switch_jump"));
+      jump->instrs().push_back(new LoadInstruction(&rv_hl, value_pool().Imm(0, long_size)));
+      jump->instrs().push_back(new LoadInstruction(&rv_l, idx));
+      jump->instrs().push_back(new AddInstruction(&rv_hl, &rv_hl));
+      jump->instrs().push_back(new AddInstruction(&rv_hl, &rv_hl));
+      jump->instrs().push_back(new LoadInstruction(&rv_de, new LabelValue(table->label())));
+      jump->instrs().push_back(new AddInstruction(&rv_hl, &rv_de));
+      jump->instrs().push_back(new JumpInstruction(value_pool().Mem(&rv_hl, long_size)));
+      jump->transitions().vec().push_back(new IndirectTransition(table));
+      block->transitions().vec().push_back(new JumpTransition(jump, Cond::ANY));
+
+      std::vector<Block *> entries(range, default_block);
+      for (const auto& pair : cases) {
+         entries[pair.first - lo] = pair.second;
+      }
+
+      Blocks targets;
+      for (Block *entry : entries) {
+         table->instrs().push_back(new JumpInstruction(new LabelValue(entry->label())));
+         if (targets.insert(entry).second) {
+            table->transitions().vec().push_back(new IndirectTransition(entry));
+         }
+      }
+   }
+
+   void emit_switch(Block *block, const Value *val, bool is_signed, SwitchCases cases,
+                    Block *default_block) {
+      const int bytes = val->size();
+
+      /* Bias signed values into unsigned keys, so that the search and the table bounds check
+       * can use unsigned comparisons. */
+      const intmax_t bias = is_signed ? (intmax_t(1) << (bytes * 8 - 1)) : 0;
+      for (auto& pair : cases) {
+         pair.first = (pair.first + bias) & size_mask(bytes);
+      }
+      std::sort(cases.begin(), cases.end(),
+                [](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; });
+
+      /* The key is read by every block of the dispatch, so it is kept in a fixed register rather
+       * than a variable, which block-level register allocation can't carry across blocks. */
+      const Value *key;
+      switch (bytes) {
+      case byte_size:
+         key = &rv_c;
+         if (is_signed) {
+            /* ld a,<val>
+             * xor a,0x80
+             * ld c,a
+             */
+            block->instrs().push_back(new LoadInstruction(&rv_a, val));
+            block->instrs().push_back(new XorInstruction(&rv_a, value_pool().Imm(bias, bytes)));
+            block->instrs().push_back(new LoadInstruction(key, &rv_a));
+         } else {
+            block->instrs().push_back(new LoadInstruction(key, val));
+         }
+         break;
+
+      case word_size:
+         /* The upper bytes of word registers are undefined, so the key is zero-extended:
+          * ld hl,<val>
+          * ld de,0x8000 (signed)
+          * add hl,de    (signed)
+          * ld bc,0
+          * ld b,h
+          * ld c,l
+          */
+         key = &rv_bc;
+         block->instrs().push_back(new LoadInstruction(&rv_hl, val));
+         if (is_signed) {
+            block->instrs().push_back(new LoadInstruction(&rv_de,
+                                                          value_pool().Imm(bias, long_size)));
+            block->instrs().push_back(new AddInstruction(&rv_hl, &rv_de));
+         }
+         block->instrs().push_back(new LoadInstruction(&rv_bc, value_pool().Imm(0, long_size)));
+         block->instrs().push_back(new LoadInstruction(&rv_b, &rv_h));
+         block->instrs().push_back(new LoadInstruction(&rv_c, &rv_l));
+         break;
+
+      case long_size:
+         key = &rv_bc;
+         if (is_signed) {
+            /* ld hl,<val>
+             * ld de,0x800000
+             * add hl,de
+             * ld bc,hl
+             */
+            block->instrs().push_back(new LoadInstruction(&rv_hl, val));
+            block->instrs().push_back(new LoadInstruction(&rv_de,
+                                                          value_pool().Imm(bias, long_size)));
+            block->instrs().push_back(new AddInstruction(&rv_hl, &rv_de));
+            block->instrs().push_back(new LoadInstruction(key, &rv_hl));
+         } else {
+            block->instrs().push_back(new LoadInstruction(key, val));
+         }
+         break;
+
+      default: abort();
+      }
+
+      if (cases.empty()) {
+         block->transitions().vec().push_back(new JumpTransition(default_block, Cond::ANY));
+         return;
+      }
+
+      const intmax_t range = cases.back().first - cases.front().first + 1;
+      if (g_optim.jump_tables && range <= 0x100 &&
+          switch_table_cost(bytes, range) < switch_tree_cost(bytes, cases.size())) {
+         switch_table(block, key, cases, default_block);
+      } else {
+         switch_tree(block, key, cases.begin(), cases.end(), default_block);
+      }
+   }
+
    void emit_invert_flag(Block *block, const FlagValue *flag) {
       switch (flag->cond_0()) {
       case Cond::Z:
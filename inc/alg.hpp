@@ -15,8 +15,7 @@ namespace zc::alg {
    typedef std::unordered_set<const z80::VariableValue *> VariableSet;
    typedef std::insert_iterator<VariableSet> VariableInserter;
    
-   typedef std::unordered_set<const z80::ByteRegister *> RegisterSet;
-   typedef std::insert_iterator<RegisterSet> RegisterInserter;
+   typedef z80::RegMask RegisterSet; /*!< byte registers, as a bitmask */
 
    typedef std::unordered_set<Cond> CondSet;
    typedef std::insert_iterator<CondSet> CondInserter;
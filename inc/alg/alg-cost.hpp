@@ -0,0 +1,66 @@
+/* static cost estimates */
+
+#ifndef __ALG_COST_HPP
+#define __ALG_COST_HPP
+
+#include <map>
+#include <string>
+#include <vector>
+#include <ostream>
+
+#include "asm.hpp"
+#include "cgen-fwd.hpp"
+
+namespace zc::alg {
+
+   class Loops;
+
+   /**
+    * Static size and cycle estimates of a function's blocks, from the instruction cost table,
+    * and the runtime library routines it calls. Loop nesting is taken from the block graph;
+    * each loop is assumed to iterate @see loop_trips times.
+    */
+   class CostReport {
+   public:
+      static constexpr int loop_trips = 10;
+
+      struct BlockCost {
+         const Block *block;
+         int depth; /*!< loop nesting depth */
+         z80::Cost cost;
+         int min_cycles() const { return cost.cycles; } /*!< no branch taken */
+         int max_cycles() const { return cost.cycles + cost.taken; } /*!< every branch taken */
+         long weighted_cycles() const; /*!< max cycles times trips of enclosing loops */
+      };
+
+      struct CrtCalls {
+         int calls = 0;
+         long weighted = 0; /*!< calls times trips of enclosing loops */
+      };
+
+      const std::vector<BlockCost>& blocks() const { return blocks_; } /*!< in emission order */
+      const std::map<std::string, CrtCalls>& crt_calls() const { return crt_calls_; }
+      int bytes() const { return bytes_; }
+      int min_cycles() const { return min_cycles_; } /*!< fastest path, ignoring back edges */
+      int max_cycles() const { return max_cycles_; } /*!< slowest path, ignoring back edges */
+      long weighted_cycles() const { return weighted_cycles_; }
+
+      void Dump(std::ostream& os) const;
+
+      explicit CostReport(const FunctionImpl& impl);
+
+   private:
+      const Block *entry_;
+      std::vector<BlockCost> blocks_;
+      std::map<std::string, CrtCalls> crt_calls_;
+      int bytes_ = 0;
+      int min_cycles_ = 0;
+      int max_cycles_ = 0;
+      long weighted_cycles_ = 0;
+
+      void ComputePaths(const Loops& loops);
+   };
+
+}
+
+#endif
@@ -1,14 +1,31 @@
 #ifndef __ALG_DAG
 #define __ALG_DAG
 
-#include <list>
+#include <unordered_map>
 
 #include "ast-fwd.hpp"
 
 namespace zc::alg {
 
-   typedef std::list<ASTExpr *> DAGSet;
-   
+   /**
+    * Hash-consing table of canonical expressions.
+    * Expressions are bucketed by ASTExpr::ExprHash(); collisions are resolved with
+    * ASTExpr::ExprEq(). Subexpressions must already be canonical (see ASTExpr::transform()).
+    */
+   class DAGSet {
+   public:
+      std::size_t size() const { return exprs_.size(); }
+
+      /**
+       * Look up canonical expression equal to @param expr, adding @param expr if none exists.
+       * @return canonical expression
+       */
+      ASTExpr *Intern(ASTExpr *expr);
+
+   private:
+      std::unordered_multimap<std::size_t, ASTExpr *> exprs_;
+   };
+
 }
 
 #endif
@@ -3,10 +3,129 @@
 #ifndef __ALG_LIVE_HPP
 #define __ALG_LIVE_HPP
 
-namespace zc {
+#include <cstdint>
+#include <vector>
+#include <unordered_map>
+#include <ostream>
+#include <string>
+
+#include "asm-fwd.hpp"
+#include "cgen-fwd.hpp"
+
+namespace zc::alg {
+
+   /**
+    * Fixed-size bit vector with word-parallel set operations.
+    */
+   class BitVector {
+   public:
+      std::size_t size() const { return size_; }
+
+      bool test(std::size_t i) const { return (words_[i / word_bits] >> (i % word_bits)) & 1; }
+      void set(std::size_t i) { words_[i / word_bits] |= Word(1) << (i % word_bits); }
+      void reset(std::size_t i) { words_[i / word_bits] &= ~(Word(1) << (i % word_bits)); }
+      std::size_t count() const;
+
+      BitVector& operator|=(const BitVector& other);
+      BitVector& operator-=(const BitVector& other); /*!< set difference */
+      bool operator==(const BitVector& other) const { return words_ == other.words_; }
+      bool operator!=(const BitVector& other) const { return words_ != other.words_; }
+
+      /**
+       * Apply function to index of each set bit, in increasing order.
+       */
+      template <typename Func>
+      void for_each(Func func) const {
+         for (std::size_t w = 0; w < words_.size(); ++w) {
+            for (Word word = words_[w]; word; word &= word - 1) {
+               func(w * word_bits + __builtin_ctzll(word));
+            }
+         }
+      }
+
+      BitVector(std::size_t size = 0): size_(size), words_((size + word_bits - 1) / word_bits) {}
+
+   private:
+      typedef uint64_t Word;
+      static constexpr std::size_t word_bits = 64;
+
+      std::size_t size_;
+      std::vector<Word> words_;
+   };
+
+   /**
+    * Dense numbering of the values tracked by liveness analysis: variables (by ID) and
+    * registers (multibyte registers are tracked through their byte registers).
+    */
+   class LiveSlots {
+   public:
+      std::size_t size() const { return names_.size(); }
+
+      /**
+       * Number value, if not already numbered.
+       */
+      void Add(const z80::Value *val);
+
+      /**
+       * Set bits of all slots occupied by value. Untracked values are ignored.
+       */
+      void Insert(const z80::Value *val, BitVector& bits) const;
+
+      /**
+       * @return whether any slot occupied by value is set, so that a register pair is live if
+       * either of its byte registers is; false if value is not tracked
+       */
+      bool Test(const z80::Value *val, const BitVector& bits) const;
+
+      const std::string& name(int slot) const { return names_.at(slot); }
+
+   private:
+      std::unordered_map<int, int> vars_; /*!< variable ID to slot */
+      std::unordered_map<const z80::Register *, int> regs_; /*!< register to slot */
+      std::vector<std::string> names_; /*!< slot to printable name */
+
+      template <typename Func>
+      void for_each_reg(const z80::Register *reg, Func func) const;
+   };
+
+   /**
+    * Global backward liveness over the block graph of a function.
+    * Block-level live-in/live-out sets are bit vectors indexed by @see LiveSlots.
+    */
+   class Liveness {
+   public:
+      const LiveSlots& slots() const { return slots_; }
+      int iterations() const { return iterations_; } /*!< passes until fixed point */
+
+      const BitVector& live_in(const Block *block) const { return infos_.at(block).live_in; }
+      const BitVector& live_out(const Block *block) const { return infos_.at(block).live_out; }
+      bool live_in(const Block *block, const z80::Value *val) const;
+      bool live_out(const Block *block, const z80::Value *val) const;
+
+      void Dump(std::ostream& os) const;
+
+      explicit Liveness(const FunctionImpl& impl);
+
+   private:
+      struct BlockInfo {
+         BitVector use; /*!< upward-exposed uses */
+         BitVector def;
+         BitVector live_in;
+         BitVector live_out;
+         std::vector<const Block *> succs;
+      };
+
+      LiveSlots slots_;
+      std::vector<const Block *> postorder_;
+      std::unordered_map<const Block *, BlockInfo> infos_;
+      int iterations_ = 0;
+
+      void ComputeOrder(const FunctionImpl& impl);
+      void ComputeLocal();
+      void Solve();
+      bool test(const BitVector& bits, const z80::Value *val) const;
+   };
 
-   
-   
 }
 
 #endif
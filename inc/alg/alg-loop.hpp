@@ -0,0 +1,68 @@
+/* loop detection */
+
+#ifndef __ALG_LOOP_HPP
+#define __ALG_LOOP_HPP
+
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <ostream>
+
+#include "cgen-fwd.hpp"
+
+namespace zc::alg {
+
+   /**
+    * Natural loop: a header and the blocks that reach a back edge to it without passing
+    * through the header.
+    */
+   struct Loop {
+      Block *header;
+      std::vector<Block *> blocks; /*!< in reverse postorder, starting with the header */
+      std::vector<Block *> latches; /*!< sources of back edges */
+      int parent = -1; /*!< index of innermost enclosing loop; -1 if outermost */
+      int depth = 1; /*!< nesting depth */
+      std::unordered_set<const Block *> members;
+
+      bool contains(const Block *block) const { return members.find(block) != members.end(); }
+   };
+
+   /**
+    * Dominators and natural loops of the block graph of a function, rooted at its entry.
+    * Loops sharing a header are merged. Blocks unreachable from the entry belong to no loop.
+    */
+   class Loops {
+   public:
+      const std::vector<Loop>& loops() const { return loops_; } /*!< innermost first */
+      const std::vector<Block *>& order() const { return rpo_; } /*!< reverse postorder */
+      const std::vector<Block *>& preds(const Block *block) const { return preds_.at(block); }
+
+      /**
+       * @return whether every path from the entry to @p b passes through @p a
+       */
+      bool dominates(const Block *a, const Block *b) const;
+
+      /**
+       * @return number of loops containing block; 0 outside loops
+       */
+      int depth(const Block *block) const;
+
+      void Dump(std::ostream& os) const;
+
+      explicit Loops(const FunctionImpl& impl);
+
+   private:
+      std::vector<Block *> rpo_;
+      std::unordered_map<const Block *, int> index_; /*!< block to position in reverse postorder */
+      std::unordered_map<const Block *, std::vector<Block *>> preds_;
+      std::vector<int> idoms_; /*!< immediate dominators, by reverse postorder position */
+      std::vector<Loop> loops_;
+
+      void ComputeOrder(const FunctionImpl& impl);
+      void ComputeDominators();
+      void ComputeLoops();
+   };
+
+}
+
+#endif
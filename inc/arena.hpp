@@ -0,0 +1,46 @@
+#ifndef __ARENA_HPP
+#define __ARENA_HPP
+
+#include <cstddef>
+#include <vector>
+
+namespace zc {
+
+   /**
+    * Bump allocator for objects that live as long as the translation unit.
+    * Objects are never freed individually; all memory is reclaimed at once by @see Release().
+    */
+   class Arena {
+   public:
+      std::size_t bytes() const { return bytes_; } /*!< bytes handed out */
+      std::size_t reserved() const { return reserved_; } /*!< bytes obtained from the heap */
+      std::size_t allocs() const { return allocs_; } /*!< number of allocations */
+
+      void *Allocate(std::size_t size, std::size_t align = alignof(std::max_align_t));
+
+      /**
+       * Free all memory in arena. Objects allocated from it must no longer be used.
+       */
+      void Release();
+
+      Arena(std::size_t chunk_size = 1 << 16): chunk_size_(chunk_size) {}
+      Arena(const Arena&) = delete;
+      Arena& operator=(const Arena&) = delete;
+      ~Arena() { Release(); }
+
+   private:
+      std::size_t chunk_size_;
+      std::vector<char *> chunks_;
+      char *cur_ = nullptr;
+      char *end_ = nullptr;
+      std::size_t bytes_ = 0;
+      std::size_t reserved_ = 0;
+      std::size_t allocs_ = 0;
+   };
+
+   Arena& ast_arena(); /*!< AST nodes and types */
+   Arena& ir_arena(); /*!< IR values and instructions */
+
+}
+
+#endif
@@ -3,6 +3,7 @@
 
 #include <vector>
 #include <list>
+#include <cstdint>
 
 #include "asm/asm-mode.hpp"
 #include "util.hpp"
@@ -11,7 +12,6 @@ namespace zc::z80 {
 
    /* asm-val */
    class Value;
-   typedef std::vector< portal<const Value *> > Values;
    class VariableValue;
    class FlagValue;
    class ImmediateValue;
@@ -23,13 +23,19 @@ namespace zc::z80 {
    class ByteValue;
 
    /* asm-reg */
+   typedef uint16_t RegMask; /*!< set of byte registers; see RegIndex */
    class Register;
    class ByteRegister;
    class MultibyteRegister;
    
    /* asm-instr */
+   enum class Opcode: uint8_t;
+   class Operands;
    class Instruction;
    typedef std::list<Instruction *> Instructions;   
+
+   /* asm-cost */
+   struct Cost;
    
    /* asm-cond */
    class Flag;
@@ -16,9 +16,11 @@ namespace zc::z80 {
 #include "asm/asm-lab.hpp"
 #include "asm/asm-reg.hpp"
 #include "asm/asm-val.hpp"
+#include "asm/asm-pool.hpp"
 #include "asm/asm-mode.hpp"
 #include "asm/asm-cond.hpp"
 #include "asm/asm-proto.hpp"
 #include "asm/asm-crt.hpp"
+#include "asm/asm-cost.hpp"
 
 #endif
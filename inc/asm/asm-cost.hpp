@@ -0,0 +1,64 @@
+#ifndef __ASM_HPP
+#error "include \"asm.hpp\""
+#endif
+
+#ifndef __ASM_COST_HPP
+#define __ASM_COST_HPP
+
+#include "asm-fwd.hpp"
+#include "asm/asm-mode.hpp"
+
+namespace zc::z80 {
+
+   /**
+    * eZ80 execution modes. In ADL mode, addresses, immediates and register pairs are 24 bits
+    * wide; in Z80 mode, 16 bits.
+    */
+   enum class CpuMode {ADL, Z80};
+   constexpr CpuMode cpu_mode = (long_size == 3) ? CpuMode::ADL : CpuMode::Z80;
+
+   /**
+    * Operand addressing modes, as far as they determine an instruction's encoding.
+    */
+   enum class AddrMode {
+      NONE,
+      REG,      /*!< a, b, c, d, e, h, l */
+      IDX_REG,  /*!< ixh, ixl, iyh, iyl */
+      PAIR,     /*!< af, bc, de, hl */
+      IDX_PAIR, /*!< ix, iy */
+      SP,       /*!< sp */
+      IMM,      /*!< n or Mmn; includes label addresses */
+      IDX_OFF,  /*!< ix+d, iy+d as an address (lea, pea) */
+      IND_PAIR, /*!< (bc), (de), (hl) */
+      IND_SP,   /*!< (sp) */
+      IND_IDX,  /*!< (ix+d), (iy+d) */
+      IND_ABS,  /*!< (Mmn) */
+   };
+
+   /**
+    * Addressing mode of operand. Variables not yet allocated are taken to be in registers;
+    * frame indices are immediates.
+    */
+   AddrMode addr_mode(const Value *val);
+
+   /**
+    * Encoded size and execution time, assuming zero wait states: a cycle per byte fetched,
+    * read or written, plus internal cycles.
+    */
+   struct Cost {
+      int bytes = 0;
+      int cycles = 0; /*!< when not branching, for conditional instructions */
+      int taken = 0; /*!< extra cycles when conditional branch or return is taken */
+
+      Cost& operator+=(const Cost& other) {
+         bytes += other.bytes;
+         cycles += other.cycles;
+         taken += other.taken;
+         return *this;
+      }
+      Cost operator+(const Cost& other) const { return Cost(*this) += other; }
+   };
+
+}
+
+#endif
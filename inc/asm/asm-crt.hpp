@@ -17,6 +17,18 @@ namespace zc::z80 {
       const Label *label(const std::string& name);
       const LabelValue *val(const std::string& name);
 
+      /**
+       * Check whether label refers to a runtime routine that only clobbers its result registers.
+       * NOTE: `__indcall' is excluded, since it transfers control to an arbitrary function.
+       */
+      bool preserves_regs(const Label *label) const;
+
+      /**
+       * Check whether label names a runtime routine. Unlike @see preserves_regs, compares by name,
+       * so labels made outside this table (e.g. for `__indcall') are recognized.
+       */
+      bool contains(const Label *label) const;
+
       template <typename... Args>
       CRT(Args... args): map_(args...) {}
 
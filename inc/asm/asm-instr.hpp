@@ -2,31 +2,92 @@
 #define __ASM_INSTR_HPP
 
 #include <list>
-#include <vector>
+#include <array>
+#include <optional>
+#include <cassert>
+#include <initializer_list>
 
 #include "asm-fwd.hpp"
 #include "asm/asm-reg.hpp"
 #include "asm/asm-val.hpp"
 #include "asm/asm-lab.hpp"
 #include "asm/asm-cond.hpp"
+#include "asm/asm-cost.hpp"
 
 #include "cgen.hpp"
 #include "util.hpp"
 #include "alg.hpp"
+#include "arena.hpp"
 
 namespace zc::z80 {
+
+   /**
+    * Instruction opcodes. Mnemonics are given by @see mnemonic().
+    */
+   enum class Opcode: uint8_t {
+      ADC, ADD, AND, CALL, CCF, CP, CPL, DEC, DJNZ, EX, INC, JP, JR, LD, LEA, MLT, NEG, OR, PEA,
+      POP, PUSH, RET, RET_CC, RL, RLC, RR, RRC, SBC, SCF, SLA, SRA, SRL, SUB, XOR,
+      LABEL, /*!< pseudo-instruction */
+   };
+   constexpr std::size_t opcode_count = static_cast<std::size_t>(Opcode::LABEL) + 1;
+
+   const char *mnemonic(Opcode opcode);
+
+   /**
+    * Operand list stored inline; eZ80 instructions take at most two operands.
+    */
+   class Operands {
+   public:
+      typedef portal<const Value *> value_type;
+      typedef value_type *iterator;
+      typedef const value_type *const_iterator;
+      static constexpr std::size_t capacity = 2;
+
+      std::size_t size() const { return size_; }
+      bool empty() const { return size_ == 0; }
+
+      iterator begin() { return slots_.data(); }
+      iterator end() { return slots_.data() + size_; }
+      const_iterator begin() const { return slots_.data(); }
+      const_iterator end() const { return slots_.data() + size_; }
+
+      value_type& operator[](std::size_t i) { return slots_[i]; }
+      const value_type& operator[](std::size_t i) const { return slots_[i]; }
+
+      Operands(): size_(0) {}
+      Operands(std::initializer_list<value_type> operands): size_(operands.size()) {
+         assert(operands.size() <= capacity);
+         std::copy(operands.begin(), operands.end(), slots_.begin());
+      }
+
+   private:
+      std::array<value_type, capacity> slots_;
+      uint8_t size_;
+   };
    
    class Instruction {
    public:
-      const Value *dst() const { return (operands().size() >= 1) ? *operands().front() : nullptr; }
-      const Value *src() const {
-         return (operands().size() >= 2) ? **++operands().begin() : nullptr;
-      }
-      const Values& operands() const { return operands_; }
-      Values& operands() { return operands_; }
-      const std::string& name() const { return name_; }
+      /* Instructions live in the translation unit's IR arena, like values. */
+      static void *operator new(std::size_t size) { return ir_arena().Allocate(size); }
+      static void operator delete(void *ptr) {}
+
+      const Value *dst() const { return (operands().size() >= 1) ? *operands()[0] : nullptr; }
+      const Value *src() const { return (operands().size() >= 2) ? *operands()[1] : nullptr; }
+      const Operands& operands() const { return operands_; }
+      Operands& operands() { return operands_; }
+      Opcode opcode() const { return opcode_; }
+      const char *name() const { return mnemonic(opcode_); }
+      const std::optional<Cond>& cond() const { return cond_; }
       FlagMod flagmod(const Flag& flag) const;
 
+      /**
+       * Size and execution time. Pseudo-instructions are costed as the instructions they
+       * resolve to.
+       */
+      Cost cost(CpuMode mode = cpu_mode) const;
+      int bytes(CpuMode mode = cpu_mode) const { return cost(mode).bytes; }
+      int cycles(CpuMode mode = cpu_mode) const { return cost(mode).cycles; }
+
       virtual void Kill(alg::ValueInserter vals) const {}
       virtual void Kill(alg::CondInserter conds) const {}
       virtual void Gen(alg::ValueInserter vals) const {}
@@ -46,18 +107,18 @@ namespace zc::z80 {
       virtual bool Match(const Instruction *to) const;
       
    protected:
-      std::string name_;
-      Values operands_;
+      Operands operands_;
+      Opcode opcode_;
       std::optional<Cond> cond_;
 
       virtual void Resolve_(Instructions& out) { out.push_back(this); }
       
-      Instruction(const std::string& name): name_(name), operands_(), cond_(std::nullopt) {}
-      Instruction(Cond cond, const std::string& name): name_(name), operands_(), cond_(cond) {}
-      Instruction(const Values& operands, const std::string& name):
-         name_(name), operands_(operands), cond_(std::nullopt) {}
-      Instruction(const Values& operands, Cond cond, const std::string& name):
-         name_(name), operands_(operands), cond_(cond) {}
+      Instruction(Opcode opcode): operands_(), opcode_(opcode), cond_(std::nullopt) {}
+      Instruction(Cond cond, Opcode opcode): operands_(), opcode_(opcode), cond_(cond) {}
+      Instruction(const Operands& operands, Opcode opcode):
+         operands_(operands), opcode_(opcode), cond_(std::nullopt) {}
+      Instruction(const Operands& operands, Cond cond, Opcode opcode):
+         operands_(operands), opcode_(opcode), cond_(cond) {}
    };
 
    class BinaryInstruction: public Instruction {
@@ -73,7 +134,7 @@ namespace zc::z80 {
    protected:
       template <typename... Args>
       BinaryInstruction(portal<const Value *> dst, portal<const Value *> src, Args... args):
-         Instruction(Values {dst, src}, args...) {}
+         Instruction(Operands {dst, src}, args...) {}
    };
 
    class UnaryInstruction: public Instruction {
@@ -89,7 +150,7 @@ namespace zc::z80 {
    protected:
       template <typename... Args>
       UnaryInstruction(const Value *dst, Args... args):
-         Instruction(Values {dst}, args...) {}
+         Instruction(Operands {dst}, args...) {}
    };
 
    class BitwiseInstruction: public BinaryInstruction {
@@ -167,7 +228,7 @@ namespace zc::z80 {
       }
       
       template <typename... Args>
-      AdcInstruction(Args... args): BinaryInstruction(args..., "adc") {}
+      AdcInstruction(Args... args): BinaryInstruction(args..., Opcode::ADC) {}
    };
 
    
@@ -179,7 +240,7 @@ namespace zc::z80 {
       virtual void Kill(alg::CondInserter conds) const override;
       
       template <typename... Args>
-      AddInstruction(Args... args): BinaryInstruction(args..., "add") {}
+      AddInstruction(Args... args): BinaryInstruction(args..., Opcode::ADD) {}
    };
 
    /**
@@ -188,7 +249,7 @@ namespace zc::z80 {
    class AndInstruction: public BitwiseInstruction {
    public:
       template <typename... Args>
-      AndInstruction(Args... args): BitwiseInstruction(args..., "and") {}
+      AndInstruction(Args... args): BitwiseInstruction(args..., Opcode::AND) {}
    };
 
    /**
@@ -196,6 +257,8 @@ namespace zc::z80 {
     */
    class CallInstruction: public UnaryInstruction {
    public:
+      RegMask args() const { return args_; } /*!< registers arguments are passed in */
+      
       /* TODO -- this might need to be marked as using everything... */
       virtual void Gen(alg::ValueInserter vals) const override;
       virtual void Kill(alg::CondInserter conds) const override {
@@ -204,7 +267,12 @@ namespace zc::z80 {
       virtual void Kill(alg::ValueInserter vals) const override;      
       
       template <typename... Args>
-      CallInstruction(Args... args): UnaryInstruction(args..., "call") {}
+      CallInstruction(Args... args): UnaryInstruction(args..., Opcode::CALL) {}
+      CallInstruction(const Value *dst, RegMask args):
+         UnaryInstruction(dst, Opcode::CALL), args_(args) {}
+
+   private:
+      RegMask args_ = 0;
    };
 
    /**
@@ -220,7 +288,7 @@ namespace zc::z80 {
       }
       
       template <typename... Args>
-      CcfInstruction(Args... args): Instruction(args..., "ccf") {}
+      CcfInstruction(Args... args): Instruction(args..., Opcode::CCF) {}
    };   
 
    /**
@@ -234,7 +302,7 @@ namespace zc::z80 {
       virtual void Kill(alg::ValueInserter vals) const override {}
 
       template <typename... Args>
-      CompInstruction(Args... args): BinaryInstruction(args..., "cp") {}
+      CompInstruction(Args... args): BinaryInstruction(args..., Opcode::CP) {}
    };
 
    /**
@@ -246,7 +314,7 @@ namespace zc::z80 {
       virtual void Gen(alg::ValueInserter vals) const override;      
       
       template <typename... Args>
-      CplInstruction(Args... args): Instruction(args..., "cpl") {}
+      CplInstruction(Args... args): Instruction(args..., Opcode::CPL) {}
    };
 
    /**
@@ -255,7 +323,7 @@ namespace zc::z80 {
    class DecInstruction: public IncDecInstruction {
    public:
       template <typename... Args>
-      DecInstruction(Args... args): IncDecInstruction(args..., "dec") {}
+      DecInstruction(Args... args): IncDecInstruction(args..., Opcode::DEC) {}
    };
    
    /**
@@ -267,7 +335,7 @@ namespace zc::z80 {
       virtual void Gen(alg::ValueInserter vals) const override;
 
       template <typename... Args>
-      DjnzInstruction(Args... args): UnaryInstruction(args..., "djnz") {}
+      DjnzInstruction(Args... args): UnaryInstruction(args..., Opcode::DJNZ) {}
    };
 
    /**
@@ -278,7 +346,7 @@ namespace zc::z80 {
       /* TODO -- Kill and Gen are nuanced. */
       
       template <typename... Args>
-      ExInstruction(Args... args): BinaryInstruction(args..., "ex") {}
+      ExInstruction(Args... args): BinaryInstruction(args..., Opcode::EX) {}
    };
 
    /**
@@ -287,7 +355,7 @@ namespace zc::z80 {
    class IncInstruction: public IncDecInstruction {
    public:
       template <typename... Args>
-      IncInstruction(Args... args): IncDecInstruction(args..., "inc") {}
+      IncInstruction(Args... args): IncDecInstruction(args..., Opcode::INC) {}
    };
 
    /**
@@ -295,11 +363,13 @@ namespace zc::z80 {
     */
    class JumpInstruction: public UnaryInstruction {
    public:
+      bool is_conditional() const { return cond_ && *cond_ != Cond::ANY; }
+
       virtual void Kill(alg::ValueInserter vals) const override {}
-      virtual void Gen(alg::ValueInserter vals) const override {}
+      virtual void Gen(alg::ValueInserter vals) const override; /*!< target of `jp (rr)' */
       
       template <typename... Args>
-      JumpInstruction(Args... args): UnaryInstruction(args..., "jp") {}
+      JumpInstruction(Args... args): UnaryInstruction(args..., Opcode::JP) {}
    protected:
    };
    
@@ -311,7 +381,7 @@ namespace zc::z80 {
       virtual void Emit(std::ostream& os) const override;
       
       template <typename... Args>
-      JrInstruction(Args... args): UnaryInstruction(args..., "jr") {}
+      JrInstruction(Args... args): UnaryInstruction(args..., Opcode::JR) {}
    };
 
    /**
@@ -323,7 +393,7 @@ namespace zc::z80 {
       virtual void Gen(alg::ValueInserter vals) const override;
       
       template <typename... Args>
-      LoadInstruction(Args... args): BinaryInstruction(args..., "ld") {}
+      LoadInstruction(Args... args): BinaryInstruction(args..., Opcode::LD) {}
 
    protected:
       virtual void Resolve_(Instructions& out) override;      
@@ -337,7 +407,7 @@ namespace zc::z80 {
       virtual void Gen(alg::ValueInserter vals) const override {}
       
       template <typename... Args>
-      LeaInstruction(Args... args): BinaryInstruction(args..., "lea") {}
+      LeaInstruction(Args... args): BinaryInstruction(args..., Opcode::LEA) {}
    };
 
    /**
@@ -346,7 +416,7 @@ namespace zc::z80 {
    class MultInstruction: public UnaryInstruction {
    public:
       template <typename... Args>
-      MultInstruction(Args... args): UnaryInstruction(args..., "mlt") {}
+      MultInstruction(Args... args): UnaryInstruction(args..., Opcode::MLT) {}
    };
 
    /**
@@ -361,7 +431,7 @@ namespace zc::z80 {
       virtual void Gen(alg::ValueInserter vals) const override;
 
       template <typename... Args>
-      NegInstruction(Args... args): Instruction(args..., "neg") {}
+      NegInstruction(Args... args): Instruction(args..., Opcode::NEG) {}
    };
 
    /**
@@ -370,7 +440,7 @@ namespace zc::z80 {
    class OrInstruction: public BitwiseInstruction {
    public:
       template <typename... Args>
-      OrInstruction(Args... args): BitwiseInstruction(args..., "or") {}
+      OrInstruction(Args... args): BitwiseInstruction(args..., Opcode::OR) {}
    };
 
    /**
@@ -381,7 +451,7 @@ namespace zc::z80 {
       virtual void Gen(alg::ValueInserter vals) const override {}
       
       template <typename... Args>
-      PeaInstruction(Args... args): UnaryInstruction(args..., "pea") {}
+      PeaInstruction(Args... args): UnaryInstruction(args..., Opcode::PEA) {}
    };
 
    /**
@@ -392,7 +462,7 @@ namespace zc::z80 {
       virtual void Gen(alg::ValueInserter vals) const override {}
 
       template <typename... Args>
-      PopInstruction(Args... args): UnaryInstruction(args..., "pop") {}
+      PopInstruction(Args... args): UnaryInstruction(args..., Opcode::POP) {}
    };
 
    /**
@@ -400,10 +470,11 @@ namespace zc::z80 {
     */
    class PushInstruction: public UnaryInstruction {
    public:
-      virtual void Gen(alg::ValueInserter vals) const override {}
+      virtual void Kill(alg::ValueInserter vals) const override {}
+      virtual void Gen(alg::ValueInserter vals) const override { dst()->Gen(vals); }
 
       template <typename... Args>
-      PushInstruction(Args... args): UnaryInstruction(args..., "push") {}
+      PushInstruction(Args... args): UnaryInstruction(args..., Opcode::PUSH) {}
    };
 
    /**
@@ -412,22 +483,22 @@ namespace zc::z80 {
    class RetInstruction: public Instruction {
    public:
       template <typename... Args>
-      RetInstruction(Args... args): Instruction(args..., "ret") {}
+      RetInstruction(Args... args): Instruction(args..., Opcode::RET) {}
    };
 
    /**
     * "RET cc" instruction class
     */
-   class RetCondInstruction: public RetInstruction {
+   class RetCondInstruction: public Instruction {
    public:
-      const FlagState *cond() const { return cond_; }
+      const FlagState *flags() const { return flags_; }
 
       template <typename... Args>
-      RetCondInstruction(const FlagState *cond, Args... args):
-         RetInstruction(args...), cond_(cond) {}
+      RetCondInstruction(const FlagState *flags, Args... args):
+         Instruction(args..., Opcode::RET_CC), flags_(flags) {}
       
    protected:
-      const FlagState *cond_;
+      const FlagState *flags_;
    };
    
    /**
@@ -436,7 +507,7 @@ namespace zc::z80 {
    class RlInstruction: public RotateCarryInstruction {
    public:
       template <typename... Args>
-      RlInstruction(Args... args): RotateCarryInstruction(args..., "rl") {}
+      RlInstruction(Args... args): RotateCarryInstruction(args..., Opcode::RL) {}
    };
 
    /**
@@ -445,7 +516,7 @@ namespace zc::z80 {
    class RlcInstruction: public RotateInstruction {
    public:
       template <typename... Args>
-      RlcInstruction(Args... args): RotateInstruction(args..., "rlc") {}
+      RlcInstruction(Args... args): RotateInstruction(args..., Opcode::RLC) {}
    };
 
    /**
@@ -454,7 +525,7 @@ namespace zc::z80 {
    class RrInstruction: public RotateCarryInstruction {
    public:
       template <typename... Args>
-      RrInstruction(Args... args): RotateCarryInstruction(args..., "rr") {}
+      RrInstruction(Args... args): RotateCarryInstruction(args..., Opcode::RR) {}
    };
 
    /**
@@ -463,7 +534,7 @@ namespace zc::z80 {
    class RrcInstruction: public RotateInstruction {
    public:
       template <typename... Args>
-      RrcInstruction(Args... args): RotateInstruction(args..., "rrc") {}
+      RrcInstruction(Args... args): RotateInstruction(args..., Opcode::RRC) {}
    };
 
    /**
@@ -481,7 +552,7 @@ namespace zc::z80 {
       }
       
       template <typename... Args>
-      SbcInstruction(Args... args): BinaryInstruction(args..., "sbc") {}
+      SbcInstruction(Args... args): BinaryInstruction(args..., Opcode::SBC) {}
    };
 
    /**
@@ -492,7 +563,7 @@ namespace zc::z80 {
       virtual void Kill(alg::CondInserter conds) const override { *conds++ = Cond::C; }
       
       template <typename... Args>
-      ScfInstruction(Args... args): Instruction(args..., "scf") {}
+      ScfInstruction(Args... args): Instruction(args..., Opcode::SCF) {}
    };
 
    /**
@@ -505,7 +576,7 @@ namespace zc::z80 {
       }
       
       template <typename... Args>
-      SlaInstruction(Args... args): UnaryInstruction(args..., "sla") {}
+      SlaInstruction(Args... args): UnaryInstruction(args..., Opcode::SLA) {}
    };
 
    /**
@@ -518,7 +589,7 @@ namespace zc::z80 {
       }
       
       template <typename... Args>
-      SraInstruction(Args... args): UnaryInstruction(args..., "sra") {}
+      SraInstruction(Args... args): UnaryInstruction(args..., Opcode::SRA) {}
    };
 
    /**
@@ -531,7 +602,7 @@ namespace zc::z80 {
       }
       
       template <typename... Args>
-      SrlInstruction(Args... args): UnaryInstruction(args..., "srl") {}
+      SrlInstruction(Args... args): UnaryInstruction(args..., Opcode::SRL) {}
    };
    
    /**
@@ -544,7 +615,7 @@ namespace zc::z80 {
       }
       
       template <typename... Args>
-      SubInstruction(Args... args): BinaryInstruction(args..., "sub") {}
+      SubInstruction(Args... args): BinaryInstruction(args..., Opcode::SUB) {}
    };
    
    /**
@@ -553,7 +624,7 @@ namespace zc::z80 {
    class XorInstruction: public BitwiseInstruction {
    public:
       template <typename... Args>
-      XorInstruction(Args... args): BitwiseInstruction(args..., "xor") {}
+      XorInstruction(Args... args): BitwiseInstruction(args..., Opcode::XOR) {}
    };
 
    /*** PSEUDO-INSTRUCTIONS ***/
@@ -561,12 +632,14 @@ namespace zc::z80 {
    class LabelInstruction: public Instruction {
    public:
       template <typename... Args>
-      LabelInstruction(const Label *label): Instruction("%label"), label_(label) {}
+      LabelInstruction(const Label *label): Instruction(Opcode::LABEL), label_(label) {}
+
+      const Label *label() const { return label_; }
 
       virtual void Emit(std::ostream& os) const override { label_->EmitDef(os); }
       virtual bool Eq(const Instruction *other) const override {
-         auto other_ = dynamic_cast<const LabelInstruction *>(other);
-         return other_ && label_->Eq(other_->label_);
+         return other->opcode() == Opcode::LABEL &&
+            label_->Eq(static_cast<const LabelInstruction *>(other)->label_);
       }
       virtual bool Match(const Instruction *to) const override { return Eq(to); }
       
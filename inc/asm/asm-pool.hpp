@@ -0,0 +1,75 @@
+#ifndef __ASM_HPP
+#error "include \"asm.hpp\""
+#endif
+
+#ifndef __ASM_POOL_HPP
+#define __ASM_POOL_HPP
+
+#include <tuple>
+#include <unordered_map>
+
+#include "asm-fwd.hpp"
+#include "asm/asm-val.hpp"
+#include "util.hpp"
+
+namespace zc::z80 {
+
+   /**
+    * Interning factory for immutable values.
+    * Equal values obtained from the pool share one object, so they compare equal by pointer
+    * (@see Value::Eq). Only concrete values are interned; pattern values used for matching
+    * bind through pointers and must still be constructed directly.
+    */
+   class ValuePool {
+   public:
+      std::size_t size() const; /*!< number of distinct values interned */
+
+      const ImmediateValue *Imm(intmax_t imm, int size);
+      const RegisterValue *Reg(const Register *reg);
+      const RegisterValue *Reg(const Register *reg, int size);
+      const IndexedRegisterValue *Indexed(const RegisterValue *val,
+                                          const IndexedRegisterValue::Index& index);
+      const FrameValue *Frame(FrameValue::FrameIndices *indices,
+                              FrameValue::FrameIndices::iterator pos, bool negate = false);
+
+      /**
+       * @param addr address value; should itself be interned, since it is keyed by pointer
+       */
+      const MemoryValue *Mem(const Value *addr, int size);
+
+      /**
+       * Forget all interned values. Must be called when the IR arena they live in is released.
+       */
+      void Clear();
+
+      ValuePool() { Clear(); }
+      ValuePool(const ValuePool&) = delete;
+      ValuePool& operator=(const ValuePool&) = delete;
+
+   private:
+      template <typename... Ts>
+      struct KeyHash {
+         std::size_t operator()(const std::tuple<Ts...>& key) const {
+            return std::apply([](const auto&... elems) {
+                                 std::size_t seed = 0;
+                                 ((seed = hash_combine(seed, elems)), ...);
+                                 return seed;
+                              }, key);
+         }
+      };
+
+      template <class T, typename... Ts>
+      using Table = std::unordered_map<std::tuple<Ts...>, const T *, KeyHash<Ts...>>;
+
+      Table<ImmediateValue, intmax_t, int> imms_;
+      Table<RegisterValue, const Register *, int> regs_;
+      Table<IndexedRegisterValue, const RegisterValue *, IndexedRegisterValue::Index> indexeds_;
+      Table<FrameValue, const FrameValue::FrameIndices *, const int8_t *, bool> frames_;
+      Table<MemoryValue, const Value *, int> mems_;
+   };
+
+   ValuePool& value_pool(); /*!< values of the current translation unit */
+
+}
+
+#endif
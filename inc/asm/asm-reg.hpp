@@ -14,6 +14,20 @@
 
 namespace zc::z80 {
 
+   /**
+    * Bit index of each byte register in a register mask (@see RegMask).
+    */
+   enum RegIndex {REG_A, REG_B, REG_C, REG_D, REG_E, REG_F, REG_H, REG_L, REG_IXH, REG_IXL,
+                  REG_IYH, REG_IYL, REG_COUNT};
+
+   constexpr RegMask reg_mask(RegIndex index) { return RegMask(1) << index; }
+   constexpr RegMask mask_af = reg_mask(REG_A) | reg_mask(REG_F);
+   constexpr RegMask mask_bc = reg_mask(REG_B) | reg_mask(REG_C);
+   constexpr RegMask mask_de = reg_mask(REG_D) | reg_mask(REG_E);
+   constexpr RegMask mask_hl = reg_mask(REG_H) | reg_mask(REG_L);
+   constexpr RegMask mask_ix = reg_mask(REG_IXH) | reg_mask(REG_IXL);
+   constexpr RegMask mask_iy = reg_mask(REG_IYH) | reg_mask(REG_IYL);
+
    extern const ByteRegister r_a, r_b, r_c, r_d, r_e, r_f, r_h, r_l, r_ixh,
       r_ixl, r_iyh, r_iyl;
    extern const MultibyteRegister r_af, r_bc, r_de, r_hl, r_ix, r_iy, r_sp;
@@ -21,6 +35,11 @@ namespace zc::z80 {
    extern const RegisterValue rv_a, rv_b, rv_c, rv_d, rv_e, rv_f, rv_h, rv_l, rv_ixh,
       rv_ixl, rv_iyh, rv_iyl;
    extern const RegisterValue rv_af, rv_bc, rv_de, rv_hl, rv_ix, rv_iy, rv_sp;
+
+   /**
+    * @return byte register with given bit index
+    */
+   const ByteRegister *byte_reg(RegIndex index);
    
    /*************
     * REGISTERS *
@@ -37,6 +56,12 @@ namespace zc::z80 {
       virtual int size() const = 0;
       virtual const Register *high() const = 0;
       virtual const Register *low() const = 0;
+
+      /**
+       * Byte registers this register consists of. Empty for the stack pointer.
+       */
+      RegMask mask() const { return mask_; }
+      bool overlaps(const Register *other) const { return (mask() & other->mask()) != 0; }
       
       void Emit(std::ostream& os) const { os << name(); }
       virtual void Cast(Block *block, const Register *from) const = 0;
@@ -47,28 +72,12 @@ namespace zc::z80 {
 
    protected:
       const char *name_;
+      RegMask mask_;
 
-      virtual bool Eq_(const Register *other) const = 0;
-
-      constexpr Register(const char *name): name_(name) {}
+      Register(const char *name, RegMask mask): name_(name), mask_(mask) {}
    };
 
-   template <class Derived>
-   class Register_: public Register {
-   public:
-   protected:
-      virtual bool Eq_(const Register *other) const override {
-         auto derived = dynamic_cast<const Derived *>(other);
-         return derived ? Eq_aux(derived) : false;
-      }
-
-      virtual bool Eq_aux(const Derived *other) const = 0;
-      
-      template <typename... Args>
-      Register_(Args... args): Register(args...) {}
-   };
-
-   class ByteRegister: public Register_<ByteRegister> {
+   class ByteRegister: public Register {
    public:
       virtual Kind kind() const override { return Kind::REG_BYTE; }
       virtual int size() const override { return byte_size; }
@@ -79,37 +88,29 @@ namespace zc::z80 {
 
       virtual void Cast(Block *block, const Register *from) const override;
       
-      template <typename... Args>
-      constexpr ByteRegister(Args... args): Register_(args...) {}
-      
-   protected:
-      virtual bool Eq_aux(const ByteRegister *other) const override { return true; }
+      ByteRegister(const char *name, RegIndex index): Register(name, reg_mask(index)) {}
    };
 
-   class MultibyteRegister: public Register_<MultibyteRegister> {
+   class MultibyteRegister: public Register {
    public:
       virtual int size() const override { return long_size; }
       typedef std::vector<const ByteRegister *> ByteRegs;
       // typedef std::array<const ByteRegister *, word_size> ByteRegs;
       virtual Kind kind() const override { return Kind::REG_MULTIBYTE; }
       const ByteRegs& regs() const { return regs_; }
-      bool contains(const Register *reg) const;
+      bool contains(const Register *reg) const {
+         return reg->kind() == Kind::REG_BYTE && overlaps(reg);
+      }
       virtual const Register *high() const override { return regs()[0]; }
       virtual const Register *low() const override { return regs()[1]; }
       
       virtual void Cast(Block *block, const Register *from) const override;
 
-
-      template <typename... Args>
-      constexpr MultibyteRegister(Args... args): Register_(args...) {}
-      template <typename... Args>
-      constexpr MultibyteRegister(const ByteRegs& regs, Args... args):
-         Register_(args...), regs_(regs) {}
+      MultibyteRegister(const ByteRegs& regs, const char *name, RegMask mask):
+         Register(name, mask), regs_(regs) {}
       
    protected:
       const ByteRegs regs_;
-
-      virtual bool Eq_aux(const MultibyteRegister *other) const override;
    };
 
 }
@@ -13,6 +13,7 @@
 #include "asm/asm-lab.hpp"
 #include "util.hpp"
 #include "alg.hpp"
+#include "arena.hpp"
 
 namespace zc::z80 {
 
@@ -25,15 +26,20 @@ namespace zc::z80 {
     */
    class Value {
    public:
+      /* Values live in the translation unit's IR arena and are never freed individually. */
+      static void *operator new(std::size_t size) { return ir_arena().Allocate(size); }
+      static void operator delete(void *ptr) {}
+
       int size() const { return size_.get(); }
       virtual const Register *reg() const { return nullptr; }
       virtual const Value *high() const { throw std::logic_error("attempted to take high byte"); }
       virtual const Value *low() const { throw std::logic_error("attempted to take low byte"); }
     
       virtual void Emit(std::ostream& os) const = 0;
-      virtual Value *Add(const intmax_t& offset) const = 0;
+      virtual const Value *Add(const intmax_t& offset) const = 0;
       bool Eq(const Value *other) const {
-         return size() == other->size() && Eq_(other);
+         /* interned values (@see ValuePool) are equal iff identical */
+         return this == other || (size() == other->size() && Eq_(other));
       }
       bool Match(const Value *to) const;
 
@@ -87,7 +93,7 @@ namespace zc::z80 {
       virtual void Gen(alg::ValueInserter vals) const override { *vals++ = this; }
       
       virtual void Emit(std::ostream& os) const override;
-      virtual Value *Add(const intmax_t& offset) const override
+      virtual const Value *Add(const intmax_t& offset) const override
       { throw std::logic_error("attempted to add to abstract value"); }
 
       /**
@@ -126,7 +132,7 @@ namespace zc::z80 {
       virtual void Gen(alg::ValueInserter vals) const override {}
 
       virtual void Emit(std::ostream& os) const override;
-      virtual Value *Add(const intmax_t& offset) const override {
+      virtual const Value *Add(const intmax_t& offset) const override {
          throw std::logic_error("attempted to add to flag value");
       }
 
@@ -160,15 +166,11 @@ namespace zc::z80 {
    class ImmediateValue: public Value_<ImmediateValue> {
    public:
       const intmax_t& imm() const { return *imm_; }
-      virtual const Value *high() const override {
-         return new ImmediateValue((imm() & 0x00ff00) >> 8, byte_size);
-      }
-      virtual const Value *low() const override {
-         return new ImmediateValue((imm() & 0x0000ff), byte_size);
-      }
+      virtual const Value *high() const override;
+      virtual const Value *low() const override;
        
       virtual void Emit(std::ostream& os) const override;
-      virtual Value *Add(const intmax_t& offset) const override;
+      virtual const Value *Add(const intmax_t& offset) const override;
     
       ImmediateValue(portal<intmax_t> imm, portal<int> size): Value_(size), imm_(imm) {}
       ImmediateValue(const intmax_t& imm); /* infers size */
@@ -190,7 +192,7 @@ namespace zc::z80 {
       const Label *label() const { return label_; }
 
       virtual void Emit(std::ostream& os) const override;
-      virtual Value *Add(const intmax_t& offset) const override;
+      virtual const Value *Add(const intmax_t& offset) const override;
 
       template <typename... Args>
       LabelValue(const Label *label, Args... args): Value_(args..., long_size), label_(label) {}
@@ -210,11 +212,11 @@ namespace zc::z80 {
    class RegisterValue: public Value_<RegisterValue> {
    public:
       virtual const Register *reg() const override { return *reg_; }
-      virtual const Value *high() const override { return new RegisterValue(reg()->high()); }
-      virtual const Value *low() const override { return new RegisterValue(reg()->low()); }
+      virtual const Value *high() const override;
+      virtual const Value *low() const override;
     
       virtual void Emit(std::ostream& os) const override;
-      virtual Value *Add(const intmax_t& offset) const override;
+      virtual const Value *Add(const intmax_t& offset) const override;
 
       virtual void Kill(alg::ValueInserter vals) const override { *vals++ = this; }
       virtual void Gen(alg::ValueInserter vals) const override { *vals++ = this; }
@@ -246,10 +248,8 @@ namespace zc::z80 {
       virtual const Register *reg() const override { return val()->reg(); }
     
       virtual void Emit(std::ostream& os) const override;
-      virtual Value *Add(const intmax_t& offset) const override;
-      virtual const Value *Resolve() const override {
-         return new IndexedRegisterValue(val(), index());
-      }
+      virtual const Value *Add(const intmax_t& offset) const override;
+      virtual const Value *Resolve() const override;
 
       IndexedRegisterValue(const RegisterValue *val, int8_t index):
          Value_(long_size), val_(val), index_(Index(index)) {}
@@ -278,11 +278,9 @@ namespace zc::z80 {
       int8_t index() const;
 
       virtual void Emit(std::ostream& os) const override;
-      virtual Value *Add(const intmax_t& offset) const override;
+      virtual const Value *Add(const intmax_t& offset) const override;
 
-      virtual const Value *Resolve() const override {
-         return new ImmediateValue(index(), byte_size);
-      }
+      virtual const Value *Resolve() const override;
 
       FrameValue(FrameIndices *indices, FrameIndices::iterator pos, bool negate = false):
          Value_<FrameValue>(*pos), indices_(indices), pos_(pos), negate_(negate) {}
@@ -306,7 +304,7 @@ namespace zc::z80 {
       virtual const Register *reg() const override { return base()->reg(); }
 
       virtual void Emit(std::ostream& os) const override;
-      virtual Value *Add(const intmax_t& offset) const override;
+      virtual const Value *Add(const intmax_t& offset) const override;
 
       template <typename... Args>
       OffsetValue(const Value *base, intmax_t offset, Args... args):
@@ -329,24 +327,18 @@ namespace zc::z80 {
    public:
       const Value *addr() const { return *addr_; }
       virtual const Register *reg() const override {return addr()->reg(); }
-      virtual const Value *high() const override {
-         assert(size() == long_size);
-         return new MemoryValue(addr()->Add(1), byte_size);
-      }
-      virtual const Value *low() const override {
-         return new MemoryValue(addr(), byte_size);
-      }
+      virtual const Value *high() const override;
+      virtual const Value *low() const override;
       
       virtual void Emit(std::ostream& os) const override;
-      virtual Value *Add(const intmax_t& offset) const override;
+      virtual const Value *Add(const intmax_t& offset) const override;
 
-      MemoryValue *Next(int size) const;
-      MemoryValue *Prev(int size) const;
+      const MemoryValue *Next(int size) const;
+      const MemoryValue *Prev(int size) const;
 
       virtual void Gen(alg::ValueInserter vals) const override { addr()->Gen(vals); }
 
-      virtual const Value *ReplaceVar(const VariableValue *var, const Value *with) const override
-      { return new MemoryValue((*addr_)->ReplaceVar(var, with), size_); }
+      virtual const Value *ReplaceVar(const VariableValue *var, const Value *with) const override;
       
       MemoryValue(portal<const Value *> addr, portal<int> size):
          Value_(size), addr_(addr) {}
@@ -370,7 +362,7 @@ namespace zc::z80 {
 
       virtual void Emit(std::ostream& os) const override;
 
-      virtual Value *Add(const intmax_t& offset) const override {
+      virtual const Value *Add(const intmax_t& offset) const override {
          return new ByteValue(all()->Add(offset), kind());
       }
 
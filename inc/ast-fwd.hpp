@@ -43,6 +43,7 @@ namespace zc {
    class BreakStat;
    class ContinueStat;
    class IfStat;
+   class SwitchStat;
    class IterationStat;
    class LoopStat;
    class WhileStat;
@@ -50,6 +51,8 @@ namespace zc {
    class GotoStat;
    class LabeledStat;
    class LabelDefStat;
+   class CaseStat;
+   class DefaultStat;
    class NoStat;
 
    /* ast-decl */
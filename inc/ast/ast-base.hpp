@@ -8,6 +8,7 @@
 #include <set>
 
 #include "semant.hpp"
+#include "arena.hpp"
 
 namespace zc {
 
@@ -15,6 +16,10 @@ namespace zc {
 
    class ASTNode {
    public:
+      /* AST nodes live in the translation unit's AST arena and are never freed individually. */
+      static void *operator new(std::size_t size) { return ast_arena().Allocate(size); }
+      static void operator delete(void *ptr) {}
+
       const SourceLoc& loc() const { return loc_; }
       virtual void Dump(std::ostream& os, int level, bool with_types) const;
       virtual void DumpNode(std::ostream& os) const {}
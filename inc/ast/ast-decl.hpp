@@ -213,6 +213,18 @@ namespace zc {
       Symbol *sym() const { return sym_; }            
       bool is_const() const { return is_const_; }
       bool is_valid() const { return sym() != nullptr; }
+      bool addr_taken() const { return addr_taken_; }
+      void set_addr_taken() { addr_taken_ = true; }
+      bool is_defined() const { return is_defined_; } /*!< function defined in this unit */
+      void set_defined() { is_defined_ = true; }
+      bool is_static() const { return is_static_; } /*!< internal linkage */
+      void set_static() { is_static_ = true; }
+
+      /**
+       * Whether the variable may be held in a register for its entire lifetime rather than
+       * in the stack frame (scalar whose address is never taken).
+       */
+      bool is_reg_candidate() const;
 
       virtual void Declare(SemantEnv& env) override;
       virtual void Declare(CgenEnv& env) override;
@@ -231,6 +243,9 @@ namespace zc {
    private: 
       Symbol *sym_;     
       bool is_const_;
+      bool addr_taken_ = false;
+      bool is_defined_ = false;
+      bool is_static_ = false;
 
       template <typename... Args>
       VarDeclaration(Symbol *sym, bool is_const, Args... args):
@@ -9,6 +9,7 @@
 #include "cgen-fwd.hpp"
 #include "asm-fwd.hpp"
 #include "symtab.hpp"
+#include "util.hpp"
 #include "alg/alg-dag.hpp"
 
 namespace zc {
@@ -93,6 +94,13 @@ namespace zc {
        */
       virtual bool ExprEq(ASTExpr *other);
 
+      /**
+       * Structural hash consistent with @see ExprEq. Meant to be overridden.
+       * Subexpressions are hashed by address, so they must already be canonical
+       * (as they are during @see DAG).
+       */
+      virtual std::size_t ExprHash();
+
       /**
        * Transform into DAG.
        */
@@ -217,6 +225,9 @@ namespace zc {
          auto other_ = dynamic_cast<const UnaryExpr *>(other);
          return other_ && kind() == other_->kind() && ASTUnaryExpr::ExprEq(other);
       }
+      virtual std::size_t ExprHash() override {
+         return hash_combine(ASTUnaryExpr::ExprHash(), kind());
+      }
 
    protected:
       Kind kind_;
@@ -264,6 +275,9 @@ namespace zc {
          auto other_ = dynamic_cast<const BinaryExpr *>(other);
          return other_ && kind() == other_->kind() && ASTBinaryExpr::ExprEq(other);
       }
+      virtual std::size_t ExprHash() override {
+         return hash_combine(ASTBinaryExpr::ExprHash(), kind());
+      }
       
    protected:
       Kind kind_;
@@ -301,6 +315,7 @@ namespace zc {
          auto other_ = dynamic_cast<const LiteralExpr *>(other);
          return other_ && val() == other_->val() && ASTExpr::ExprEq(other);
       }
+      virtual std::size_t ExprHash() override { return hash_combine(ASTExpr::ExprHash(), val()); }
       
    protected:
       intmax_t val_;
@@ -331,6 +346,9 @@ namespace zc {
          auto other_ = dynamic_cast<const StringExpr *>(other);
          return other_ && *str() == *other_->str() && ASTExpr::ExprEq(other);
       }
+      virtual std::size_t ExprHash() override {
+         return hash_combine(ASTExpr::ExprHash(), *str());
+      }
       
    protected:
       const std::string *str_;
@@ -346,10 +364,18 @@ namespace zc {
    class IdentifierExpr: public ASTExpr {
    public:
       Identifier *id() const { return id_; }
+      VarDeclaration *decl() const { return decl_; } /*!< populated by @see TypeCheck */
+      void set_callee() { is_callee_ = true; } /*!< identifier names function being called */
       virtual ExprKind expr_kind() const override;
       virtual bool is_const() const override { return is_const_; }
       virtual intmax_t int_const() const override;
       virtual const Value *val_const(const CgenEnv& env) const override;
+
+      /**
+       * Get variable holding identifier's value if it was promoted to a register candidate.
+       * @return variable; nullptr if identifier lives in memory
+       */
+      const z80::VariableValue *val_var(const CgenEnv& env) const;
       
       static IdentifierExpr *Create(Identifier *id, const SourceLoc& loc) {
          return new IdentifierExpr(id, loc);
@@ -367,11 +393,16 @@ namespace zc {
          return other_ && *id()->id() == *other_->id()->id() && scope_id_ == other_->scope_id_ &&
             ASTExpr::ExprEq(other);
       }
+      virtual std::size_t ExprHash() override {
+         return hash_combine(hash_combine(ASTExpr::ExprHash(), *id()->id()), scope_id_);
+      }
 
    protected:
       Identifier *id_;
+      VarDeclaration *decl_ = nullptr;
       std::size_t scope_id_;
       bool is_const_;
+      bool is_callee_ = false;
       
       IdentifierExpr(Identifier *id, const SourceLoc& loc):
          ASTExpr(loc), id_(id), is_const_(false) {}
@@ -491,6 +522,9 @@ namespace zc {
          return other_ && *memb() == *other_->memb() &&
             ASTExpr::ExprEq(other);
       }
+      virtual std::size_t ExprHash() override {
+         return hash_combine(ASTExpr::ExprHash(), *memb());
+      }
       
    protected:
       ASTExpr *expr_;
@@ -527,6 +561,9 @@ namespace zc {
          auto other_ = dynamic_cast<const SizeofExpr *>(other);
          return other_ && int_const() == other_->int_const() && ASTExpr::ExprEq(other);
       }
+      virtual std::size_t ExprHash() override {
+         return hash_combine(ASTExpr::ExprHash(), int_const());
+      }
       
    protected:
       Variant variant_;
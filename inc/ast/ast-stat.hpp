@@ -5,6 +5,9 @@
 #ifndef __AST_STAT_HPP
 #define __AST_STAT_HPP
 
+#include <optional>
+#include <set>
+
 #include "asm-fwd.hpp"
 
 namespace zc {
@@ -231,6 +234,54 @@ namespace zc {
          SelectionStat(args...), cond_(cond), if_body_(if_body), else_body_(else_body) {}
    };
 
+   class SwitchStat: public SelectionStat {
+   public:
+      ASTExpr *expr() const { return expr_; }
+      ASTStat *body() const { return body_; }
+
+      virtual bool can_break() const override { return true; }
+
+      /**
+       * Convert case label value to the type of the controlling expression.
+       * @return converted value; nullopt if the promoted controlling expression can never
+       *         equal the case value
+       */
+      std::optional<intmax_t> case_value(intmax_t val) const;
+
+      template <typename... Args> static SwitchStat *Create(Args... args) {
+         return new SwitchStat(args...);
+      }
+
+      virtual void DumpNode(std::ostream& os) const override { os << "SwitchStat"; }
+      virtual void DumpChildren(std::ostream& os, int level, bool with_types) const override {
+         expr()->Dump(os, level, with_types);
+         body()->Dump(os, level, with_types);
+      }
+
+      /* Semantic Analysis */
+      virtual void TypeCheck(SemantEnv& env) override;
+      void AddCase(SemantEnv& env, const CaseStat *stat);
+      void AddDefault(SemantEnv& env, const DefaultStat *stat);
+
+      /* Code Generation */
+      virtual Block *CodeGen(CgenEnv& env, Block *block) override;
+      virtual void FrameGen(StackFrame& env) const override;
+
+      /* AST Transformation */
+      virtual ASTStat *ReduceConst() override;
+      virtual void DAG() override;
+
+   protected:
+      ASTExpr *expr_;
+      ASTStat *body_;
+      std::set<intmax_t> case_vals_; /*!< case values seen during semantic analysis */
+      bool has_default_;
+
+      template <typename... Args>
+      SwitchStat(ASTExpr *expr, ASTStat *body, Args... args):
+         SelectionStat(args...), expr_(expr), body_(body), has_default_(false) {}
+   };
+
    /* NOTE: Abstract */
    class IterationStat: public ASTStat {
    public:
@@ -419,6 +470,56 @@ namespace zc {
       LabelDefStat(Identifier *label_id, Args... args): LabeledStat(args...), label_id_(label_id) {}
    };
 
+   class CaseStat: public LabeledStat {
+   public:
+      ASTExpr *val() const { return val_; }
+
+      template <typename... Args>
+      static CaseStat *Create(Args... args) {
+         return new CaseStat(args...);
+      }
+
+      virtual void DumpNode(std::ostream& os) const override { os << "CaseStat"; }
+      virtual void DumpChildren(std::ostream& os, int level, bool with_types) const override {
+         val()->Dump(os, level, with_types);
+         LabeledStat::DumpChildren(os, level, with_types);
+      }
+
+      /* Semantic Analysis */
+      virtual void TypeCheck(SemantEnv& env) override;
+
+      /* Code Generation */
+      virtual Block *CodeGen(CgenEnv& env, Block *block) override;
+      virtual void FrameGen(StackFrame& env) const override { stat()->FrameGen(env); }
+
+   private:
+      ASTExpr *val_;
+
+      template <typename... Args>
+      CaseStat(ASTExpr *val, Args... args): LabeledStat(args...), val_(val) {}
+   };
+
+   class DefaultStat: public LabeledStat {
+   public:
+      template <typename... Args>
+      static DefaultStat *Create(Args... args) {
+         return new DefaultStat(args...);
+      }
+
+      virtual void DumpNode(std::ostream& os) const override { os << "DefaultStat"; }
+
+      /* Semantic Analysis */
+      virtual void TypeCheck(SemantEnv& env) override;
+
+      /* Code Generation */
+      virtual Block *CodeGen(CgenEnv& env, Block *block) override;
+      virtual void FrameGen(StackFrame& env) const override { stat()->FrameGen(env); }
+
+   private:
+      template <typename... Args>
+      DefaultStat(Args... args): LabeledStat(args...) {}
+   };
+
    class NoStat: public ASTStat {
    public:
       template <typename... Args>
@@ -33,6 +33,30 @@ namespace zc {
       Block *enter_;
       Block *exit_;
    };
+
+   /**
+    * Case labels of a switch statement, as pairs of case value (converted to the type of the
+    * controlling expression) and target block.
+    */
+   typedef std::vector<std::pair<intmax_t, Block *>> SwitchCases;
+
+   /**
+    * Statement info for a switch statement, collecting the labels generated in its body.
+    */
+   class SwitchInfo: public StatInfo {
+   public:
+      SwitchStat *switch_stat() const { return static_cast<SwitchStat *>(stat()); }
+      SwitchCases& cases() { return cases_; }
+      Block *default_block() const { return default_block_; }
+      void default_block(Block *block) { default_block_ = block; }
+
+      SwitchInfo(SwitchStat *stat, Block *exit):
+         StatInfo(stat, nullptr, exit), default_block_(nullptr) {}
+
+   private:
+      SwitchCases cases_;
+      Block *default_block_;
+   };
    
    class SymInfo {
    public:
@@ -87,7 +111,14 @@ namespace zc {
       
       VarSymInfo *next_arg(const VarDeclaration *type);
       VarSymInfo *next_local(const VarDeclaration *type);
+
+      /**
+       * Allocate spill slot for register allocator. Slots lie below the frame pointer, so
+       * allocating one after the frame has been resolved moves no local or argument.
+       * @return memory value of slot
+       */
       const Value *next_tmp(const Value *tmp);
+      int spill_bytes() const { return spill_bytes_; } /*!< bytes of spill slots */
 
       StackFrame();
       StackFrame(const VarDeclarations *params);
@@ -96,6 +127,7 @@ namespace zc {
       FrameIndices *sizes_; /*!< list of sizes */
       FrameIndices::iterator saved_fp_; /*!< caller's frame pointer */
       FrameIndices::iterator saved_ra_; /*!< return address */
+      int spill_bytes_ = 0;
    };
    
 
@@ -168,6 +200,37 @@ namespace zc {
       Block *dst_;
    };
 
+   /**
+    * Closing edge of a counted loop: decrements b and jumps back while it is nonzero.
+    * Only valid when the destination is within djnz range.
+    */
+   class DjnzTransition: public JumpTransition {
+   public:
+      virtual void Serialize(Instructions& out) override;
+      virtual void DumpAsm(std::ostream& os) const override;
+
+      DjnzTransition(Block *dst): JumpTransition(dst, Cond::NZ) {}
+   };
+
+   /**
+    * Edge to a target of a computed jump (e.g. a jump table entry). The jump itself is made by
+    * the block's instructions, so the transition emits nothing; it only exposes the target to
+    * block traversal and liveness analysis.
+    */
+   class IndirectTransition: public BlockTransition {
+   public:
+      virtual Block *dst() const override { return dst_; }
+
+      virtual BlockTransition *Resolve(const FunctionImpl *impl) override { return this; }
+      virtual void Serialize(Instructions& out) override {}
+      virtual void DumpAsm(std::ostream& os) const override {}
+
+      IndirectTransition(Block *dst): BlockTransition(Cond::ANY), dst_(dst) {}
+
+   protected:
+      Block *dst_;
+   };
+
    class ReturnTransition: public BlockTransition {
    public:
       virtual Block *dst() const override { return nullptr; }
@@ -196,6 +259,11 @@ namespace zc {
 
       bool live() const { return transitions().live(); }
 
+      /**
+       * Static cost of block's instructions and transitions, counting a jump for every
+       * transition (i.e. none falls through).
+       */
+      Cost cost() const;
       
       /**
        * Emit as assembly.
@@ -261,18 +329,31 @@ namespace zc {
       Block *entry() const { return entry_; }
       Block *fin() const { return fin_; }
       const LabelValue *addr() const { return addr_; }
+      Instructions& instrs() { return *instrs_; } /*!< only valid after serialization */
+      StackFrame& stack_frame() { return stack_frame_; }
       
       void DumpAsm(std::ostream& os) const;
       void Resolve();
       void Serialize();
 
+      /**
+       * Static cost of function: sum of @see Block::cost over its blocks, each executed once.
+       */
+      Cost cost() const;
+
+      /**
+       * Write serialized instruction stream back into blocks, dropping transition jumps.
+       * Instructions inserted or removed in the stream since @see Serialize are preserved.
+       */
+      void Deserialize();
+
       FunctionImpl(CgenEnv& env, Block *entry, Block *fin);
       
    protected:
       Block *entry_;
       Block *fin_;
       const LabelValue *addr_;
-      StackFrame& stack_frame_;
+      StackFrame stack_frame_;
       std::optional<Instructions> instrs_ = std::nullopt; /*!< only set after serialization */
    };
 
@@ -355,6 +436,23 @@ namespace zc {
    std::string crt_prefix(const Value *val);
    std::string crt_prefix(int bytes);
 
+   /**
+    * Get registers a function's arguments are passed in under the register calling convention
+    * (@see CgenOptimInfo::reg_call). Applies to static functions other than main defined in this
+    * unit whose address is never taken and whose parameters all fit in registers, when
+    * allocating registers across whole functions.
+    * @return argument registers in parameter order; empty if arguments are passed on the stack
+    */
+   std::vector<const RegisterValue *> reg_call_args(const VarDeclaration *fn);
+
+   /**
+    * Whether function pops its own stack arguments before returning
+    * (@see CgenOptimInfo::callee_pop). Applies to static functions other than main defined in this
+    * unit whose address is never taken, since callers zc did not compile clean up after
+    * themselves.
+    */
+   bool callee_pops(const VarDeclaration *fn);
+
    /**
     * Get accumulator register for given size.
     */
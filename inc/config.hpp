@@ -94,6 +94,13 @@ namespace zc {
    struct PrintOpts: public Config<PrintOpts> {
       bool peephole_stats = false;
       bool ralloc_info = false;
+      bool live_info = false;
+      bool loop_info = false;
+      bool cost_stats = false;
+      bool cost_report = false;
+      bool time_passes = false;
+      bool mem_stats = false;
+      bool stats_json = false; /*!< print time-passes and mem-stats as JSON */
       
       PrintOpts(const NameTable& nametab): Config(nametab) {}
    };
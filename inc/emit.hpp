@@ -41,6 +41,13 @@ namespace zc {
    Block *emit_incdec(CgenEnv& env, Block *block, bool inc_not_dec, bool pre_not_post,
                       ASTExpr *subexpr, const Value **out);
    
+   /**
+    * Emit bytewise store of word to memory at address in hl, since a 24-bit store would clobber
+    * the byte following it. Advances hl.
+    * @param val value to store; must be forced into a register pair other than hl
+    */
+   void emit_store_word(Block *block, const Value *val);
+   
    /** Killeric emission routine for performing binary operation on two integers. */
    Block *emit_binop(CgenEnv& env, Block *block, ASTBinaryExpr *expr,
                      const Value **out_lhs, const Value **out_rhs);
@@ -48,8 +55,59 @@ namespace zc {
    /** Emit CRT frameset. */
    void emit_frameset(CgenEnv& env, Block *block);
 
-   /** Emit CRT frameunset. */
-   void emit_frameunset(CgenEnv& env, Block *block);
+   /**
+    * Reserve spill slots below frame pointer, by lowering stack pointer in frameset.
+    * @param entry entry block, beginning with frameset
+    * @param fin return block, beginning with frameunset
+    */
+   void emit_spillset(const StackFrame& frame, Block *entry, Block *fin);
+
+   /** Emit CRT frameunset.
+    * @param pop_bytes bytes of arguments to pop before returning (callee-pops convention)
+    */
+   void emit_frameunset(CgenEnv& env, Block *block, int pop_bytes = 0);
+
+   /**
+    * Emit cheapest stack pointer adjustment releasing given number of bytes: pops into scratch
+    * register, `inc sp' sequence, or adding to stack pointer through index register.
+    * @param bytes number of bytes to release; multiple of long size
+    * @param pop_scratch register to pop into
+    * @param add_scratch register to compute new stack pointer in (hl, ix or iy)
+    */
+   void emit_stack_cleanup(Block *block, int bytes, const RegisterValue *pop_scratch,
+                           const RegisterValue *add_scratch);
+
+   /**
+    * Emit multiplication by constant, leaving the product in the accumulator (a or hl). Picks
+    * the cheapest of a shift-and-add chain (in binary or non-adjacent form), mlt partial
+    * products (bytes and words with byte-sized factors) and a CRT call.
+    * @param val multiplicand
+    * @param factor multiplier; only the low bits of the value's size are significant
+    * @param is_signed selects the signed CRT routine
+    */
+   void emit_mul_const(Block *block, const Value *val, intmax_t factor, bool is_signed);
+
+   /**
+    * Emit division or modulo by constant without a CRT divide, leaving the result in the
+    * accumulator (a or hl). Powers of two become shifts and masks (negative dividends are
+    * biased so signed quotients round toward zero); other unsigned byte and word divisors use
+    * an mlt multiply-high reciprocal.
+    * @param val dividend
+    * @param divisor constant divisor
+    * @return false, emitting nothing, if no sequence is cheaper than the CRT routine
+    */
+   bool emit_div_const(Block *block, const Value *val, intmax_t divisor, bool is_signed,
+                       bool div_not_mod);
+
+   /**
+    * Emit dispatch of switch statement: a jump table for dense case values, otherwise a binary
+    * search, whichever has the lower estimated cost.
+    * @param val value of controlling expression
+    * @param cases case values and target blocks, in any order
+    * @param default_block target if no case matches
+    */
+   void emit_switch(Block *block, const Value *val, bool is_signed, SwitchCases cases,
+                    Block *default_block);
 
    /** Emit call to CRT routine. */
    void emit_crt(const std::string& name, Block *block);
@@ -12,7 +12,13 @@ namespace zc {
       /** AST optimization flags */      
       bool reduce_const = true;
       bool direct_call = true;
+      bool reg_call = false; /*!< pass arguments of internal functions in registers */
+      bool callee_pop = false; /*!< internal functions pop their own stack arguments */
+      bool frame_elision = true; /*!< omit ix frame in functions without stack locals */
       bool bool_flag = true;
+      bool strength_reduce = true; /*!< multiply and divide by constants without CRT calls */
+      bool jump_tables = true; /*!< dispatch dense switch statements through jump tables */
+      bool counted_loops = true; /*!< count constant-trip loops down, closing them with djnz */
       bool DAG = true;
       IntegralType::IntKind bool_spec() const {
          return bool_flag ? IntegralType::IntKind::SPEC_BOOL : IntegralType::IntKind::SPEC_CHAR;
@@ -24,6 +30,8 @@ namespace zc {
       
       /** Register allocation flags */
       bool join_vars = true;
+      bool function_ralloc = true; /*!< allocate over whole functions; promotes scalar locals */
+      bool licm = true; /*!< hoist loop-invariant definitions; requires function-ralloc */
 
       /** ASM flags */
       bool peephole = true;
@@ -36,6 +44,29 @@ namespace zc {
    
    void OptimizeAST(TranslationUnit *root);
    void OptimizeIR(CgenEnv& env);
+
+   /**
+    * Remove frame setup from a function without stack locals or temporaries. Arguments are
+    * then addressed through iy, which is loaded with the entry stack pointer; this requires
+    * that the function make no calls.
+    * @return whether the frame was removed
+    */
+   bool ElideFrame(FunctionImpl& impl);
+
+   /**
+    * Hoist loop-invariant constant, address and copy definitions of variables into loop
+    * preheaders, innermost loops first. Runs before register allocation, and hoists only while
+    * the variables live across a loop fit in registers.
+    * @return whether any instruction was hoisted
+    */
+   bool HoistInvariants(FunctionImpl& impl);
+
+   /**
+    * Close loops ending in "dec b / jp nz" with djnz where the loop head is in range. Must run
+    * after the last pass that deserializes the function.
+    * @return whether any loop was closed with djnz
+    */
+   bool CloseCountedLoops(FunctionImpl& impl);
 }
 
 #endif
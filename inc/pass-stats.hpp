@@ -0,0 +1,65 @@
+#ifndef __PASS_STATS_HPP
+#define __PASS_STATS_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <ctime>
+#include <ostream>
+#include <vector>
+
+namespace zc {
+
+   /**
+    * Time and memory used by each phase of the compiler, for `-p time-passes' and
+    * `-p mem-stats'. Allocations are those made from the AST and IR arenas.
+    */
+   class PassStats {
+   public:
+      struct Pass {
+         const char *name;
+         double wall_ms;
+         double cpu_ms;
+         std::size_t allocs; /*!< arena allocations during pass */
+         std::size_t bytes; /*!< arena bytes handed out during pass */
+         std::size_t reserved; /*!< arena bytes obtained from the heap, at end of pass */
+         long peak_rss_kb; /*!< peak resident set size of process, at end of pass */
+      };
+
+      /**
+       * Measures a pass from construction to destruction.
+       */
+      class Timer {
+      public:
+         Timer(PassStats& stats, const char *name);
+         ~Timer();
+         Timer(const Timer&) = delete;
+         Timer& operator=(const Timer&) = delete;
+
+      private:
+         PassStats& stats_;
+         const char *name_;
+         std::chrono::steady_clock::time_point wall_;
+         std::clock_t cpu_;
+         std::size_t allocs_;
+         std::size_t bytes_;
+      };
+
+      const std::vector<Pass>& passes() const { return passes_; }
+
+      /**
+       * Print passes as enabled by `time-passes' and `mem-stats'; as a single JSON object if
+       * `stats-json' is set.
+       */
+      void Dump(std::ostream& os) const;
+
+   private:
+      std::vector<Pass> passes_;
+
+      void DumpJSON(std::ostream& os) const;
+   };
+
+   extern PassStats g_pass_stats;
+
+}
+
+#endif
@@ -3,6 +3,9 @@
 
 #include <list>
 #include <forward_list>
+#include <vector>
+#include <string>
+#include <array>
 
 #include "cgen.hpp"
 #include "asm.hpp"
@@ -26,23 +29,36 @@ namespace zc::z80 {
       typedef const_iterator (*replace_t)
       (const_iterator in_begin, const_iterator in_end, Instructions& out);
 
-      void Pass(FunctionImpl *impl);
-      void ReplaceAll(Instructions& input);
-      const_iterator ReplaceAt(Instructions& input, const_iterator begin);
+      typedef std::vector<Opcode> Opcodes;
+
+      const std::string& name() const { return name_; }
+      const Opcodes& opcodes() const { return opcodes_; }
+
+      /**
+       * Try to apply optimization at given position.
+       * @param it position; on success, updated to first replacement instruction, or to the
+       *        instruction following the deleted sequence if there is no replacement.
+       * @return whether optimization applied
+       */
+      bool ReplaceAt(Instructions& input, const_iterator& it);
 
       void Dump(std::ostream& os) const;
 
-      PeepholeOptimization(const std::string& name, replace_t replace, int bytes_saved):
-         name_(name), replace_(replace), bytes_saved_(bytes_saved) {}
+      /**
+       * @param opcodes opcodes of the instruction sequence the optimization matches.
+       * Replacements must be shorter than the matched sequence.
+       */
+      PeepholeOptimization(const std::string& name, const Opcodes& opcodes, replace_t replace):
+         name_(name), opcodes_(opcodes), replace_(replace) {}
       
    protected:
       const std::string name_;
+      const Opcodes opcodes_;
       const replace_t replace_;
-      const int bytes_saved_; /*!< bytes saved per replacement */
       int hits_ = 0;
       int total_ = 0;
-
-      static void PassBlock(Block *block, PeepholeOptimization *optim);      
+      int bytes_saved_ = 0; /*!< over all replacements, by @see Instruction::cost() */
+      int cycles_saved_ = 0;
 
    public:
       template <class InputIt, class... Ts>
@@ -51,6 +67,45 @@ namespace zc::z80 {
       }
    };
 
+   /**
+    * Peephole optimizations compiled into a trie keyed on opcode sequences, so that all
+    * optimizations are tried at each position in a single traversal of a block.
+    */
+   class PeepholeMatcher {
+      using const_iterator = Instructions::const_iterator;
+   public:
+      /**
+       * Optimize every block of function until no optimization applies.
+       */
+      void Pass(FunctionImpl *impl);
+      void ReplaceAll(Instructions& input);
+
+      std::size_t instrs() const { return instrs_; } /*!< input instructions scanned */
+
+      template <class InputIt>
+      PeepholeMatcher(InputIt begin, InputIt end): nodes_(1, Node()) {
+         for (; begin != end; ++begin) { Add(&*begin); }
+      }
+
+   private:
+      struct Node {
+         std::array<int, opcode_count> children; /*!< child node index by opcode; 0 if none */
+         std::vector<std::pair<int, PeepholeOptimization *>> optims; /*!< rank and optimization */
+
+         Node() { children.fill(0); }
+      };
+      
+      std::vector<Node> nodes_; /*!< trie nodes; root at index 0 */
+      int count_ = 0; /*!< number of optimizations */
+      std::size_t max_len_ = 0; /*!< longest opcode sequence */
+      std::size_t instrs_ = 0;
+
+      void Add(PeepholeOptimization *optim);
+      bool ReplaceAt(Instructions& input, const_iterator& it);
+
+      static void PassBlock(Block *block, PeepholeMatcher *matcher);
+   };
+
    extern std::forward_list<PeepholeOptimization> peephole_optims;
 }
 
@@ -4,6 +4,8 @@
 #include <unordered_map>
 #include <unordered_set>
 #include <list>
+#include <set>
+#include <vector>
 #include <ostream>
 #include <iterator>
 
@@ -19,24 +21,21 @@ namespace std {
 
 namespace zc::z80 {
 
-   /**
-    * Check whether iterator comes before another iterator.
-    */
-   bool before(Instructions::const_iterator lhs, Instructions::const_iterator rhs,
-               Instructions::const_iterator end);
-
    /**
     * Interval as used in representing a variable lifetime or when a register is free.
+    * Endpoints are inclusive instruction indices, numbered once per allocation run.
     */
    struct RallocInterval {
-      Instructions::iterator begin;
-      Instructions::iterator end;
+      int begin;
+      int end;
 
-      int length() const { return std::distance(begin, end); }
+      int length() const { return end - begin; }
 
       bool operator<(const RallocInterval& other) const;
 
-      bool in(const RallocInterval& other) const;
+      bool in(const RallocInterval& other) const {
+         return other.begin <= begin && end <= other.end;
+      }
 
       /* NOTE: Checks for exclusive intersection, i.e. overlap without containment. */
       bool intersects(const RallocInterval& other) const;
@@ -44,46 +43,51 @@ namespace zc::z80 {
       void Merge(const RallocInterval& with) { Merge(with, *this); }
       void Merge(const RallocInterval& with, RallocInterval& out) const;
 
-      void Dump(std::ostream& os, Instructions::iterator instrs_begin) const {
-         os << "[" << std::distance(instrs_begin, begin) << ","
-            << std::distance(instrs_begin, end) << "]";
-      }
+      void Dump(std::ostream& os) const { os << "[" << begin << "," << end << "]"; }
 
-      RallocInterval(Instructions::iterator begin, Instructions::iterator end):
-         begin(begin), end(end) {}
+      RallocInterval(int begin, int end): begin(begin), end(end) {}
          
-      RallocInterval() {}
+      RallocInterval(): begin(0), end(0) {}
       
    };
 
-#if 0
-   class RallocIntervals {
-   public:
-      typedef std::multiset<RallocInterval>::iterator iterator;
-      typedef std::multiset<RallocInterval>::const_iterator const_iterator;
-
-      iterator begin() { return intervals_.begin(); }
-      const_iterator begin() const { return intervals_.begin(); }
-      iterator end() { return intervals_.end(); }
-      const_iterator end() const { return intervals_.end(); }
-      
-   private:
-      std::multiset<RallocInterval> intervals_;
+   /**
+    * Orders intervals by position: by beginning, then by end.
+    */
+   struct RallocIntervalPositionLess {
+      bool operator()(const RallocInterval& lhs, const RallocInterval& rhs) const {
+         return lhs.begin < rhs.begin || (lhs.begin == rhs.begin && lhs.end < rhs.end);
+      }
    };
-   
-   typedef std::multiset<RallocInterval> RallocIntervals;
-#else
 
-   typedef std::list<RallocInterval> RallocIntervals;
-      
-#endif
+   typedef std::multiset<RallocInterval, RallocIntervalPositionLess> RallocIntervals;
 
+   /**
+    * Intervals that must stay properly nested, e.g. stack spills, which are pushed and popped in
+    * LIFO order. Endpoints are kept as a parenthesis sequence in a segment tree of prefix sums
+    * over instruction indices, so checking an interval is logarithmic.
+    */
    class NestedRallocIntervals {
    public:
+      /**
+       * Add interval if it doesn't partially overlap or share an endpoint with another one.
+       * @return whether interval was added
+       */
       bool try_add(const RallocInterval& interval);
       
    protected:
-      RallocIntervals intervals_;
+      struct Node {
+         int sum = 0; /*!< opening minus closing endpoints in range */
+         int min_prefix = 0; /*!< minimum prefix sum in range, including the empty prefix */
+      };
+      int capacity_ = 0; /*!< number of leaves; power of 2 */
+      std::vector<Node> tree_; /*!< implicit tree rooted at 1; leaves at [capacity_, 2*capacity_) */
+      std::unordered_set<int> endpoints_;
+
+      static Node Combine(const Node& lhs, const Node& rhs);
+      void Reserve(int index);
+      void Add(int index, int delta);
+      Node Query(int node, int node_lo, int node_hi, int lo, int hi) const;
    };
 
    enum class AllocKind {ALLOC_NONE, ALLOC_REG, ALLOC_STACK, ALLOC_FRAME};
@@ -99,14 +103,32 @@ namespace zc::z80 {
       std::list<Instructions::iterator> uses; /*!< the instructions in which the variable is used */
       RallocInterval interval;
       AllocKind alloc_kind = AllocKind::ALLOC_NONE;
+      int defs = 1; /*!< number of instructions that assign to the variable */
+      double loop_weight = 0; /*!< sum of loop depths of references (function-level only) */
+      bool crosses_blocks = false; /*!< whether lifetime spans a block boundary */
 
       void AssignVal(const Value *val);
       bool requires_reg() const;
 
+      /**
+       * Whether variable is defined or used by an instruction that can't address its frame slot,
+       * which a frame spill must pass through a scratch register (@see FrameSpill()).
+       */
+      bool through_memory() const;
+      bool needs_scratch(Instructions::const_iterator it) const; /*!< e.g. `ld var,(hl)', `add hl,var' */
+      const RegisterValue *scratch(Instructions::const_iterator it) const;
+
       bool is_stack_spillable() const;
       void StackSpill(Instructions& instrs);
 
-      void FrameSpill(StackFrame& frame); 
+      /**
+       * Cost, in bytes + cycles (@see Instruction::cost()), of the instructions the definition
+       * and uses of a stack-spillable variable turn into when stack-spilled or frame-spilled.
+       */
+      int stack_spill_cost() const;
+      int frame_spill_cost() const;
+
+      void FrameSpill(StackFrame& frame, Instructions& instrs);
 
       /**
        * Check if variable is joinable with next variable.
@@ -114,10 +136,10 @@ namespace zc::z80 {
        */
       const VariableValue *joinable();
       
-      void Dump(std::ostream& os, Instructions::iterator instrs_begin) const;
+      void Dump(std::ostream& os) const;
 
-      VariableRallocInfo(const VariableValue *var, Instructions::iterator gen):
-         var(var), gen(gen), interval(gen, gen) {}
+      VariableRallocInfo(const VariableValue *var, Instructions::iterator gen, int gen_index):
+         var(var), gen(gen), interval(gen_index, gen_index) {}
 
       VariableRallocInfo(const VariableValue *var, Instructions::iterator gen,
                          const RallocInterval& interval):
@@ -128,46 +150,65 @@ namespace zc::z80 {
        * Positive values for those that require registers; negative values for those that don't.xs
        */
       double priority() const {
-         double base = (uses.size() + 1) / (interval.length() + 1);
-         if (requires_reg()) { return base; }
+         double base = (uses.size() + 1 + loop_weight) / (interval.length() + 1);
+         if (requires_reg() || through_memory()) { return base; }
          else { return -1/base; }
       }
    };
 
    /**
     * Register free intervals.
+    * Invariant: intervals are disjoint apart from shared endpoints, so ordering them by position
+    * also orders their ends.
     */
    struct RegisterFreeIntervals {
       RallocIntervals intervals;
 
-      RallocIntervals::iterator superinterval(const RallocInterval& subinterval);
+      RallocIntervals::const_iterator superinterval(const RallocInterval& subinterval) const;
       
       void remove_interval(const RallocInterval& interval);
-      void Dump(std::ostream& os, Instructions::iterator instrs_begin) const;
+      void Dump(std::ostream& os) const;
 
       RegisterFreeIntervals(const RallocIntervals& intervals): intervals(intervals) {}
    };
 
    /**
-    * Block register allocator.
+    * Register allocator over an instruction stream, either a single block or a serialized
+    * function.
     */
    class RegisterAllocator {
    public:
-      Block *block() const { return block_; }
+      Instructions& instrs() const { return instrs_; }
 
+      /**
+       * Compute intervals for a single block. Variables must not be live across blocks.
+       */
       void ComputeIntervals();
+
+      /**
+       * Compute intervals for a serialized function, using block-level liveness and loop
+       * nesting of its control flow graph.
+       * @param impl function whose blocks were serialized into @see instrs()
+       */
+      void ComputeGlobalIntervals(const FunctionImpl& impl);
+      
       void RunAllocation();
 
       void Dump(std::ostream& os) const;
+
+      /**
+       * Report estimated savings of keeping cross-block variables in registers.
+       */
+      void DumpStats(std::ostream& os) const;
       
-      RegisterAllocator(Block *block, StackFrame& stack_frame):
-         block_(block), stack_frame_(stack_frame) {}
+      RegisterAllocator(Instructions& instrs, StackFrame& stack_frame):
+         instrs_(instrs), stack_frame_(stack_frame) {}
 
       static void Ralloc(FunctionImpl& impl, StackFrame& stack_frame);
       static void Ralloc(CgenEnv& env);
       
    protected:
-      Block *block_; /*!< block containing instructions. */
+      Instructions& instrs_; /*!< instructions to allocate over. */
       StackFrame& stack_frame_; /*!< stack frame for spilling locals. */
       typedef std::unordered_map<int, VariableRallocInfo> Vars;
       Vars vars_; /*!< map from variable ID to register allocation information */
@@ -186,12 +227,11 @@ namespace zc::z80 {
       
       /**
        * Get registers that can be assigned to given variable.
-       * @tparam output iterator to byte register
        * @param var variable
-       * @param out output list of registers
+       * @return byte registers free over the variable's lifetime if it is a byte variable;
+       *         otherwise the union of the free register pairs.
        */
-      void GetAssignableRegs(const VariableValue *var,
-                             std::unordered_set<const Register *>& out) const;
+      RegMask GetAssignableRegs(const VariableValue *var) const;
       
       /**
        * Try to assign register to variable.
@@ -209,6 +249,7 @@ namespace zc::z80 {
       void JoinVars();
 
       static void RallocBlock(Block *block, StackFrame& stack_frame);
+      static void RallocFunction(FunctionImpl& impl, StackFrame& stack_frame);
    };
    
 }
@@ -0,0 +1,174 @@
+/* eZ80 instruction-set simulator */
+
+#ifndef __SIM_HPP
+#define __SIM_HPP
+
+#include <cstdint>
+#include <vector>
+#include <string>
+
+namespace zc::sim {
+
+   constexpr uint32_t addr_mask = 0xffffff; /*!< 24-bit address space */
+
+   /* TI-84 Plus CE memory layout, as assumed by tst/bare.inc */
+   constexpr uint32_t user_mem = 0xd1a881;
+   constexpr uint32_t stack_top = 0xd1a87e;
+   constexpr uint32_t save_sscreen = 0xd0ea1f;
+
+   /**
+    * Flat 16 MiB memory. Accesses through this class are not timed; @see Cpu times the
+    * accesses instructions make.
+    */
+   class Memory {
+   public:
+      uint8_t read8(uint32_t addr) const { return bytes_[addr & addr_mask]; }
+      void write8(uint32_t addr, uint8_t val) { bytes_[addr & addr_mask] = val; }
+      uint32_t read24(uint32_t addr) const;
+      void write24(uint32_t addr, uint32_t val);
+
+      /**
+       * Copy image into memory.
+       * @return whether image fits below the top of the address space
+       */
+      bool Load(uint32_t addr, const std::vector<uint8_t>& image);
+
+      /**
+       * CRC-32 (as used by the CEmu autotester) of memory range.
+       */
+      uint32_t crc32(uint32_t addr, uint32_t size) const;
+
+      Memory(): bytes_(addr_mask + 1) {}
+
+   private:
+      std::vector<uint8_t> bytes_;
+   };
+
+   enum Flag: uint8_t {
+      FLAG_C = 0x01,
+      FLAG_N = 0x02,
+      FLAG_PV = 0x04,
+      FLAG_H = 0x10,
+      FLAG_Z = 0x40,
+      FLAG_S = 0x80,
+   };
+
+   /**
+    * Register file. Register pairs hold 24 bits, as in ADL mode.
+    */
+   struct Registers {
+      uint8_t a = 0, f = 0;
+      uint32_t bc = 0, de = 0, hl = 0;
+      uint8_t a_alt = 0, f_alt = 0;
+      uint32_t bc_alt = 0, de_alt = 0, hl_alt = 0;
+      uint32_t ix = 0, iy = 0, sp = 0, pc = 0;
+      uint32_t i = 0;
+      uint8_t r = 0, mb = 0;
+      bool iff = false;
+   };
+
+   class Cpu;
+
+   /**
+    * Runtime library routine in ROM, simulated natively instead of being interpreted.
+    */
+   struct Routine {
+      const char *name;
+      uint32_t addr;
+      int (*run)(Cpu& cpu); /*!< returns estimated cycles, excluding call and return */
+   };
+
+   /**
+    * @return routine at address; nullptr if none is simulated there
+    */
+   const Routine *runtime_routine(uint32_t addr);
+
+   /**
+    * Interpreter for the eZ80 in ADL mode. Cycle counts assume zero wait states: one cycle per
+    * byte fetched, read or written, plus the internal cycles the eZ80 CPU user manual lists for
+    * taken branches, returns, read-modify-write and multiply instructions.
+    */
+   class Cpu {
+   public:
+      enum class Status {RUNNING, HALTED, RETURNED, FAULT, TIMEOUT};
+
+      Registers& regs() { return regs_; }
+      const Registers& regs() const { return regs_; }
+      Memory& mem() { return mem_; }
+      const Memory& mem() const { return mem_; }
+      Status status() const { return status_; }
+      const std::string& fault() const { return fault_; }
+      uint64_t cycles() const { return cycles_; }
+      uint64_t instrs() const { return instrs_; } /*!< instructions retired */
+      uint64_t runtime_calls() const { return runtime_calls_; }
+
+      /**
+       * Prepare to call routine, with a return address that stops the simulation.
+       */
+      void Call(uint32_t entry, uint32_t sp);
+
+      /**
+       * Run until halt, return from the entry routine, fault, or cycle limit.
+       */
+      Status Run(uint64_t max_cycles);
+
+      /**
+       * Execute one instruction (or simulated runtime routine).
+       */
+      void Step();
+
+      /**
+       * Return from simulated runtime routine.
+       */
+      void Return();
+
+      void Fault(const std::string& msg);
+
+   private:
+      static constexpr uint32_t return_sentinel = addr_mask;
+
+      Memory mem_;
+      Registers regs_;
+      Status status_ = Status::RUNNING;
+      std::string fault_;
+      uint64_t cycles_ = 0;
+      uint64_t instrs_ = 0;
+      uint64_t runtime_calls_ = 0;
+      uint32_t *index_ = &regs_.hl; /*!< hl, ix or iy, by prefix of current instruction */
+
+      /* timed memory accesses */
+      uint8_t fetch8();
+      uint32_t fetch24();
+      uint8_t read8(uint32_t addr);
+      void write8(uint32_t addr, uint8_t val);
+      uint32_t read24(uint32_t addr);
+      void write24(uint32_t addr, uint32_t val);
+      void push24(uint32_t val);
+      uint32_t pop24();
+
+      /* operands */
+      uint8_t reg8(int r, bool indexed = true) const;
+      void set_reg8(int r, uint8_t val, bool indexed = true);
+      uint32_t& rp(int p); /*!< bc, de, hl/ix/iy, sp */
+      uint32_t disp_addr(uint32_t base); /*!< fetch displacement */
+      uint32_t rel_target(); /*!< fetch relative jump displacement */
+      uint32_t mem_addr(); /*!< (hl), or (ix/iy+d) */
+      bool cond(int cc) const;
+
+      /* arithmetic */
+      void alu(int op, uint8_t val);
+      uint8_t inc8(uint8_t val);
+      uint8_t dec8(uint8_t val);
+      uint8_t rot(int op, uint8_t val);
+      uint32_t add24(uint32_t a, uint32_t b, bool carry, bool sub, bool all_flags);
+
+      void ExecMain(uint8_t op);
+      void ExecIndexed(uint8_t op);
+      void ExecBit(uint8_t op, const uint32_t *addr);
+      void ExecExtended(uint8_t op);
+      void Jump(uint32_t target);
+   };
+
+}
+
+#endif
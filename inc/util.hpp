@@ -5,6 +5,7 @@
 #include <iostream>
 #include <vector>
 #include <unordered_map>
+#include <functional>
 
 namespace zc {
 
@@ -18,6 +19,13 @@ namespace zc {
    }
 
 
+   /*** HASHING ***/
+   template <typename T>
+   inline std::size_t hash_combine(std::size_t seed, const T& val) {
+      return seed ^ (std::hash<T>()(val) + 0x9e3779b9 + (seed << 6) + (seed >> 2));
+   }
+
+
    /*** VISITATION & VARIANTS ***/
    template<class... Ts> struct overloaded : Ts... { using Ts::operator()...; };
    template<class... Ts> overloaded(Ts...) -> overloaded<Ts...>;
@@ -72,6 +80,7 @@ namespace zc {
       T& operator*() { return std::get<T>(v); }
       const T& operator*() const { return std::get<T>(v); }
 
+      portal(): v(T()) {}
       portal(const T& val): v(val) {}
       portal(T *ptr): v(ptr) {}
       
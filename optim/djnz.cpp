@@ -0,0 +1,89 @@
+/* counted loop closing */
+
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+
+#include "optim.hpp"
+#include "cgen.hpp"
+#include "asm.hpp"
+
+namespace zc {
+
+   using namespace z80;
+
+   namespace {
+
+      /* upper bound on size of jumps between blocks in the final layout */
+      constexpr int max_jump_bytes = 4;
+
+      /* djnz reaches from 126 bytes before itself to 129 bytes after */
+      constexpr int djnz_min = -126;
+      constexpr int djnz_max = 129;
+
+   }
+
+   bool CloseCountedLoops(FunctionImpl& impl) {
+      static const DecInstruction dec_b(&rv_b);
+
+      /* Bound label offsets in the final layout. Each label is counted as if preceded by a jump,
+       * in case transitions aren't minimized. The bounds only shrink as loops are closed. */
+      impl.Serialize();
+      std::unordered_map<std::string, int> offsets;
+      int offset = 0;
+      for (const Instruction *instr : impl.instrs()) {
+         switch (instr->opcode()) {
+         case Opcode::LABEL:
+            offset += max_jump_bytes;
+            offsets[static_cast<const LabelInstruction *>(instr)->label()->name()] = offset;
+            break;
+         case Opcode::JP:
+            offset += max_jump_bytes;
+            break;
+         default:
+            offset += instr->bytes();
+            break;
+         }
+      }
+
+      /* dec b
+       * jp nz,<head>    ; first transition; any others must not test flags
+       * -->
+       * djnz <head>
+       */
+      bool closed = false;
+      Blocks visited;
+      auto fn = [&](Block *block) {
+                   Instructions& instrs = block->instrs();
+                   BlockTransitions::Transitions& transitions = block->transitions().vec();
+                   if (instrs.empty() || !dec_b.Match(instrs.back()) || transitions.empty()) {
+                      return;
+                   }
+
+                   auto jump = dynamic_cast<JumpTransition *>(transitions.front());
+                   if (jump == nullptr || dynamic_cast<DjnzTransition *>(jump) ||
+                       jump->cond() != Cond::NZ ||
+                       std::any_of(transitions.begin() + 1, transitions.end(),
+                                   [](auto trans) { return trans->cond() != Cond::ANY; })) {
+                      return;
+                   }
+
+                   int djnz_offset = offsets.at(block->label()->name());
+                   std::for_each(instrs.begin(), std::prev(instrs.end()),
+                                 [&](const Instruction *instr) {
+                                    djnz_offset += instr->bytes();
+                                 });
+                   int disp = offsets.at(jump->dst()->label()->name()) - djnz_offset;
+                   if (disp < djnz_min || disp > djnz_max) { return; }
+
+                   instrs.pop_back();
+                   transitions.front() = new DjnzTransition(jump->dst());
+                   closed = true;
+                };
+      impl.entry()->for_each_block(visited, fn);
+      impl.fin()->for_each_block(visited, fn);
+
+      return closed;
+   }
+
+}
@@ -0,0 +1,142 @@
+/* frame elision */
+
+#include "optim.hpp"
+#include "cgen.hpp"
+#include "asm.hpp"
+
+namespace zc {
+
+   using namespace z80;
+
+   namespace {
+
+      /**
+       * Match instruction sequence at beginning of block.
+       * @return whether all patterns matched
+       */
+      bool match_prefix(const Block *block, std::initializer_list<const Instruction *> pattern) {
+         auto it = block->instrs().begin();
+         for (const Instruction *instr : pattern) {
+            if (it == block->instrs().end() || !instr->Match(*it)) { return false; }
+            ++it;
+         }
+         return true;
+      }
+
+      /**
+       * Rebase frame-relative value from ix onto iy.
+       * @param delta amount to add to each ix index
+       * @param indexed set if value addresses the frame
+       * @return rebased value; nullptr if ix is used other than as an index base
+       */
+      const Value *rebase_frame(const Value *val, int delta, bool& indexed) {
+         if (auto mem = dynamic_cast<const MemoryValue *>(val)) {
+            const Value *addr = rebase_frame(mem->addr(), delta, indexed);
+            if (addr == nullptr || addr == mem->addr()) { return addr ? val : nullptr; }
+            return value_pool().Mem(addr, mem->size());
+         }
+
+         if (auto idx = dynamic_cast<const IndexedRegisterValue *>(val)) {
+            if (!idx->reg()->Eq(&r_ix)) { return val; }
+            indexed = true;
+            return value_pool().Indexed(&rv_iy, IndexedRegisterValue::Index
+                                        (static_cast<int8_t>(idx->index() + delta)));
+         }
+
+         if (auto byte = dynamic_cast<const ByteValue *>(val)) {
+            const Value *all = rebase_frame(byte->all(), delta, indexed);
+            if (all == nullptr || all == byte->all()) { return all ? val : nullptr; }
+            return new ByteValue(all, byte->kind());
+         }
+
+         if (val->reg() && val->reg()->overlaps(&r_ix)) { return nullptr; }
+         return val;
+      }
+
+   }
+
+   bool ElideFrame(FunctionImpl& impl) {
+      /* frameset with no locals:
+       * push ix
+       * ld ix,0
+       * add ix,sp
+       * ld sp,ix
+       */
+      static int size;
+      static const ImmediateValue imm_0((intmax_t) 0, &size);
+      static const PushInstruction set1(&rv_ix);
+      static const LoadInstruction set2(&rv_ix, &imm_0);
+      static const AddInstruction set3(&rv_ix, &rv_sp);
+      static const LoadInstruction set4(&rv_sp, &rv_ix);
+
+      /* frameunset with no locals:
+       * lea ix,ix+0
+       * ld sp,ix
+       * pop ix
+       */
+      static const IndexedRegisterValue idx_0(&rv_ix, 0);
+      static const LeaInstruction unset1(&rv_ix, &idx_0);
+      static const LoadInstruction unset2(&rv_sp, &rv_ix);
+      static const PopInstruction unset3(&rv_ix);
+
+      Block *entry = impl.entry();
+      Block *fin = impl.fin();
+      if (!match_prefix(entry, {&set1, &set2, &set3, &set4}) ||
+          !match_prefix(fin, {&unset1, &unset2, &unset3})) {
+         return false;
+      }
+
+      /* collect blocks; the epilogue's callee-pop sequence may use iy, but runs after every
+       * argument access */
+      Blocks visited;
+      std::vector<Block *> blocks;
+      entry->for_each_block(visited, [&](Block *block) {
+                                        if (block != fin) { blocks.push_back(block); }
+                                     });
+
+      /* without the saved ix, arguments sit 3 bytes closer to sp on entry */
+      const int delta = -long_size;
+      bool indexed = false;
+      bool calls = false;
+      bool uses_iy = false;
+      for (Block *block : blocks) {
+         auto it = block->instrs().begin();
+         if (block == entry) { std::advance(it, 4); }
+         for (; it != block->instrs().end(); ++it) {
+            calls |= (*it)->opcode() == Opcode::CALL;
+            for (const auto& operand : (*it)->operands()) {
+               if (rebase_frame(*operand, delta, indexed) == nullptr) { return false; }
+               uses_iy |= (*operand)->reg() && (*operand)->reg()->overlaps(&r_iy);
+            }
+         }
+      }
+
+      /* iy holds the entry stack pointer; callees (including the CRT) may clobber it */
+      if (indexed && (calls || uses_iy)) { return false; }
+
+      entry->instrs().erase(entry->instrs().begin(), std::next(entry->instrs().begin(), 4));
+      fin->instrs().erase(fin->instrs().begin(), std::next(fin->instrs().begin(), 3));
+
+      if (indexed) {
+         for (Block *block : blocks) {
+            for (Instruction *instr : block->instrs()) {
+               for (auto& operand : instr->operands()) {
+                  operand = rebase_frame(*operand, delta, indexed);
+               }
+            }
+         }
+
+         /* ld iy,0
+          * add iy,sp
+          */
+         Instructions instrs
+            {new LoadInstruction(&rv_iy, value_pool().Imm(0, long_size)),
+             new AddInstruction(&rv_iy, &rv_sp)
+            };
+         entry->instrs().insert(entry->instrs().begin(), instrs.begin(), instrs.end());
+      }
+
+      return true;
+   }
+
+}
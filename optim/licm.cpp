@@ -0,0 +1,234 @@
+/* loop-invariant code motion */
+
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "optim.hpp"
+#include "cgen.hpp"
+#include "asm.hpp"
+#include "alg.hpp"
+#include "alg/alg-live.hpp"
+#include "alg/alg-loop.hpp"
+
+namespace zc {
+
+   using namespace z80;
+
+   namespace {
+
+      /* variable bytes that may stay in registers across a loop: those of bc and de, since
+       * codegen routes most values through a and hl */
+      constexpr int max_loop_pressure = 2 * long_size;
+
+      /**
+       * @return variable that value is or is a byte of; nullptr otherwise
+       */
+      const VariableValue *var_of(const Value *val) {
+         if (auto byte = dynamic_cast<const ByteValue *>(val)) { val = byte->all(); }
+         return dynamic_cast<const VariableValue *>(val);
+      }
+
+      template <typename Func>
+      void for_each_var(const Instruction *instr, bool kills, Func func) {
+         alg::ValueSet vals;
+         if (kills) {
+            instr->Kill(std::inserter(vals, vals.begin()));
+         } else {
+            instr->Gen(std::inserter(vals, vals.begin()));
+         }
+         for (const Value *val : vals) {
+            if (const VariableValue *var = var_of(val)) { func(var); }
+         }
+      }
+
+      /**
+       * @return greatest number of variable bytes live at once in loop
+       */
+      int loop_pressure(const alg::Loop& loop, const alg::Liveness& live,
+                        const std::unordered_map<int, const VariableValue *>& vars) {
+         int max = 0;
+         for (const Block *block : loop.blocks) {
+            std::unordered_map<int, int> live_vars;
+            int bytes = 0;
+            for (const auto& pair : vars) {
+               if (live.live_out(block, pair.second)) {
+                  live_vars[pair.first] = pair.second->size();
+                  bytes += pair.second->size();
+               }
+            }
+            max = std::max(max, bytes);
+
+            for (auto it = block->instrs().rbegin(); it != block->instrs().rend(); ++it) {
+               for_each_var(*it, true, [&](const VariableValue *var) {
+                                          auto live_it = live_vars.find(var->id());
+                                          if (live_it != live_vars.end()) {
+                                             bytes -= live_it->second;
+                                             live_vars.erase(live_it);
+                                          }
+                                       });
+               for_each_var(*it, false, [&](const VariableValue *var) {
+                                           if (live_vars.insert({var->id(), var->size()}).second) {
+                                              bytes += var->size();
+                                           }
+                                        });
+               max = std::max(max, bytes);
+            }
+         }
+         return max;
+      }
+
+      /**
+       * Check whether instruction computes a loop-invariant value: a constant, an address in
+       * the frame or in static memory, or a copy of a variable not assigned in the loop.
+       * @param variant variables assigned in the loop
+       */
+      bool is_invariant(const Instruction *instr, const std::unordered_set<int>& variant) {
+         const Value *src = instr->src();
+         switch (instr->opcode()) {
+         case Opcode::LD:
+            if (dynamic_cast<const ImmediateValue *>(src) ||
+                dynamic_cast<const LabelValue *>(src)) {
+               return true;
+            }
+            if (auto var = dynamic_cast<const VariableValue *>(src)) {
+               return variant.find(var->id()) == variant.end();
+            }
+            return false;
+
+         case Opcode::LEA:
+            if (dynamic_cast<const FrameValue *>(src) || dynamic_cast<const LabelValue *>(src)) {
+               return true;
+            }
+            if (auto idx = dynamic_cast<const IndexedRegisterValue *>(src)) {
+               return idx->reg()->Eq(&r_ix);
+            }
+            return false;
+
+         default:
+            return false;
+         }
+      }
+
+      /**
+       * Hoist invariant definitions out of loop, as long as the registers they tie up across
+       * the loop don't push it over @see max_loop_pressure.
+       * @param defs number of definitions of each variable in function
+       * @return whether any instruction was hoisted
+       */
+      bool hoist_loop(const alg::Loops& loops, const alg::Loop& loop, const alg::Liveness& live,
+                      const std::unordered_map<int, int>& defs,
+                      const std::unordered_map<int, const VariableValue *>& vars) {
+         /* loop must be entered only through transitions that can be redirected */
+         Block *header = loop.header;
+         std::vector<Block *> entries;
+         for (Block *pred : loops.preds(header)) {
+            if (loop.contains(pred)) { continue; }
+            for (const BlockTransition *trans : pred->transitions().vec()) {
+               if (trans->dst() == header &&
+                   dynamic_cast<const JumpTransition *>(trans) == nullptr) {
+                  return false;
+               }
+            }
+            entries.push_back(pred);
+         }
+         if (entries.empty()) { return false; }
+
+         /* calls clobber the registers that hoisted values would occupy */
+         std::unordered_set<int> variant;
+         for (const Block *block : loop.blocks) {
+            for (const Instruction *instr : block->instrs()) {
+               if (instr->opcode() == Opcode::CALL) { return false; }
+               for_each_var(instr, true, [&](const VariableValue *var) {
+                                            variant.insert(var->id());
+                                         });
+            }
+         }
+
+         /* collect invariant definitions in order, so hoisted copies follow their sources */
+         int pressure = loop_pressure(loop, live, vars);
+         Instructions hoisted;
+         for (Block *block : loop.blocks) {
+            Instructions& instrs = block->instrs();
+            for (auto it = instrs.begin(); it != instrs.end(); ) {
+               auto dst = dynamic_cast<const VariableValue *>((*it)->dst());
+               auto def_it = dst ? defs.find(dst->id()) : defs.end();
+               if (def_it == defs.end() || def_it->second != 1 || !is_invariant(*it, variant) ||
+                   pressure + dst->size() > max_loop_pressure) {
+                  ++it;
+                  continue;
+               }
+
+               pressure += dst->size();
+               variant.erase(dst->id());
+               hoisted.push_back(*it);
+               it = instrs.erase(it);
+            }
+         }
+         if (hoisted.empty()) { return false; }
+
+         /* append to sole entry block that falls into loop; otherwise insert preheader */
+         Block *pre;
+         if (entries.size() == 1 && entries.front()->transitions().vec().size() == 1 &&
+             entries.front()->transitions().vec().front()->cond() == Cond::ANY) {
+            pre = entries.front();
+         } else {
+            pre = new Block(new_label("loop_pre"));
+            pre->transitions().vec().push_back(new JumpTransition(header, Cond::ANY));
+            for (Block *entry : entries) {
+               for (BlockTransition *& trans : entry->transitions().vec()) {
+                  if (trans->dst() == header) { trans = new JumpTransition(pre, trans->cond()); }
+               }
+            }
+         }
+         pre->instrs().insert(pre->instrs().end(), hoisted.begin(), hoisted.end());
+
+         return true;
+      }
+
+   }
+
+   bool HoistInvariants(FunctionImpl& impl) {
+      std::vector<Block *> headers;
+      {
+         alg::Loops loops(impl);
+         for (const Block *block : loops.order()) {
+            /* goto targets may enter loops without passing through a preheader */
+            const std::string& name = block->label()->name();
+            if (block != impl.entry() && block != impl.fin() && name.rfind("__LABEL_", 0) != 0) {
+               return false;
+            }
+         }
+         for (const alg::Loop& loop : loops.loops()) { headers.push_back(loop.header); }
+      }
+
+      /* innermost loops first, so that their invariants can move on out of enclosing loops */
+      bool changed = false;
+      for (const Block *header : headers) {
+         alg::Loops loops(impl);
+         alg::Liveness live(impl);
+
+         std::unordered_map<int, int> defs;
+         std::unordered_map<int, const VariableValue *> vars;
+         for (const Block *block : loops.order()) {
+            for (const Instruction *instr : block->instrs()) {
+               for_each_var(instr, true, [&](const VariableValue *var) {
+                                            ++defs[var->id()];
+                                            vars[var->id()] = var;
+                                         });
+               for_each_var(instr, false, [&](const VariableValue *var) {
+                                             vars[var->id()] = var;
+                                          });
+            }
+         }
+
+         auto it = std::find_if(loops.loops().begin(), loops.loops().end(),
+                                [&](const alg::Loop& loop) { return loop.header == header; });
+         changed |= hoist_loop(loops, *it, live, defs, vars);
+      }
+
+      return changed;
+   }
+
+}
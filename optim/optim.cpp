@@ -1,4 +1,6 @@
 #include <cstring>
+#include <chrono>
+#include <algorithm>
 
 #include "optim.hpp"
 #include "ast.hpp"
@@ -19,20 +21,39 @@ namespace zc {
       /* pass 0: register allocation */
       // RegisterAllocator::Ralloc(env);
 
-      /* pass 1: peephole optimization */
+      /* pass 1: frame elision */
+      if (g_optim.frame_elision) {
+         for (FunctionImpl& impl : env.impls().impls()) {
+            ElideFrame(impl);
+         }
+      }
+
+      /* pass 2: peephole optimization */
       if (g_optim.peephole) {
+         auto start = std::chrono::steady_clock::now();
+         PeepholeMatcher matcher(peephole_optims.begin(), peephole_optims.end());
          for (FunctionImpl& impl : env.impls().impls()) {
-            for (PeepholeOptimization& optim : peephole_optims) {
-               optim.Pass(&impl);
-            }
+            matcher.Pass(&impl);
          }
+         std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
 
          if (g_print.peephole_stats) {
-            std::cerr << "peephole-stats:" << std::endl << "NAME\t\tHITS\tTOTAL\tSAVED" << std::endl;
+            std::cerr << "peephole-stats:" << std::endl
+                      << "NAME\t\tHITS\tTOTAL\tBYTES\tCYCLES" << std::endl;
             for (PeepholeOptimization& optim : peephole_optims) {
                optim.Dump(std::cerr);
                std::cerr << std::endl;
             }
+            std::cerr << "(" << matcher.instrs() << " instructions, "
+                      << elapsed.count() / std::max<std::size_t>(matcher.instrs(), 1)
+                      << " ns/instruction)" << std::endl;
+         }
+      }
+
+      /* pass 3: djnz; last, since deserialization would duplicate the djnz as an instruction */
+      if (g_optim.counted_loops) {
+         for (FunctionImpl& impl : env.impls().impls()) {
+            CloseCountedLoops(impl);
          }
       }
    }
@@ -41,11 +62,19 @@ namespace zc {
 
    CgenOptimInfo g_optim ({
       {"join-vars", &CgenOptimInfo::join_vars},
+      {"function-ralloc", &CgenOptimInfo::function_ralloc},
+      {"licm", &CgenOptimInfo::licm},
       {"reduce-const", &CgenOptimInfo::reduce_const},
       {"peephole", &CgenOptimInfo::peephole},
       {"bool-flag", &CgenOptimInfo::bool_flag},
+      {"strength-reduce", &CgenOptimInfo::strength_reduce},
+      {"jump-tables", &CgenOptimInfo::jump_tables},
+      {"counted-loops", &CgenOptimInfo::counted_loops},
       {"minimize-transitions", &CgenOptimInfo::minimize_transitions},
       {"direct-call", &CgenOptimInfo::direct_call},
+      {"reg-call", &CgenOptimInfo::reg_call},
+      {"callee-pop", &CgenOptimInfo::callee_pop},
+      {"frame-elision", &CgenOptimInfo::frame_elision},
       {"DAG", &CgenOptimInfo::DAG},
    });
 
@@ -113,6 +142,12 @@ namespace zc {
       }
    }
 
+   ASTStat *SwitchStat::ReduceConst() {
+      expr_ = expr()->ReduceConst();
+      body_ = body()->ReduceConst();
+      return this;
+   }
+
    ASTStat *IterationStat::ReduceConst() {
       pred_ = pred()->ReduceConst();
       body_ = body()->ReduceConst();
@@ -1,55 +1,153 @@
 #include <list>
+#include <algorithm>
 
 #include "peephole.hpp"
 #include "asm.hpp"
 #include "optim.hpp"
+#include "alg.hpp"
 
 namespace zc::z80 {
 
-   void PeepholeOptimization::ReplaceAll(Instructions& input) {
-      for (const_iterator it = input.begin(), end = input.end(); it != end; ) {
-         it = ReplaceAt(input, it);
-      }
-   }
-
-   Instructions::const_iterator PeepholeOptimization::ReplaceAt(Instructions& input,
-                                                                const_iterator it) {
+   bool PeepholeOptimization::ReplaceAt(Instructions& input, const_iterator& it) {
       Instructions new_instrs;
       const_iterator rm_end = replace_(it, input.end(), new_instrs);
-      
-      if (rm_end != it) {
-         ++hits_;
-      }
       ++total_;
-      
-      const_iterator ret_it;
+      if (rm_end == it) {
+         return false;
+      }
+      ++hits_;
+
+      for (const_iterator rm_it = it; rm_it != rm_end; ++rm_it) {
+         Cost cost = (*rm_it)->cost();
+         bytes_saved_ += cost.bytes;
+         cycles_saved_ += cost.cycles;
+      }
+      for (const Instruction *instr : new_instrs) {
+         Cost cost = instr->cost();
+         bytes_saved_ -= cost.bytes;
+         cycles_saved_ -= cost.cycles;
+      }
+
       const_iterator new_end = input.erase(it, rm_end);
+      it = new_instrs.empty() ? new_end : new_instrs.begin();
       input.splice(new_end, new_instrs);
-      if (it == rm_end) {
-         ++new_end;
+      return true;
+   }
+
+   void PeepholeOptimization::Dump(std::ostream& os) const {
+      os << name_ << "\t" << hits_ << "\t" << total_ << "\t" << bytes_saved_ << "\t"
+         << cycles_saved_;
+   }
+
+   /*** MATCHER ***/
+
+   void PeepholeMatcher::Add(PeepholeOptimization *optim) {
+      int node = 0;
+      for (Opcode opcode : optim->opcodes()) {
+         int& child = nodes_[node].children[static_cast<std::size_t>(opcode)];
+         if (child == 0) {
+            child = nodes_.size();
+            nodes_.emplace_back();
+         }
+         node = nodes_[node].children[static_cast<std::size_t>(opcode)];
       }
-      return new_end;
+      nodes_[node].optims.push_back({count_++, optim});
+      max_len_ = std::max(max_len_, optim->opcodes().size());
    }
 
-   void PeepholeOptimization::PassBlock(Block *block, PeepholeOptimization *optim) {
-      Instructions& instrs = block->instrs();
-      optim->ReplaceAll(instrs);
+   bool PeepholeMatcher::ReplaceAt(Instructions& input, const_iterator& it) {
+      /* collect optimizations whose opcode sequence matches at this position */
+      std::vector<std::pair<int, PeepholeOptimization *>> candidates;
+      int node = 0;
+      for (const_iterator instr_it = it; instr_it != input.end(); ++instr_it) {
+         int child = nodes_[node].children[static_cast<std::size_t>((*instr_it)->opcode())];
+         if (child == 0) { break; }
+         node = child;
+         candidates.insert(candidates.end(), nodes_[node].optims.begin(),
+                           nodes_[node].optims.end());
+      }
+
+      /* try in order of declaration */
+      std::sort(candidates.begin(), candidates.end());
+      for (auto& candidate : candidates) {
+         if (candidate.second->ReplaceAt(input, it)) {
+            return true;
+         }
+      }
+      return false;
    }
 
-   void PeepholeOptimization::Pass(FunctionImpl *impl) {
+   void PeepholeMatcher::ReplaceAll(Instructions& input) {
+      instrs_ += input.size();
+      for (const_iterator it = input.begin(); it != input.end(); ) {
+         if (ReplaceAt(input, it)) {
+            /* back up so that windows overlapping the replacement are matched again; since
+             * replacements always shrink the stream, this reaches a fixpoint. */
+            for (std::size_t i = 1; i < max_len_ && it != input.begin(); ++i) {
+               --it;
+            }
+         } else {
+            ++it;
+         }
+      }
+   }
+
+   void PeepholeMatcher::PassBlock(Block *block, PeepholeMatcher *matcher) {
+      matcher->ReplaceAll(block->instrs());
+   }
+
+   void PeepholeMatcher::Pass(FunctionImpl *impl) {
       Blocks visited;
-      void (*fn)(Block *block, PeepholeOptimization *optim) =
-         PeepholeOptimization::PassBlock;
+      void (*fn)(Block *block, PeepholeMatcher *matcher) = PeepholeMatcher::PassBlock;
       impl->entry()->for_each_block(visited, fn, this);
       impl->fin()->for_each_block(visited, fn, this);
    }
 
-   void PeepholeOptimization::Dump(std::ostream& os) const {
-      os << name_ << "\t" << hits_ << "\t" << total_ << "\t" << bytes_saved_ * hits_;
-   }
-
    /*** PEEPHOLE OPTIMIZATION FUNCTIONS ***/
 
+   /* Patterns are function-local statics built on first use. Their unbound values are also
+    * static, so matching binds in place and allocates nothing; replacement instructions and
+    * values are created only once the whole sequence has matched. */
+
+   /**
+    * Whether register is overwritten before being read, scanning forward within block.
+    * Control flow ends the scan conservatively, as the register may be live at the target.
+    */
+   static bool reg_dead_after(const Register *reg, Instructions::const_iterator it,
+                              Instructions::const_iterator end) {
+      const auto vals_mask = [](const alg::ValueSet& vals) {
+         RegMask mask = 0;
+         for (const Value *val : vals) {
+            if (const Register *val_reg = val->reg()) { mask |= val_reg->mask(); }
+         }
+         return mask;
+      };
+
+      RegMask live = reg->mask();
+      for (; it != end; ++it) {
+         switch ((*it)->opcode()) {
+         case Opcode::CALL:
+         case Opcode::DJNZ:
+         case Opcode::JP:
+         case Opcode::JR:
+         case Opcode::LABEL:
+         case Opcode::RET:
+         case Opcode::RET_CC:
+            return false;
+         default:
+            break;
+         }
+
+         alg::ValueSet gens, kills;
+         (*it)->Gen(std::inserter(gens, gens.begin()));
+         if (vals_mask(gens) & live) { return false; }
+         (*it)->Kill(std::inserter(kills, kills.begin()));
+         live &= ~vals_mask(kills);
+         if (live == 0) { return true; }
+      }
+      return false;
+   }
+
    /* Indexed Register Load/Store
     * lea rr1,ix+*
     * ld (rr1),v | ld r2,(rr1)
@@ -64,41 +162,48 @@ namespace zc::z80 {
       const auto no_match = [&](){ out.clear(); return begin; };
 
       /* unbound values */
-      const Register *rr1;
-      const Register *rr2;
-      IndexedRegisterValue::Index frame_index;
+      static const Register *rr1, *rr1_3;
+      static const Register *rr2;
+      static int rr2_size;
+      static IndexedRegisterValue::Index frame_index;
+
+      /* patterns */
+      static const RegisterValue rr1_1(&rr1, long_size);
+      static const IndexedRegisterValue idx_(&rv_ix, &frame_index);
+      static const LeaInstruction instr1(&rr1_1, &idx_);
+      static const RegisterValue rr1_3v(&rr1_3, long_size);
+      static const MemoryValue rr1_v_3(&rr1_3v, long_size);
+      static const RegisterValue rr2_3(&rr2, &rr2_size);
+      static const LoadInstruction instr3a(&rr1_v_3, &rr2_3);
+      static const LoadInstruction instr3b(&rr2_3, &rr1_v_3);
       
       /* instruction 1: lea rr1,ix+* */
       if (it == end) { return no_match(); }
-      const RegisterValue rr1_1(&rr1, long_size);
-      const IndexedRegisterValue idx_(&rv_ix, &frame_index);
-      const LeaInstruction instr1(&rr1_1, &idx_);
       if (!instr1.Match(*it)) { return no_match(); }
       ++it;
       
       /* instruction 3: ld (rr1),rr2 | ld rr2,(rr1) */
       if (it == end) { return no_match(); }
-      const RegisterValue rr1_3(rr1);
-      const MemoryValue rr1_v_3(&rr1_3, long_size);
-      int rr2_size;
-      const RegisterValue rr2_3(&rr2, &rr2_size);
-      const LoadInstruction instr3a(&rr1_v_3, &rr2_3);
-      const LoadInstruction instr3b(&rr2_3, &rr1_v_3);
-      const MemoryValue *memval = new MemoryValue
-         (new IndexedRegisterValue(&rv_ix, frame_index), &rr2_size);
-      const Value *dst, *src;
+      bool store;
       if (instr3a.Match(*it)) {
          /* instruction 3a: ld (rr1),rr2 */
-         dst = memval;
-         src = new RegisterValue(rr2, rr2_size);
+         store = true;
       } else if (instr3b.Match(*it)) {
          /* instruction 3b: ld rr2,(rr1) */
-         dst = new RegisterValue(rr2, rr2_size);
-         src = memval;
+         store = false;
       } else {
          return no_match();
       }
+      if (!rr1_3->Eq(rr1)) { return no_match(); }
       ++it;
+
+      /* the address in rr1 mustn't be needed afterwards, unless the load overwrites it */
+      if (!(!store && rr2->Eq(rr1)) && !reg_dead_after(rr1, it, end)) { return no_match(); }
+
+      const Value *memval = value_pool().Mem(value_pool().Indexed(&rv_ix, frame_index), rr2_size);
+      const Value *regval = value_pool().Reg(rr2, rr2_size);
+      const Value *dst = store ? memval : regval;
+      const Value *src = store ? regval : memval;
       
       /* generate replacement */
       out.push_back(new LoadInstruction(dst, src));
@@ -106,6 +211,7 @@ namespace zc::z80 {
       return it;
    }
 
+
    Instructions::const_iterator peephole_push_pop(Instructions::const_iterator begin,
                                                   Instructions::const_iterator end,
                                                   Instructions& out) {
@@ -116,29 +222,33 @@ namespace zc::z80 {
       const auto no_match = [&](){ out.clear(); return begin; };
 
       /* unbound values */
-      const Register *rr1;
-      const Register *rr2;
+      static const Register *rr1;
+      static const Register *rr2;
+
+      /* patterns */
+      static const RegisterValue rr1_1(&rr1, long_size);
+      static const PushInstruction instr1(&rr1_1);
+      static const RegisterValue rr2_2(&rr2, long_size);
+      static const PopInstruction instr2(&rr2_2);
 
       /* instruction 1: push rr1 */
       if (it == end) { return no_match(); }
-      const RegisterValue rr1_1(&rr1, long_size);
-      const PushInstruction instr1(&rr1_1);
       if (!instr1.Match(*it)) { return no_match(); }
       ++it;
 
       /* instruction 2: pop rr2 */
       if (it == end) { return no_match(); }
-      const RegisterValue rr2_2(&rr2, long_size);
-      const PopInstruction instr2(&rr2_2);
       if (!instr2.Match(*it)) { return no_match(); }
       ++it;
 
       /* if rr1 == rr2, delete matched sequence */
       if (rr1->Eq(rr2)) { return it; }
 
-      /* if rr1 == de and rr2 == hl or vice versa, replace with `ex de,hl` */
-      if ((rr1->Eq(&r_de) && rr2->Eq(&r_hl)) ||
-          (rr1->Eq(&r_hl) && rr2->Eq(&r_de))) {
+      /* if rr1 == de and rr2 == hl or vice versa, replace with `ex de,hl`, which also
+       * overwrites rr1 */
+      if (((rr1->Eq(&r_de) && rr2->Eq(&r_hl)) ||
+           (rr1->Eq(&r_hl) && rr2->Eq(&r_de))) &&
+          reg_dead_after(rr1, it, end)) {
          out.push_back(new ExInstruction(&rv_de, &rv_hl));
          return it;
       }
@@ -156,26 +266,29 @@ namespace zc::z80 {
       const auto no_match = [&](){ out.clear(); return begin; };
 
       /* unbound values */
-      const Register *rr;
-      IndexedRegisterValue::Index index;
+      static const Register *rr, *rr_2;
+      static IndexedRegisterValue::Index index;
+
+      /* patterns */
+      static const RegisterValue rv_1(&rr, long_size);
+      static const IndexedRegisterValue ir_1(&rv_ix, &index);
+      static const LeaInstruction instr1(&rv_1, &ir_1);
+      static const RegisterValue rv_2(&rr_2, long_size);
+      static const PushInstruction instr2(&rv_2);
 
       /* instruction 1 */
       if (it == end) { return no_match(); }
-      const RegisterValue rv_1(&rr, long_size);
-      const IndexedRegisterValue ir_1(&rv_ix, &index);
-      const LeaInstruction instr1(&rv_1, &ir_1);
       if (!instr1.Match(*it)) { return no_match(); }
       ++it;
 
       /* instruction 2 */
       if (it == end) { return no_match(); }      
-      const RegisterValue rv_2(rr);
-      const PushInstruction instr2(&rv_2);
       if (!instr2.Match(*it)) { return no_match(); }
+      if (!rr_2->Eq(rr)) { return no_match(); }
       ++it;
 
       /* replace */
-      out.push_back(new PeaInstruction(new IndexedRegisterValue(&rv_ix, index)));
+      out.push_back(new PeaInstruction(value_pool().Indexed(&rv_ix, index)));
       return it;
    }
 
@@ -187,13 +300,15 @@ namespace zc::z80 {
       const auto no_match = [&](){ out.clear(); return begin; };      
 
       /* unbound values */
-      const Register *r1, *r2;
-      int size;
+      static const Register *r1, *r2;
+      static int size;
+
+      /* patterns */
+      static const RegisterValue rv1(&r1, &size);
+      static const RegisterValue rv2(&r2, &size);
+      static const LoadInstruction instr(&rv1, &rv2);
       
       if (it == end) { return no_match(); }
-      const RegisterValue rv1(&r1, &size);
-      const RegisterValue rv2(&r2, &size);
-      const LoadInstruction instr(&rv1, &rv2);
       if (!instr.Match(*it)) { return no_match(); }
       if (!r1->Eq(r2)) { return no_match(); }
       ++it;
@@ -214,10 +329,11 @@ namespace zc::z80 {
       Instructions::const_iterator it = begin;
       const auto no_match = [&]() { out.clear(); return begin; };
 
-      int size;
-      const LoadInstruction instr1(&rv_ix, new ImmediateValue((intmax_t) 0, &size));
-      const AddInstruction instr2(&rv_ix, &rv_sp);
-      const LoadInstruction instr3(&rv_sp, &rv_ix);
+      static int size;
+      static const ImmediateValue imm_0((intmax_t) 0, &size);
+      static const LoadInstruction instr1(&rv_ix, &imm_0);
+      static const AddInstruction instr2(&rv_ix, &rv_sp);
+      static const LoadInstruction instr3(&rv_sp, &rv_ix);
 
       for (const Instruction *instr : {(const Instruction *) &instr1,
                                           (const Instruction *) &instr2,
@@ -243,9 +359,9 @@ namespace zc::z80 {
       Instructions::const_iterator it = begin;
       const auto no_match = [&]() { out.clear(); return begin; };
 
-      const IndexedRegisterValue idx(&rv_ix, 0);
-      const LeaInstruction instr1(&rv_ix, &idx);
-      const LoadInstruction instr2(&rv_sp, &rv_ix);
+      static const IndexedRegisterValue idx(&rv_ix, 0);
+      static const LeaInstruction instr1(&rv_ix, &idx);
+      static const LoadInstruction instr2(&rv_sp, &rv_ix);
 
       if (it == end) { return no_match(); }
       if (!instr1.Match(*it)) { return no_match(); }
@@ -266,11 +382,11 @@ namespace zc::z80 {
       Instructions::const_iterator it = begin;
       const auto no_match = [&]() { out.clear(); return begin; };
 
-      const Register *xy1, *xy2;
-      const RegisterValue xyv1(&xy1, long_size);
-      const RegisterValue xyv2(&xy2, long_size);
-      const IndexedRegisterValue idx(&xyv2, 0);
-      const LeaInstruction instr(&xyv1, &idx);
+      static const Register *xy1, *xy2;
+      static const RegisterValue xyv1(&xy1, long_size);
+      static const RegisterValue xyv2(&xy2, long_size);
+      static const IndexedRegisterValue idx(&xyv2, 0);
+      static const LeaInstruction instr(&xyv1, &idx);
 
       if (it == end) { return no_match(); }
       if (!instr.Match(*it)) { return no_match(); }
@@ -281,14 +397,130 @@ namespace zc::z80 {
       return it;
    }
    
+   /**
+    * Match stack pointer adjustment.
+    * ld xy,<bytes>
+    * add xy,sp
+    * ld sp,xy
+    * @param it position; advanced past sequence on match
+    * @return whether matched
+    */
+   static bool match_sp_add(Instructions::const_iterator& it, Instructions::const_iterator end,
+                            const Register **xy, intmax_t *bytes) {
+      /* unbound values */
+      static const Register *xy1, *xy2, *xy3;
+      static intmax_t imm;
+      static int size;
+
+      /* patterns */
+      static const RegisterValue xyv1(&xy1, long_size);
+      static const ImmediateValue imm_1(&imm, &size);
+      static const LoadInstruction instr1(&xyv1, &imm_1);
+      static const RegisterValue xyv2(&xy2, long_size);
+      static const AddInstruction instr2(&xyv2, &rv_sp);
+      static const RegisterValue xyv3(&xy3, long_size);
+      static const LoadInstruction instr3(&rv_sp, &xyv3);
+
+      Instructions::const_iterator instr_it = it;
+      for (const Instruction *instr : {(const Instruction *) &instr1,
+                                          (const Instruction *) &instr2,
+                                          (const Instruction *) &instr3}) {
+         if (instr_it == end || !instr->Match(*instr_it)) { return false; }
+         ++instr_it;
+      }
+      if (!xy1->Eq(xy2) || !xy1->Eq(xy3)) { return false; }
+
+      it = instr_it;
+      *xy = xy1;
+      *bytes = imm;
+      return true;
+   }
+
+   Instructions::const_iterator peephole_sp_add_merge(Instructions::const_iterator begin,
+                                                      Instructions::const_iterator end,
+                                                      Instructions& out) {
+      /* ld xy,<n1> \ add xy,sp \ ld sp,xy
+       * ld xy,<n2> \ add xy,sp \ ld sp,xy
+       * ------------
+       * ld xy,<n1+n2> \ add xy,sp \ ld sp,xy
+       */
+      Instructions::const_iterator it = begin;
+      const auto no_match = [&]() { out.clear(); return begin; };
+
+      const Register *xy1, *xy2;
+      intmax_t n1, n2;
+      if (!match_sp_add(it, end, &xy1, &n1)) { return no_match(); }
+      if (!match_sp_add(it, end, &xy2, &n2)) { return no_match(); }
+      if (!xy1->Eq(xy2)) { return no_match(); }
+
+      const RegisterValue *xyv = value_pool().Reg(xy1);
+      out.push_back(new LoadInstruction(xyv, value_pool().Imm(n1 + n2, long_size)));
+      out.push_back(new AddInstruction(xyv, &rv_sp));
+      out.push_back(new LoadInstruction(&rv_sp, xyv));
+      return it;
+   }
+
+   Instructions::const_iterator peephole_push_discard(Instructions::const_iterator begin,
+                                                      Instructions::const_iterator end,
+                                                      Instructions& out) {
+      /* push rr
+       * inc sp \ inc sp \ inc sp | ld xy,<n> \ add xy,sp \ ld sp,xy
+       * ------------
+       * _ | ld xy,<n-3> \ add xy,sp \ ld sp,xy
+       */
+      Instructions::const_iterator it = begin;
+      const auto no_match = [&]() { out.clear(); return begin; };
+
+      /* unbound values */
+      static const Register *rr;
+
+      /* patterns */
+      static const RegisterValue rv_1(&rr, long_size);
+      static const PushInstruction instr1(&rv_1);
+      static const IncInstruction inc_sp(&rv_sp);
+
+      if (it == end || !instr1.Match(*it)) { return no_match(); }
+      ++it;
+
+      const Register *xy;
+      intmax_t n;
+      if (match_sp_add(it, end, &xy, &n)) {
+         if (n < long_size) { return no_match(); }
+         if (n > long_size) {
+            const RegisterValue *xyv = value_pool().Reg(xy);
+            out.push_back(new LoadInstruction(xyv, value_pool().Imm(n - long_size, long_size)));
+            out.push_back(new AddInstruction(xyv, &rv_sp));
+            out.push_back(new LoadInstruction(&rv_sp, xyv));
+         }
+         return it;
+      }
+
+      for (int i = 0; i < long_size; ++i) {
+         if (it == end || !inc_sp.Match(*it)) { return no_match(); }
+         ++it;
+      }
+      return it;
+   }
+   
    std::forward_list<PeepholeOptimization> peephole_optims = 
-      {PeepholeOptimization("indexed-load", peephole_indexed_load_store, 2),
-       PeepholeOptimization("push-pop", peephole_push_pop, 2), 
-       PeepholeOptimization("pea", peephole_pea, 1),
-       PeepholeOptimization("self-load", peephole_self_load, 1),
-       PeepholeOptimization("frameset-0", peephole_frameset_0, 2),
-       PeepholeOptimization("frameunset-0", peephole_frameunset_0, 5),
-       PeepholeOptimization("lea-nop", peephole_lea_nop, 3),
+      {PeepholeOptimization("indexed-load", {Opcode::LEA, Opcode::LD},
+                            peephole_indexed_load_store),
+       PeepholeOptimization("push-pop", {Opcode::PUSH, Opcode::POP}, peephole_push_pop), 
+       PeepholeOptimization("pea", {Opcode::LEA, Opcode::PUSH}, peephole_pea),
+       PeepholeOptimization("self-load", {Opcode::LD}, peephole_self_load),
+       PeepholeOptimization("frameset-0", {Opcode::LD, Opcode::ADD, Opcode::LD},
+                            peephole_frameset_0),
+       PeepholeOptimization("frameunset-0", {Opcode::LEA, Opcode::LD}, peephole_frameunset_0),
+       PeepholeOptimization("lea-nop", {Opcode::LEA}, peephole_lea_nop),
+       PeepholeOptimization("sp-add-merge",
+                            {Opcode::LD, Opcode::ADD, Opcode::LD, Opcode::LD, Opcode::ADD,
+                             Opcode::LD},
+                            peephole_sp_add_merge),
+       PeepholeOptimization("push-discard", {Opcode::PUSH, Opcode::LD, Opcode::ADD, Opcode::LD},
+                            peephole_push_discard),
+       PeepholeOptimization("push-inc-discard",
+                            {Opcode::PUSH, Opcode::INC, Opcode::INC, Opcode::INC},
+                            peephole_push_discard),
       };
 
 }
@@ -0,0 +1,80 @@
+#include <cstring>
+#include <sys/resource.h>
+
+#include "pass-stats.hpp"
+#include "arena.hpp"
+#include "optim.hpp"
+
+namespace zc {
+
+   PassStats g_pass_stats;
+
+   namespace {
+
+      std::size_t arena_allocs() { return ast_arena().allocs() + ir_arena().allocs(); }
+      std::size_t arena_bytes() { return ast_arena().bytes() + ir_arena().bytes(); }
+      std::size_t arena_reserved() { return ast_arena().reserved() + ir_arena().reserved(); }
+
+      long peak_rss_kb() {
+         struct rusage usage;
+         return getrusage(RUSAGE_SELF, &usage) == 0 ? usage.ru_maxrss : 0;
+      }
+
+   }
+
+   PassStats::Timer::Timer(PassStats& stats, const char *name):
+      stats_(stats), name_(name), wall_(std::chrono::steady_clock::now()), cpu_(std::clock()),
+      allocs_(arena_allocs()), bytes_(arena_bytes()) {}
+
+   PassStats::Timer::~Timer() {
+      std::chrono::duration<double, std::milli> wall = std::chrono::steady_clock::now() - wall_;
+      double cpu = 1000.0 * (std::clock() - cpu_) / CLOCKS_PER_SEC;
+      stats_.passes_.push_back({name_, wall.count(), cpu, arena_allocs() - allocs_,
+                                arena_bytes() - bytes_, arena_reserved(), peak_rss_kb()});
+   }
+
+   void PassStats::Dump(std::ostream& os) const {
+      if (g_print.stats_json) {
+         DumpJSON(os);
+         return;
+      }
+
+      if (g_print.time_passes) {
+         double wall = 0, cpu = 0;
+         os << "time-passes:" << std::endl
+            << "PASS\t\tWALL(ms)\tCPU(ms)" << std::endl;
+         for (const Pass& pass : passes()) {
+            os << pass.name << "\t\t" << pass.wall_ms << "\t" << pass.cpu_ms << std::endl;
+            wall += pass.wall_ms;
+            cpu += pass.cpu_ms;
+         }
+         os << "total\t\t" << wall << "\t" << cpu << std::endl;
+      }
+
+      if (g_print.mem_stats) {
+         os << "mem-stats:" << std::endl
+            << "PASS\t\tALLOCS\tBYTES\tRESERVED\tPEAK-RSS(KB)" << std::endl;
+         for (const Pass& pass : passes()) {
+            os << pass.name << "\t\t" << pass.allocs << "\t" << pass.bytes << "\t"
+               << pass.reserved << "\t" << pass.peak_rss_kb << std::endl;
+         }
+      }
+   }
+
+   void PassStats::DumpJSON(std::ostream& os) const {
+      os << "{\"passes\": [";
+      for (auto it = passes().begin(); it != passes().end(); ++it) {
+         os << (it == passes().begin() ? "" : ", ") << "{\"name\": \"" << it->name << "\"";
+         if (g_print.time_passes) {
+            os << ", \"wall_ms\": " << it->wall_ms << ", \"cpu_ms\": " << it->cpu_ms;
+         }
+         if (g_print.mem_stats) {
+            os << ", \"allocs\": " << it->allocs << ", \"bytes\": " << it->bytes
+               << ", \"reserved\": " << it->reserved << ", \"peak_rss_kb\": " << it->peak_rss_kb;
+         }
+         os << "}";
+      }
+      os << "]}" << std::endl;
+   }
+
+}
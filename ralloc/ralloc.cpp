@@ -2,66 +2,29 @@
 #include <list>
 #include <unordered_map>
 #include <map>
+#include <set>
+#include <vector>
+#include <optional>
+#include <algorithm>
+#include <limits>
 
 #include "ralloc.hpp"
 #include "cgen.hpp"
 #include "optim.hpp"
+#include "emit.hpp"
+#include "alg/alg-live.hpp"
+#include "alg/alg-loop.hpp"
 
 namespace zc::z80 {
 
-   
-   bool before(Instructions::const_iterator lhs, Instructions::const_iterator rhs,
-               Instructions::const_iterator end) {
-      while (lhs != end && lhs != rhs) {
-         ++lhs;
-      }
-      
-      return lhs == rhs; /* NOTE: This also works if rhs == end. */
-   }
-
-
-   bool RallocInterval::in(const RallocInterval& other) const {
-      auto other_begin = other.begin;
-      while (other_begin != other.end && other_begin != begin) {
-         ++other_begin;
-      }
-      if (other_begin != begin) {
-         return false;
-      }
-
-      auto other_end = other.end;
-      while (other_end != other.begin && other_end != end) {
-         --other_end;
-      }
-      if (other_end != end) {
-         return false;
-      }
-      
-      return true;
-   }
 
    bool RallocInterval::intersects(const RallocInterval& other) const {
       if (in(other) || other.in(*this)) {
          return false;
       }
-      
-      auto begin_ = begin;
-      while (begin_ != end && begin_ != other.end) {
-         ++begin_;
-      }
-      if (begin_ == other.end) {
-         return true;
-      }
 
-      auto end_ = end;
-      while (end_ != begin && end_ != other.begin) {
-         --end_;
-      }
-      if (end_ == other.begin) {
-         return true;
-      }
-
-      return false;
+      return (begin <= other.end && other.end <= end) ||
+         (begin <= other.begin && other.begin <= end);
    }
 
    bool RallocInterval::operator<(const RallocInterval& other) const {
@@ -72,7 +35,7 @@ namespace zc::z80 {
    
       enum class mode {GEN, USE};
       template <typename Key>
-      using IntervalMap = std::map<Key, std::vector<std::pair<Instructions::iterator,mode>>>;
+      using IntervalMap = std::map<Key, std::vector<std::pair<int,mode>>>;
 
    void RegisterAllocator::ComputeIntervals() {
 
@@ -91,10 +54,13 @@ namespace zc::z80 {
       }
 
       /* iterate thru instructions */
+      std::vector<Instructions::iterator> pos; /* instruction index to iterator */
       int instr_index = 0;
-      for (auto instr_it = block()->instrs().begin();
-           instr_it != block()->instrs().end();
+      for (auto instr_it = instrs().begin();
+           instr_it != instrs().end();
            ++instr_it, ++instr_index, gens.clear(), uses.clear()) {
+         pos.push_back(instr_it);
+         
          /* get gens and uses in instrution */
          (*instr_it)->Kill(std::inserter(gens, gens.begin()));
          (*instr_it)->Gen(std::inserter(uses, uses.begin()));
@@ -119,7 +85,7 @@ namespace zc::z80 {
                      for (const ByteRegister *byte_reg : cur_regs) {
                         auto it = byte_regs.find(byte_reg);
                         if (it != byte_regs.end()) {
-                           it->second.push_back({instr_it, m});
+                           it->second.push_back({instr_index, m});
                            // it->second.insert({instr_it, m});
                         }
                      }
@@ -127,7 +93,7 @@ namespace zc::z80 {
 
                   /* add variable */
                   if (var) {
-                     vars[var].push_back({instr_it, m});
+                     vars[var].push_back({instr_index, m});
                   }
                }
             };
@@ -146,14 +112,14 @@ namespace zc::z80 {
          RallocInterval cur_int;
 
          /* loop invariant: end set */
-         cur_int.end = --block()->instrs().end();
+         cur_int.end = pos.size() - 1;
          do {
             /* Find 1st `use'. */
 #if 1
             for (; info_it != info_end && info_it->second != mode::USE; ++info_it) {
                assert(info_it->second == mode::GEN);
                cur_int.begin = info_it->first;
-               reg_free_ints.push_back(cur_int);
+               reg_free_ints.insert(cur_int);
                cur_int.end = info_it->first;
             }
 #else
@@ -163,17 +129,13 @@ namespace zc::z80 {
 #endif
             
             if (info_it == info_end) {
-               // cur_int.begin = 0;
-               cur_int.begin = block()->instrs().begin();
+               cur_int.begin = 0;
             } else {
-               // cur_int.begin = info_it->first;
-               auto tmp_it = info_it->first;
-               cur_int.begin = tmp_it;
+               cur_int.begin = info_it->first;
             }
 
-            if (before(cur_int.begin, cur_int.end, block()->instrs().end())) {
-               // if (cur_int.begin <= cur_int.end) {
-               reg_free_ints.push_back(cur_int);
+            if (cur_int.begin <= cur_int.end) {
+               reg_free_ints.insert(cur_int);
             }
 
             /* skip until `gen' */
@@ -181,7 +143,7 @@ namespace zc::z80 {
                ++info_it;
             }
             if (info_it != info_end) {
-               cur_int.end = (Instructions::iterator) info_it->first;
+               cur_int.end = info_it->first;
             }
          } while (info_it != info_end);
 
@@ -195,12 +157,12 @@ namespace zc::z80 {
          auto info_end = var_it.second.end();
          assert(info_it->second == mode::GEN);
 
-         VariableRallocInfo info(var_it.first, info_it->first);
+         VariableRallocInfo info(var_it.first, pos[info_it->first], info_it->first);
 
          /* add uses */
          ++info_it;
          while (info_it != info_end) {
-            info.uses.push_back(info_it->first);
+            info.uses.push_back(pos[info_it->first]);
             info.interval.end = info_it->first;
 
             ++info_it;
@@ -212,42 +174,263 @@ namespace zc::z80 {
       
    }
 
-   void RegisterAllocator::GetAssignableRegs(const VariableValue *var,
-                                             std::unordered_set<const Register *>& out) const {
+   void RegisterAllocator::ComputeGlobalIntervals(const FunctionImpl& impl) {
+      /* Interval slots: variables are keyed by ID (nonnegative); allocatable byte registers are
+       * keyed by -1 - <index into alloc_regs>. */
+      typedef std::set<int> Slots;
+      const std::vector<const ByteRegister *> alloc_regs = {&r_a, &r_b, &r_c, &r_d, &r_e,
+                                                            &r_h, &r_l};
+      auto reg_slot = [&](const ByteRegister *reg) -> std::optional<int> {
+                         auto it = std::find(alloc_regs.begin(), alloc_regs.end(), reg);
+                         if (it == alloc_regs.end()) { return std::nullopt; }
+                         return -1 - (it - alloc_regs.begin());
+                      };
+      auto to_slots = [&](const alg::ValueSet& vals, Slots& out) {
+                         for (const Value *val : vals) {
+                            auto var = dynamic_cast<const VariableValue *>(val);
+                            if (var) { out.insert(var->id()); }
+
+                            const Register *reg = val->reg();
+                            if (reg == nullptr) { continue; }
+                            std::list<const ByteRegister *> byte_regs;
+                            if (reg->kind() == Register::Kind::REG_MULTIBYTE) {
+                               auto arr = dynamic_cast<const MultibyteRegister *>(reg)->regs();
+                               byte_regs.insert(byte_regs.end(), arr.begin(), arr.end());
+                            } else {
+                               byte_regs = {dynamic_cast<const ByteRegister *>(reg)};
+                            }
+                            for (const ByteRegister *byte_reg : byte_regs) {
+                               auto slot = reg_slot(byte_reg);
+                               if (slot) { out.insert(*slot); }
+                            }
+                         }
+                      };
+
+      /* number instructions and compute their defs/uses */
+      std::vector<Instructions::iterator> pos;
+      std::vector<Slots> defs, uses;
+      std::unordered_map<int, const VariableValue *> id_vars;
+      for (auto it = instrs().begin(); it != instrs().end(); ++it) {
+         alg::ValueSet kills, gens;
+         (*it)->Kill(std::inserter(kills, kills.begin()));
+         (*it)->Gen(std::inserter(gens, gens.begin()));
+         for (const alg::ValueSet *vals : {&kills, &gens}) {
+            for (const Value *val : *vals) {
+               auto var = dynamic_cast<const VariableValue *>(val);
+               if (var) { id_vars.insert({var->id(), var}); }
+            }
+         }
+         
+         pos.push_back(it);
+         defs.emplace_back();
+         uses.emplace_back();
+         to_slots(kills, defs.back());
+         to_slots(gens, uses.back());
+      }
+      const int n = pos.size();
+      if (n == 0) { return; }
+
+      /* blocks of the serialized function begin at their labels */
+      std::unordered_map<std::string, const Block *> label_blocks;
+      Blocks visited;
+      auto add_block = [&](Block *block) { label_blocks[block->label()->name()] = block; };
+      impl.entry()->for_each_block(visited, add_block);
+      impl.fin()->for_each_block(visited, add_block);
+
+      std::vector<int> starts; /* start position of each block */
+      std::vector<const Block *> blocks;
+      std::unordered_map<const Block *, int> block_ids;
+      for (int i = 0; i < n; ++i) {
+         if ((*pos[i])->opcode() != Opcode::LABEL) { continue; }
+         auto label_instr = static_cast<const LabelInstruction *>(*pos[i]);
+         const Block *block = label_blocks.at(label_instr->label()->name());
+         block_ids[block] = blocks.size();
+         blocks.push_back(block);
+         starts.push_back(i);
+      }
+      assert(!starts.empty() && starts.front() == 0 && blocks.front() == impl.entry());
+      const int nblocks = starts.size();
+      auto block_end = [&](int b) { return b + 1 < nblocks ? starts[b + 1] : n; };
+
+      /* successors from block transitions, and loop depth of each position */
+      std::vector<std::vector<int>> succs(nblocks);
+      std::vector<int> depth(n);
+      const alg::Loops loops(impl);
+      for (int b = 0; b < nblocks; ++b) {
+         for (const BlockTransition *trans : blocks[b]->transitions().vec()) {
+            if (trans->dst()) { succs[b].push_back(block_ids.at(trans->dst())); }
+         }
+         std::fill(depth.begin() + starts[b], depth.begin() + block_end(b),
+                   loops.depth(blocks[b]));
+      }
+
+      /* liveness at block boundaries comes from the shared block-level analysis; positions
+       * within a block walk backwards from its live-out set */
+      const alg::Liveness live(impl);
+      std::vector<Slots> live_after(n);
+      for (int b = 0; b < nblocks; ++b) {
+         Slots out;
+         for (const auto& pair : id_vars) {
+            if (live.live_out(blocks[b], pair.second)) { out.insert(pair.first); }
+         }
+         for (const ByteRegister *reg : alloc_regs) {
+            const RegisterValue rv(reg);
+            if (live.live_out(blocks[b], &rv)) { out.insert(*reg_slot(reg)); }
+         }
+
+         for (int i = block_end(b) - 1; i >= starts[b]; --i) {
+            live_after[i] = out;
+            for (int slot : defs[i]) { out.erase(slot); }
+            out.insert(uses[i].begin(), uses[i].end());
+         }
+      }
+
+      /* registers are only live where a definition reaches: calls conservatively use the CRT
+       * argument registers, which would otherwise be live back to the function entry and around
+       * any loop containing a call. Registers read on entry before any call are arguments; a
+       * call defines only its result registers, clobbering the rest. */
+      Slots result_slots;
+      to_slots({&rv_a, &rv_hl}, result_slots);
+      Slots entry_defs;
+      {
+         Slots entry_kills;
+         for (int i = 0; i < block_end(0) && (*pos[i])->opcode() != Opcode::CALL; ++i) {
+            for (auto it = uses[i].begin(); it != uses[i].lower_bound(0); ++it) {
+               if (entry_kills.find(*it) == entry_kills.end()) { entry_defs.insert(*it); }
+            }
+            entry_kills.insert(defs[i].begin(), defs[i].end());
+         }
+      }
+      std::vector<std::vector<int>> preds(nblocks);
+      for (int b = 0; b < nblocks; ++b) {
+         for (int succ : succs[b]) { preds[succ].push_back(b); }
+      }
+      auto forward = [&](int b, const std::vector<Slots>& defined_out, bool filter) {
+                        Slots defined = b == 0 ? entry_defs : Slots();
+                        for (int pred : preds[b]) {
+                           defined.insert(defined_out[pred].begin(), defined_out[pred].end());
+                        }
+                        for (int i = starts[b]; i < block_end(b); ++i) {
+                           for (auto it = defs[i].begin(); it != defs[i].lower_bound(0); ++it) {
+                              if ((*pos[i])->opcode() != Opcode::CALL ||
+                                  result_slots.find(*it) != result_slots.end()) {
+                                 defined.insert(*it);
+                              }
+                           }
+                           if (!filter) { continue; }
+                           Slots& live = live_after[i];
+                           for (auto it = live.begin(); it != live.lower_bound(0); ) {
+                              it = defined.find(*it) == defined.end() ? live.erase(it) : ++it;
+                           }
+                        }
+                        return defined;
+                     };
+      std::vector<Slots> defined_out(nblocks);
+      for (bool changed = true; changed; ) {
+         changed = false;
+         for (int b = 0; b < nblocks; ++b) {
+            Slots defined = forward(b, defined_out, false);
+            if (defined != defined_out[b]) {
+               defined_out[b] = std::move(defined);
+               changed = true;
+            }
+         }
+      }
+      for (int b = 0; b < nblocks; ++b) {
+         forward(b, defined_out, true);
+      }
+
+      /* register free intervals: split where register is live or redefined */
+      for (const ByteRegister *reg : alloc_regs) {
+         int slot = *reg_slot(reg);
+         RallocIntervals reg_free_ints;
+         int begin = 0;
+         for (int i = 0; i < n; ++i) {
+            if (i > begin && defs[i].find(slot) != defs[i].end()) {
+               reg_free_ints.emplace(begin, i);
+               begin = i;
+            }
+            if (i < n - 1 && live_after[i].find(slot) != live_after[i].end()) {
+               if (begin < i) { reg_free_ints.emplace(begin, i); }
+               begin = i + 1;
+            }
+         }
+         if (begin < n - 1) { reg_free_ints.emplace(begin, n - 1); }
+         regs_.insert({reg, RegisterFreeIntervals(reg_free_ints)});
+      }
+
+      /* variable lifetimes: references, extended over positions where the variable is live */
+      std::map<int, std::vector<int>> events;
+      std::unordered_map<int, std::pair<int,int>> spans;
+      auto extend = [&](int id, int lo, int hi) {
+                       auto it = spans.find(id);
+                       if (it == spans.end()) {
+                          spans.insert({id, {lo, hi}});
+                       } else {
+                          it->second.first = std::min(it->second.first, lo);
+                          it->second.second = std::max(it->second.second, hi);
+                       }
+                    };
+      for (int i = 0; i < n; ++i) {
+         Slots refs = defs[i];
+         refs.insert(uses[i].begin(), uses[i].end());
+         for (auto it = refs.lower_bound(0); it != refs.end(); ++it) {
+            events[*it].push_back(i);
+            extend(*it, i, i);
+         }
+         for (auto it = live_after[i].lower_bound(0); it != live_after[i].end(); ++it) {
+            extend(*it, i, std::min(i + 1, n - 1));
+         }
+      }
+
+      for (const auto& pair : events) {
+         int id = pair.first;
+         const std::vector<int>& var_events = pair.second;
+         auto span = spans.at(id);
+         
+         VariableRallocInfo info(id_vars.at(id), pos[var_events.front()],
+                                 RallocInterval(span.first, span.second));
+         info.defs = 0;
+         for (int i : var_events) {
+            if (i != var_events.front()) { info.uses.push_back(pos[i]); }
+            if (defs[i].find(id) != defs[i].end()) { ++info.defs; }
+            info.loop_weight += depth[i];
+         }
+         auto start_it = std::upper_bound(starts.begin(), starts.end(), span.first);
+         info.crosses_blocks = start_it != starts.end() && *start_it <= span.second;
+
+         vars_.insert({id, info});
+      }
+   }
+
+   RegMask RegisterAllocator::GetAssignableRegs(const VariableValue *var) const {
       /* get variable lifetime */
       const VariableRallocInfo& varinfo = vars_.at(var->id());
       const RallocInterval& varint = varinfo.interval;
          
       /* look thru byte regs to find free */
-      std::unordered_set<const ByteRegister *> byte_regs_;
-      for (auto reg_it : regs_) {
+      RegMask free = 0;
+      for (const auto& reg_it : regs_) {
          auto super_it = reg_it.second.superinterval(varint);
          if (super_it != reg_it.second.intervals.end()) {
-            byte_regs_.insert(reg_it.first);
+            free |= reg_it.first->mask();
          }
       }
 
       /* if multibyte var, find register pairs in available byte regs */
       switch (var->size()) {
       case byte_size:
-         for (auto byte_reg : byte_regs_) {
-            out.insert(byte_reg);
-            // *out++ = byte_reg;
-         }
-         break;
+         return free;
             
+      case word_size: /* words live in the low 16 bits of a pair */
       case long_size:
-         for (const MultibyteRegister *multibyte_reg : {&r_bc, &r_de, &r_hl}) {
-            auto subregs = multibyte_reg->regs();
-            if (std::all_of(subregs.begin(), subregs.end(),
-                            [&](const ByteRegister *byte_reg) -> bool {
-                               return byte_regs_.find(byte_reg) != byte_regs_.end();
-                            })) {
-               out.insert(multibyte_reg);
-               // *out++ = multibyte_reg;
+         {
+            RegMask pairs = 0;
+            for (RegMask pair : {mask_bc, mask_de, mask_hl}) {
+               if ((pair & free) == pair) { pairs |= pair; }
             }
+            return pairs;
          }
-         break;
             
       default: abort();
       }
@@ -257,9 +440,14 @@ namespace zc::z80 {
       assert(var->requires_alloc());
 
       /* get candidate registers */
-      std::unordered_set<const Register *> candidate_regs;      
-      GetAssignableRegs(var, candidate_regs);
-      if (candidate_regs.empty()) { return false; }
+      RegMask candidate_regs = GetAssignableRegs(var);
+      if (candidate_regs == 0) { return false; }
+      const auto is_candidate = [&](const Register *reg) {
+                                   bool var_is_byte = (var->size() == byte_size);
+                                   bool reg_is_byte = (reg->kind() == Register::Kind::REG_BYTE);
+                                   return var_is_byte == reg_is_byte && reg->mask() != 0 &&
+                                      (reg->mask() & candidate_regs) == reg->mask();
+                                };
 
       /* determine nearby regs */
       VariableRallocInfo& var_info = vars_.at(var->id());
@@ -279,7 +467,7 @@ namespace zc::z80 {
 
       /* remove unfree regs */
       for (auto it = nearby_regs.begin(), end = nearby_regs.end(); it != end; ) {
-         if (candidate_regs.find(it->first) == candidate_regs.end()) {
+         if (!is_candidate(it->first)) {
             it = nearby_regs.erase(it);
          } else {
             ++it;
@@ -291,7 +479,12 @@ namespace zc::z80 {
       /* find ``nearest'' reg */
       if (nearby_regs.empty()) {
          /* IMPROVE -- might need to pick better */
-         reg = *candidate_regs.begin(); // NOTE: guaranteed at this point to be at least one.
+         /* NOTE: guaranteed at this point to be at least one. */
+         if (var->size() == byte_size) {
+            reg = byte_reg(static_cast<RegIndex>(__builtin_ctz(candidate_regs)));
+         } else {
+            reg = (candidate_regs & mask_bc) ? &r_bc : (candidate_regs & mask_de) ? &r_de : &r_hl;
+         }
       } else {
          reg = std::max_element(nearby_regs.begin(), nearby_regs.end(),
                                 [](const auto acc, const auto next) -> bool {
@@ -300,7 +493,7 @@ namespace zc::z80 {
       }
       
       /* allocate reg to var */
-      var_info.AssignVal(new RegisterValue(reg));
+      var_info.AssignVal(value_pool().Reg(reg));
       
       /* remove register free intervals */
       switch (reg->kind()) {
@@ -336,17 +529,18 @@ namespace zc::z80 {
          throw std::logic_error("could not allocate register to variable that requires register");
       }
 
-      /* check whether stack-spillable */
-      if (var_info.is_stack_spillable()) {
+      /* check whether stack-spillable, and no costlier than spilling to the frame */
+      if (var_info.is_stack_spillable() &&
+          var_info.stack_spill_cost() <= var_info.frame_spill_cost()) {
          /* try to stack-spill */
          if (stack_spills_.try_add(var_info.interval)) {
-            var_info.StackSpill(block()->instrs());
+            var_info.StackSpill(instrs());
             return AllocKind::ALLOC_STACK;
          }
       }
 
       /* otherwise, frame-spill */
-      var_info.FrameSpill(stack_frame_);
+      var_info.FrameSpill(stack_frame_, instrs());
 
       return var_info.alloc_kind;
    }
@@ -361,22 +555,58 @@ namespace zc::z80 {
       const LoadInstruction gen_instr(var, &iv);
       if (gen_instr.Match(*gen)) { return true; }
 
-      /* check if stored to memory value */
+      return false; // might need to check more things 
+   }
+
+   bool VariableRallocInfo::needs_scratch(Instructions::const_iterator it) const {
+      /* memory can't be loaded into memory */
       const Value *addr;
       const MemoryValue mv(&addr, var->size());
-      const LoadInstruction use_instr(&mv, var);
-      if (std::any_of(uses.begin(), uses.end(),
-                  [&](auto it) -> bool {
-                     return use_instr.Match(*it);
-                  })) {
+      if (LoadInstruction(var, &mv).Match(*it) || LoadInstruction(&mv, var).Match(*it)) {
          return true;
       }
-      
-      return false; // might need to check more things 
+
+      switch ((*it)->opcode()) {
+      case Opcode::LD:
+         return false;
+      case Opcode::LEA:
+         return true; /* lea only loads registers */
+      default:
+         /* besides loads, only byte operations take (ix+d) operands */
+         return var->size() != byte_size;
+      }
+   }
+
+   const RegisterValue *VariableRallocInfo::scratch(Instructions::const_iterator it) const {
+      /* a for bytes, whose addresses are always pairs; iy for loads, which no variable is
+       * allocated to; otherwise de or bc, whichever the instruction leaves alone */
+      if (var->size() == byte_size) { return &rv_a; }
+      switch ((*it)->opcode()) {
+      case Opcode::LD:
+      case Opcode::LEA:
+         return &rv_iy;
+      default:
+         break;
+      }
+
+      alg::ValueSet vals;
+      (*it)->Gen(std::inserter(vals, vals.begin()));
+      (*it)->Kill(std::inserter(vals, vals.begin()));
+      const bool uses_de = std::any_of(vals.begin(), vals.end(), [](const Value *val) {
+         const Register *reg = val->reg();
+         return reg && (reg->mask() & r_de.mask());
+      });
+      return uses_de ? &rv_bc : &rv_de;
+   }
+
+   bool VariableRallocInfo::through_memory() const {
+      return needs_scratch(gen) ||
+         std::any_of(uses.begin(), uses.end(), [&](auto it) { return needs_scratch(it); });
    }
 
    bool VariableRallocInfo::is_stack_spillable() const {
       if (var->size() == byte_size) { return false; } /* must be word/long to be spilled */
+      if (crosses_blocks) { return false; } /* pushes/pops must balance on every path */
 
       /* verify that gen instruction can be translated into `push' */
       const Register *reg_ptr;
@@ -398,6 +628,44 @@ namespace zc::z80 {
       return true;
    }
 
+   namespace {
+
+      int cost_weight(const Instruction& instr) {
+         Cost cost = instr.cost();
+         return cost.bytes + cost.cycles;
+      }
+
+   }
+
+   int VariableRallocInfo::stack_spill_cost() const {
+      /* push <src> at definition; pop <dst> at each use, pushing again for later uses */
+      int cost = cost_weight(PushInstruction((*gen)->src()));
+      int i = uses.size();
+      for (Instructions::iterator use : uses) {
+         cost += cost_weight(PopInstruction((*use)->dst()));
+         if (--i > 0) { cost += cost_weight(PushInstruction((*use)->dst())); }
+      }
+      return cost;
+   }
+
+   int VariableRallocInfo::frame_spill_cost() const {
+      /* ld (ix+d),<src> at definition; ld <dst>,(ix+d) at each use; transfers through memory
+       * also save and restore the scratch register (@see FrameSpill()) */
+      const IndexedRegisterValue addr(&rv_ix, int8_t(0));
+      const MemoryValue slot(&addr, var->size());
+      const auto shuttle_cost = [&](Instructions::iterator it) {
+         const RegisterValue *saved = var->size() == byte_size ? &rv_af : scratch(it);
+         return cost_weight(PushInstruction(saved)) + cost_weight(PopInstruction(saved));
+      };
+      int cost = cost_weight(LoadInstruction(&slot, (*gen)->src()));
+      if (needs_scratch(gen)) { cost += shuttle_cost(gen); }
+      for (Instructions::iterator use : uses) {
+         cost += cost_weight(LoadInstruction((*use)->dst(), &slot));
+         if (needs_scratch(use)) { cost += shuttle_cost(use); }
+      }
+      return cost;
+   }
+
    void VariableRallocInfo::StackSpill(Instructions& instrs) {
       *gen = new PushInstruction((*gen)->src());
       int i = uses.size();
@@ -413,8 +681,37 @@ namespace zc::z80 {
       alloc_kind = AllocKind::ALLOC_STACK;
    }
 
-   void VariableRallocInfo::FrameSpill(StackFrame& frame) {
+   void VariableRallocInfo::FrameSpill(StackFrame& frame, Instructions& instrs) {
       auto frame_val = frame.next_tmp(var);
+
+      /* instructions that can't address the frame slot get the value through a scratch register
+       * (@see scratch()), saved around the transfer */
+      auto shuttle = [&](Instructions::iterator it) {
+                        const RegisterValue *scratch = this->scratch(it);
+                        const RegisterValue *saved = scratch == &rv_a ? &rv_af : scratch;
+                        alg::ValueSet reads, writes;
+                        (*it)->Gen(std::inserter(reads, reads.begin()));
+                        (*it)->Kill(std::inserter(writes, writes.begin()));
+                        const auto refs = [&](const alg::ValueSet& vals) {
+                           return std::any_of(vals.begin(), vals.end(),
+                                              [&](const Value *val) { return val->Eq(var); });
+                        };
+                        instrs.insert(it, new PushInstruction(saved));
+                        if (refs(reads)) {
+                           instrs.insert(it, new LoadInstruction(scratch, frame_val));
+                        }
+                        (*it)->ReplaceVar(var, scratch);
+                        auto next = std::next(it);
+                        if (refs(writes)) {
+                           instrs.insert(next, new LoadInstruction(frame_val, scratch));
+                        }
+                        instrs.insert(next, new PopInstruction(saved));
+                     };
+      if (needs_scratch(gen)) { shuttle(gen); }
+      for (auto use : uses) {
+         if (needs_scratch(use)) { shuttle(use); }
+      }
+
       AssignVal(frame_val);
       alloc_kind = AllocKind::ALLOC_FRAME;
    }
@@ -438,30 +735,37 @@ namespace zc::z80 {
             prioritized_vars.push_back(it);
          }
       }
+      /* variables that can't be spilled at all go first */
       std::sort(prioritized_vars.begin(), prioritized_vars.end(),
-                [](auto a, auto b) { return a->second.priority() > b->second.priority(); });
+                [](auto a, auto b) {
+                   if (a->second.requires_reg() != b->second.requires_reg()) {
+                      return a->second.requires_reg();
+                   }
+                   return a->second.priority() > b->second.priority();
+                });
       
       for (auto it : prioritized_vars) {
          AllocateVar(it->second.var);
       }
    }
 
-   RallocIntervals::iterator RegisterFreeIntervals::superinterval(const RallocInterval& interval) {
-      auto it = intervals.begin(), end = intervals.end();      
-      for (; it != end; ++it) {
-         if (interval.in(*it)) {
-            break;
-         }
-      }
-      return it;
+   RallocIntervals::const_iterator
+   RegisterFreeIntervals::superinterval(const RallocInterval& interval) const {
+      /* last interval beginning at or before _interval_ has the greatest end of those */
+      auto it = intervals.upper_bound(RallocInterval(interval.begin,
+                                                     std::numeric_limits<int>::max()));
+      if (it == intervals.begin()) { return intervals.end(); }
+      --it;
+      return interval.in(*it) ? it : intervals.end();
    }
 
    void RegisterFreeIntervals::remove_interval(const RallocInterval& interval) {
       auto it = superinterval(interval);
       if (it == intervals.end()) { throw std::logic_error("asked to remove interval not present"); }
-      intervals.emplace_back(it->begin, interval.begin);
-      intervals.emplace_back(interval.end, it->end);
+      RallocInterval super = *it;
       intervals.erase(it);
+      intervals.emplace(super.begin, interval.begin);
+      intervals.emplace(interval.end, super.end);
    }
 
    void VariableRallocInfo::AssignVal(const Value *newval) {
@@ -475,22 +779,21 @@ namespace zc::z80 {
 
 
    /*** DUMPS ***/
-   void RegisterFreeIntervals::Dump(std::ostream& os, Instructions::iterator instrs_begin)
-      const {
+   void RegisterFreeIntervals::Dump(std::ostream& os) const {
       for (const RallocInterval& interval : intervals) {
-         interval.Dump(os, instrs_begin);
+         interval.Dump(os);
          os << ","; 
       }
       os << std::endl;
    }
 
-   void VariableRallocInfo::Dump(std::ostream& os, Instructions::iterator instrs_begin) const {
+   void VariableRallocInfo::Dump(std::ostream& os) const {
       var->Emit(os);
       os << " " << alloc_kind;
       if (allocated_val) { os << " "; allocated_val->Emit(os); }
       os << std::endl;
       os << "\tinterval:\t";
-      interval.Dump(os, instrs_begin);
+      interval.Dump(os);
       os << std::endl;
       os << "\tgen:\t";
       (*gen)->Emit(os); 
@@ -505,20 +808,43 @@ namespace zc::z80 {
          it.first->Dump(os);
          os << ": ";
          for (auto interval : it.second.intervals) {
-            interval.Dump(os, block()->instrs().begin());
+            interval.Dump(os);
             os << " ";
          }
          os << std::endl;
       }
 
       for (auto it : vars_) {
-         it.second.Dump(os, block()->instrs().begin());
+         it.second.Dump(os);
+      }
+   }
+
+   void RegisterAllocator::DumpStats(std::ostream& os) const {
+      /* Per-access estimates of an `(ix+d)' operand over a register operand: one extra
+       * displacement byte plus prefix, and the extra memory cycles. */
+      const int frame_access_bytes = 2;
+      const int frame_access_cycles = 3;
+      
+      int cross_vars = 0, cross_regs = 0, accesses = 0;
+      for (const auto& pair : vars_) {
+         const VariableRallocInfo& info = pair.second;
+         if (!info.crosses_blocks) { continue; }
+         ++cross_vars;
+         if (info.alloc_kind == AllocKind::ALLOC_REG) {
+            ++cross_regs;
+            accesses += info.uses.size() + 1;
+         }
       }
+
+      os << "function-ralloc: " << cross_regs << "/" << cross_vars
+         << " cross-block variables in registers, " << accesses << " frame accesses avoided"
+         << " (est. -" << accesses * frame_access_bytes << " bytes, -"
+         << accesses * frame_access_cycles << " cycles)" << std::endl;
    }
 
    /*** ***/
    void RegisterAllocator::RallocBlock(Block *block, StackFrame& stack_frame) {
-      RegisterAllocator ralloc(block, stack_frame);
+      RegisterAllocator ralloc(block->instrs(), stack_frame);
       ralloc.ComputeIntervals();
 
       if (g_optim.join_vars) {
@@ -537,33 +863,112 @@ namespace zc::z80 {
       }
    }
 
+   void RegisterAllocator::RallocFunction(FunctionImpl& impl, StackFrame& stack_frame) {
+      impl.Serialize();
+      
+      RegisterAllocator ralloc(impl.instrs(), stack_frame);
+      ralloc.ComputeGlobalIntervals(impl);
+
+      if (g_optim.join_vars) {
+         ralloc.JoinVars();
+      }
+
+      if (g_print.ralloc_info) {
+         std::cerr << impl.entry()->label()->name() << ":" << std::endl;
+         ralloc.Dump(std::cerr);
+      }
+
+      ralloc.RunAllocation();
+
+      if (g_print.ralloc_info) {
+         ralloc.Dump(std::cerr);
+         ralloc.DumpStats(std::cerr);
+      }
+
+      impl.Deserialize();
+   }
+
    void RegisterAllocator::Ralloc(FunctionImpl& impl, StackFrame& frame) {
-      Blocks visited;
-      void (*fn)(Block *, StackFrame&) = RegisterAllocator::RallocBlock;
-      impl.entry()->for_each_block(visited, fn, frame);
-      impl.fin()->for_each_block(visited, fn, frame);
+      if (g_optim.function_ralloc) {
+         RallocFunction(impl, frame);
+      } else {
+         Blocks visited;
+         void (*fn)(Block *, StackFrame&) = RegisterAllocator::RallocBlock;
+         impl.entry()->for_each_block(visited, fn, frame);
+         impl.fin()->for_each_block(visited, fn, frame);
+      }
+
+      emit_spillset(frame, impl.entry(), impl.fin());
    }
 
    void RegisterAllocator::Ralloc(CgenEnv& env) {
       for (FunctionImpl& impl : env.impls().impls()) {
-         Ralloc(impl, env.ext_env().frame());
+         Ralloc(impl, impl.stack_frame());
       }
    }
 
    /*** ***/
    bool NestedRallocIntervals::try_add(const RallocInterval& interval) {
-      for (auto nested_interval : intervals_) {
-         if (interval.intersects(nested_interval) && !interval.in(nested_interval) &&
-             nested_interval.in(interval)) {
-            /* overlaps */
+      /* an endpoint is a push or pop that can't be shared with another spill */
+      if (endpoints_.find(interval.begin) != endpoints_.end() ||
+          endpoints_.find(interval.end) != endpoints_.end()) {
+         return false;
+      }
+
+      /* endpoints strictly inside must form a balanced parenthesis sequence */
+      Reserve(interval.end);
+      if (interval.begin + 1 <= interval.end - 1) {
+         Node inner = Query(1, 0, capacity_ - 1, interval.begin + 1, interval.end - 1);
+         if (inner.sum != 0 || inner.min_prefix < 0) {
             return false;
          }
       }
-      
-      intervals_.push_back(interval);
+
+      endpoints_.insert(interval.begin);
+      endpoints_.insert(interval.end);
+      Add(interval.begin, 1);
+      Add(interval.end, -1);
       return true;
    }
 
+   NestedRallocIntervals::Node NestedRallocIntervals::Combine(const Node& lhs, const Node& rhs) {
+      return {lhs.sum + rhs.sum, std::min(lhs.min_prefix, lhs.sum + rhs.min_prefix)};
+   }
+
+   void NestedRallocIntervals::Reserve(int index) {
+      if (index < capacity_) { return; }
+
+      int capacity = std::max(capacity_, 1);
+      while (capacity <= index) { capacity *= 2; }
+      std::vector<Node> tree(2 * capacity);
+      for (int i = 0; i < capacity_; ++i) {
+         tree[capacity + i] = tree_[capacity_ + i];
+      }
+      for (int i = capacity - 1; i > 0; --i) {
+         tree[i] = Combine(tree[2 * i], tree[2 * i + 1]);
+      }
+      capacity_ = capacity;
+      tree_ = std::move(tree);
+   }
+
+   void NestedRallocIntervals::Add(int index, int delta) {
+      int i = capacity_ + index;
+      tree_[i].sum += delta;
+      tree_[i].min_prefix = std::min(0, tree_[i].sum);
+      for (i /= 2; i > 0; i /= 2) {
+         tree_[i] = Combine(tree_[2 * i], tree_[2 * i + 1]);
+      }
+   }
+
+   NestedRallocIntervals::Node NestedRallocIntervals::Query(int node, int node_lo, int node_hi,
+                                                             int lo, int hi) const {
+      if (hi < node_lo || node_hi < lo) { return Node(); }
+      if (lo <= node_lo && node_hi <= hi) { return tree_[node]; }
+      int mid = (node_lo + node_hi) / 2;
+      return Combine(Query(2 * node, node_lo, mid, lo, hi),
+                     Query(2 * node + 1, mid + 1, node_hi, lo, hi));
+   }
+
    const VariableValue *VariableRallocInfo::joinable() {
       /* Requirements for joining:
        *  - Variable must have exactly one use. 
@@ -586,19 +991,27 @@ namespace zc::z80 {
    }
 
    void RegisterAllocator::JoinVars() {
-      for (auto pair : vars_) {
-         auto var_info = pair.second;
+      for (auto& pair : vars_) {
+         auto& var_info = pair.second;
          auto second_var = var_info.joinable();
-         if (second_var) {
-            JoinVar(var_info.var, second_var);
+         if (second_var == nullptr) { continue; }
+
+         /* variables assigned more than once or live across blocks keep their own identity */
+         const auto& second_info = vars_.at(second_var->id());
+         if (var_info.defs > 1 || second_info.defs > 1 || second_info.crosses_blocks ||
+             var_info.interval.end != second_info.interval.begin ||
+             var_info.requires_reg() != second_info.requires_reg()) {
+            continue;
          }
+         
+         JoinVar(var_info.var, second_var);
       }
    }
 
    void RegisterAllocator::JoinVar(const VariableValue *first, const VariableValue *second) {
       /* find associated infos */
-      auto first_info = vars_.at(first->id());
-      auto second_info = vars_.at(second->id());
+      auto& first_info = vars_.at(first->id());
+      auto& second_info = vars_.at(second->id());
 
       /* Join variables:
        *  - Merge lifetime intervals into one
@@ -622,7 +1035,7 @@ namespace zc::z80 {
       }
 
       /* delete _second_ variable's `gen` instruction */
-      block_->instrs().erase(second_info.gen);
+      instrs_.erase(second_info.gen);
 
       /* unmap variable from `vars_` */
       vars_.erase(second->id());
@@ -170,6 +170,11 @@
        /* type check type */
        type()->TypeCheck(env, false);
 
+       if (is_static() && dynamic_cast<FunctionType *>(type()) == nullptr) {
+          env.error()(g_filename, this) << "static storage class is only supported for functions"
+                                        << std::endl;
+       }
+
        /* add symbol to scope */
        env.symtab().AddToScope(sym(), this);
     }
@@ -374,6 +379,76 @@
        }
     }
 
+    void SwitchStat::TypeCheck(SemantEnv& env) {
+       expr()->TypeCheck(env);
+       const ASTType *type = expr()->type();
+       if (type->kind() == ASTType::Kind::TYPE_POINTER || type->int_type() == nullptr) {
+          env.error()(g_filename, this) << "switch statement requires expression of integral type"
+                                        << std::endl;
+       } else if (type->bytes() == z80::flag_size) {
+          expr_ = expr()->Cast(int_type<IntegralType::IntKind::SPEC_INT, true>);
+       }
+
+       case_vals_.clear();
+       has_default_ = false;
+
+       env.stat_stack().Push(this);
+       body()->TypeCheck(env);
+       env.stat_stack().Pop();
+    }
+
+    void SwitchStat::AddCase(SemantEnv& env, const CaseStat *stat) {
+       std::optional<intmax_t> val = case_value(stat->val()->int_const());
+       if (val && !case_vals_.insert(*val).second) {
+          env.error()(g_filename, stat) << "duplicate case value '" << *val << "'" << std::endl;
+       }
+    }
+
+    void SwitchStat::AddDefault(SemantEnv& env, const DefaultStat *stat) {
+       if (has_default_) {
+          env.error()(g_filename, stat) << "multiple default labels in one switch" << std::endl;
+       }
+       has_default_ = true;
+    }
+
+    /**
+     * Find innermost switch statement enclosing case label.
+     */
+    static SwitchStat *enclosing_switch(SemantEnv& env) {
+       return dynamic_cast<SwitchStat *>
+          (env.stat_stack().Find([](auto stat) {
+                                    return dynamic_cast<SwitchStat *>(stat) != nullptr;
+                                 }));
+    }
+
+    void CaseStat::TypeCheck(SemantEnv& env) {
+       val()->TypeCheck(env);
+       SwitchStat *switch_stat = enclosing_switch(env);
+       if (switch_stat == nullptr) {
+          env.error()(g_filename, this) << "'case' statement not in switch statement"
+                                        << std::endl;
+       } else if (val()->type()->kind() == ASTType::Kind::TYPE_POINTER ||
+                  val()->type()->int_type() == nullptr) {
+          env.error()(g_filename, this) << "case label has non-integral type" << std::endl;
+       } else if (!val()->is_const()) {
+          env.error()(g_filename, this) << "case label is not constant" << std::endl;
+       } else {
+          switch_stat->AddCase(env, this);
+       }
+       LabeledStat::TypeCheck(env);
+    }
+
+    void DefaultStat::TypeCheck(SemantEnv& env) {
+       SwitchStat *switch_stat = enclosing_switch(env);
+       if (switch_stat == nullptr) {
+          env.error()(g_filename, this) << "'default' statement not in switch statement"
+                                        << std::endl;
+       } else {
+          switch_stat->AddDefault(env, this);
+       }
+       LabeledStat::TypeCheck(env);
+    }
+
     void WhileStat::TypeCheck(SemantEnv& env) {
        env.stat_stack().Push(this);
        pred()->TypeCheck(env);
@@ -446,6 +521,10 @@
    }
 
     void CallExpr::TypeCheck(SemantEnv& env) {
+       auto fn_id = dynamic_cast<IdentifierExpr *>(fn());
+       if (fn_id) {
+          fn_id->set_callee();
+       }
        fn()->TypeCheck(env);
        for (ASTExpr *param : *params()) {
           param->TypeCheck(env);
@@ -523,11 +602,22 @@
        type_ = IntegralType::Create(IntegralType::IntKind::SPEC_LONG_LONG, false, loc());
     }
 
+    /**
+     * Record that the address of a variable is required, so it must live in the stack frame.
+     */
+    static void mark_addr_taken(ASTExpr *expr) {
+       auto id_expr = dynamic_cast<IdentifierExpr *>(expr);
+       if (id_expr && id_expr->decl()) {
+          id_expr->decl()->set_addr_taken();
+       }
+    }
+
     void IndexExpr::TypeCheck(SemantEnv& env) {
        using IntKind = IntegralType::IntKind;
        
        base()->TypeCheck(env);
        index()->TypeCheck(env);
+       mark_addr_taken(base());
        if (index()->type()->kind() != ASTType::Kind::TYPE_INTEGRAL) {
           env.error()(g_filename, this) << "cannot index type with a non-integral value"
                                         << std::endl;
@@ -552,6 +642,7 @@
                                           << std::endl;
          }
          type_ = type->Address();
+         mark_addr_taken(expr());
          break;
          
       case Kind::UOP_DEREFERENCE:
@@ -706,16 +797,22 @@
    }
 
    void IdentifierExpr::TypeCheck(SemantEnv& env) {
-      const Declaration *decl;
+      Declaration *decl;
       if ((decl = env.symtab().Lookup(id()->id())) == nullptr) {
          env.error()(g_filename, this) << "use of undeclared identifier '" << *id()->id()
                                        << "'" << std::endl;
          type_ = default_type;
       } else {
-         auto var = dynamic_cast<const VarDeclaration *>(decl);
+         auto var = dynamic_cast<VarDeclaration *>(decl);
          if (var) {
             type_ = var->type();//->Decay();
             is_const_ = var->is_const();
+            decl_ = var;
+
+            /* a function named other than in a call is used through its address */
+            if (type_->kind() == ASTType::Kind::TYPE_FUNCTION && !is_callee_) {
+               var->set_addr_taken();
+            }
          } else {
             env.error()(g_filename, this) << "identifier '" << *id()->id()
                                           << "' is incorrect kind of symbol"
@@ -1004,6 +1101,10 @@
      void FunctionDef::Enscope(SemantEnv& env) const {
         /* enscope function symbol */
         ExternalDecl::Enscope(env);
+        auto var_decl = dynamic_cast<VarDeclaration *>(decl());
+        if (var_decl) {
+           var_decl->set_defined();
+        }
 
         /* add new scope */
         env.EnterScope();
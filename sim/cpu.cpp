@@ -0,0 +1,867 @@
+/* eZ80 interpreter */
+
+#include <algorithm>
+#include <cstdio>
+#include <utility>
+
+#include "sim.hpp"
+
+namespace zc::sim {
+
+   namespace {
+
+      /* the runtime library lives in ROM; nothing else there is simulated */
+      constexpr uint32_t rom_end = 0x400000;
+
+      bool parity(uint8_t val) { return !(__builtin_popcount(val) & 1); }
+      uint8_t sz(uint8_t val) { return (val & FLAG_S) | (val ? 0 : FLAG_Z); }
+      uint8_t szp(uint8_t val) { return sz(val) | (parity(val) ? FLAG_PV : 0); }
+      uint32_t sext8(uint8_t val) { return static_cast<uint32_t>(static_cast<int8_t>(val)); }
+
+      void set_byte(uint32_t& pair, int shift, uint8_t val) {
+         pair = (pair & ~(0xffu << shift)) | (static_cast<uint32_t>(val) << shift);
+      }
+
+      std::string hex(uint32_t val) {
+         char buf[16];
+         std::snprintf(buf, sizeof(buf), "%06x", val);
+         return buf;
+      }
+
+   }
+
+   /*** MEMORY ***/
+
+   uint32_t Memory::read24(uint32_t addr) const {
+      return read8(addr) | (read8(addr + 1) << 8) | (read8(addr + 2) << 16);
+   }
+
+   void Memory::write24(uint32_t addr, uint32_t val) {
+      write8(addr, val);
+      write8(addr + 1, val >> 8);
+      write8(addr + 2, val >> 16);
+   }
+
+   bool Memory::Load(uint32_t addr, const std::vector<uint8_t>& image) {
+      if (addr + image.size() > bytes_.size()) { return false; }
+      std::copy(image.begin(), image.end(), bytes_.begin() + addr);
+      return true;
+   }
+
+   uint32_t Memory::crc32(uint32_t addr, uint32_t size) const {
+      uint32_t crc = 0xffffffff;
+      for (uint32_t i = 0; i < size; ++i) {
+         crc ^= read8(addr + i);
+         for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc >> 1) ^ (0xedb88320 & -(crc & 1));
+         }
+      }
+      return ~crc;
+   }
+
+
+   /*** EXECUTION ***/
+
+   void Cpu::Call(uint32_t entry, uint32_t sp) {
+      regs_.sp = (sp - 3) & addr_mask;
+      mem_.write24(regs_.sp, return_sentinel);
+      regs_.pc = entry & addr_mask;
+      status_ = Status::RUNNING;
+   }
+
+   Cpu::Status Cpu::Run(uint64_t max_cycles) {
+      while (status_ == Status::RUNNING) {
+         if (cycles_ >= max_cycles) {
+            status_ = Status::TIMEOUT;
+            break;
+         }
+         Step();
+      }
+      return status_;
+   }
+
+   void Cpu::Fault(const std::string& msg) {
+      status_ = Status::FAULT;
+      fault_ = msg;
+   }
+
+   void Cpu::Step() {
+      if (regs_.pc == return_sentinel) {
+         status_ = Status::RETURNED;
+         return;
+      }
+
+      if (regs_.pc < rom_end) {
+         const Routine *routine = runtime_routine(regs_.pc);
+         if (routine == nullptr) {
+            Fault("jump to unsimulated ROM address " + hex(regs_.pc));
+            return;
+         }
+         ++runtime_calls_;
+         cycles_ += routine->run(*this);
+         return;
+      }
+
+      const uint32_t pc = regs_.pc;
+      ++instrs_;
+      regs_.r = (regs_.r & 0x80) | ((regs_.r + 1) & 0x7f);
+      index_ = &regs_.hl;
+      ExecMain(fetch8());
+      if (status_ == Status::FAULT) { fault_ += " at " + hex(pc); }
+   }
+
+   void Cpu::Return() {
+      /* ret: fetch, 3 reads, 2 internal */
+      regs_.pc = pop24();
+      cycles_ += 3;
+   }
+
+   void Cpu::Jump(uint32_t target) {
+      regs_.pc = target & addr_mask;
+      ++cycles_; /* pipeline refill */
+   }
+
+
+   /*** MEMORY ACCESS ***/
+
+   uint8_t Cpu::fetch8() {
+      uint8_t val = mem_.read8(regs_.pc);
+      regs_.pc = (regs_.pc + 1) & addr_mask;
+      ++cycles_;
+      return val;
+   }
+
+   uint32_t Cpu::fetch24() {
+      uint32_t val = fetch8();
+      val |= fetch8() << 8;
+      val |= fetch8() << 16;
+      return val;
+   }
+
+   uint8_t Cpu::read8(uint32_t addr) {
+      ++cycles_;
+      return mem_.read8(addr);
+   }
+
+   void Cpu::write8(uint32_t addr, uint8_t val) {
+      ++cycles_;
+      mem_.write8(addr, val);
+   }
+
+   uint32_t Cpu::read24(uint32_t addr) {
+      cycles_ += 3;
+      return mem_.read24(addr);
+   }
+
+   void Cpu::write24(uint32_t addr, uint32_t val) {
+      cycles_ += 3;
+      mem_.write24(addr, val);
+   }
+
+   void Cpu::push24(uint32_t val) {
+      regs_.sp = (regs_.sp - 3) & addr_mask;
+      write24(regs_.sp, val);
+   }
+
+   uint32_t Cpu::pop24() {
+      uint32_t val = read24(regs_.sp);
+      regs_.sp = (regs_.sp + 3) & addr_mask;
+      return val;
+   }
+
+
+   /*** OPERANDS ***/
+
+   uint8_t Cpu::reg8(int r, bool indexed) const {
+      const uint32_t hl = indexed ? *index_ : regs_.hl;
+      switch (r) {
+      case 0: return regs_.bc >> 8;
+      case 1: return regs_.bc;
+      case 2: return regs_.de >> 8;
+      case 3: return regs_.de;
+      case 4: return hl >> 8;
+      case 5: return hl;
+      default: return regs_.a;
+      }
+   }
+
+   void Cpu::set_reg8(int r, uint8_t val, bool indexed) {
+      uint32_t& hl = indexed ? *index_ : regs_.hl;
+      switch (r) {
+      case 0: set_byte(regs_.bc, 8, val); break;
+      case 1: set_byte(regs_.bc, 0, val); break;
+      case 2: set_byte(regs_.de, 8, val); break;
+      case 3: set_byte(regs_.de, 0, val); break;
+      case 4: set_byte(hl, 8, val); break;
+      case 5: set_byte(hl, 0, val); break;
+      default: regs_.a = val; break;
+      }
+   }
+
+   uint32_t& Cpu::rp(int p) {
+      switch (p) {
+      case 0: return regs_.bc;
+      case 1: return regs_.de;
+      case 2: return *index_;
+      default: return regs_.sp;
+      }
+   }
+
+   uint32_t Cpu::disp_addr(uint32_t base) {
+      return (base + sext8(fetch8())) & addr_mask;
+   }
+
+   uint32_t Cpu::rel_target() {
+      uint32_t disp = sext8(fetch8());
+      return (regs_.pc + disp) & addr_mask;
+   }
+
+   uint32_t Cpu::mem_addr() {
+      return index_ == &regs_.hl ? regs_.hl : disp_addr(*index_);
+   }
+
+   bool Cpu::cond(int cc) const {
+      static const uint8_t masks[] = {FLAG_Z, FLAG_C, FLAG_PV, FLAG_S};
+      bool set = regs_.f & masks[cc >> 1];
+      return (cc & 1) ? set : !set;
+   }
+
+
+   /*** ARITHMETIC ***/
+
+   void Cpu::alu(int op, uint8_t val) {
+      const uint8_t a = regs_.a;
+      switch (op) {
+      case 0: /* add */
+      case 1: /* adc */
+         {
+            unsigned res = a + val + (op == 1 && (regs_.f & FLAG_C));
+            regs_.f = sz(res) | ((a ^ val ^ res) & FLAG_H) |
+               ((~(a ^ val) & (a ^ res) & 0x80) ? FLAG_PV : 0) | (res > 0xff ? FLAG_C : 0);
+            regs_.a = res;
+         }
+         break;
+
+      case 2: /* sub */
+      case 3: /* sbc */
+      case 7: /* cp */
+         {
+            unsigned res = a - val - (op == 3 && (regs_.f & FLAG_C));
+            regs_.f = sz(res) | ((a ^ val ^ res) & FLAG_H) |
+               (((a ^ val) & (a ^ res) & 0x80) ? FLAG_PV : 0) | FLAG_N |
+               (res > 0xff ? FLAG_C : 0);
+            if (op != 7) { regs_.a = res; }
+         }
+         break;
+
+      case 4: /* and */
+         regs_.a &= val;
+         regs_.f = szp(regs_.a) | FLAG_H;
+         break;
+
+      case 5: /* xor */
+         regs_.a ^= val;
+         regs_.f = szp(regs_.a);
+         break;
+
+      case 6: /* or */
+         regs_.a |= val;
+         regs_.f = szp(regs_.a);
+         break;
+      }
+   }
+
+   uint8_t Cpu::inc8(uint8_t val) {
+      uint8_t res = val + 1;
+      regs_.f = (regs_.f & FLAG_C) | sz(res) | ((val & 0xf) == 0xf ? FLAG_H : 0) |
+         (val == 0x7f ? FLAG_PV : 0);
+      return res;
+   }
+
+   uint8_t Cpu::dec8(uint8_t val) {
+      uint8_t res = val - 1;
+      regs_.f = (regs_.f & FLAG_C) | sz(res) | ((val & 0xf) == 0 ? FLAG_H : 0) |
+         (val == 0x80 ? FLAG_PV : 0) | FLAG_N;
+      return res;
+   }
+
+   uint8_t Cpu::rot(int op, uint8_t val) {
+      const bool carry_in = regs_.f & FLAG_C;
+      bool carry;
+      uint8_t res;
+      switch (op) {
+      case 0: carry = val & 0x80; res = (val << 1) | carry;          break; /* rlc */
+      case 1: carry = val & 1;    res = (val >> 1) | (carry << 7);   break; /* rrc */
+      case 2: carry = val & 0x80; res = (val << 1) | carry_in;       break; /* rl */
+      case 3: carry = val & 1;    res = (val >> 1) | (carry_in << 7); break; /* rr */
+      case 4: carry = val & 0x80; res = val << 1;                    break; /* sla */
+      case 5: carry = val & 1;    res = (val >> 1) | (val & 0x80);   break; /* sra */
+      case 7: carry = val & 1;    res = val >> 1;                    break; /* srl */
+      default:
+         Fault("invalid shift opcode");
+         return val;
+      }
+      regs_.f = szp(res) | (carry ? FLAG_C : 0);
+      return res;
+   }
+
+   uint32_t Cpu::add24(uint32_t a, uint32_t b, bool carry, bool sub, bool all_flags) {
+      uint32_t c = carry && (regs_.f & FLAG_C);
+      uint32_t res = sub ? a - b - c : a + b + c;
+      bool carry_out = sub ? static_cast<uint64_t>(b) + c > a : res > addr_mask;
+      res &= addr_mask;
+
+      uint8_t f = (((a ^ b ^ res) >> 8) & FLAG_H) | (sub ? FLAG_N : 0) | (carry_out ? FLAG_C : 0);
+      if (all_flags) {
+         uint32_t overflow = sub ? (a ^ b) & (a ^ res) : ~(a ^ b) & (a ^ res);
+         f |= ((res >> 16) & FLAG_S) | (res ? 0 : FLAG_Z) | ((overflow & 0x800000) ? FLAG_PV : 0);
+      } else {
+         f |= regs_.f & (FLAG_S | FLAG_Z | FLAG_PV);
+      }
+      regs_.f = f;
+      return res;
+   }
+
+
+   /*** INSTRUCTIONS ***/
+
+   void Cpu::ExecMain(uint8_t op) {
+      const int x = op >> 6, y = (op >> 3) & 7, z = op & 7, p = y >> 1, q = y & 1;
+
+      switch (x) {
+      case 0:
+         switch (z) {
+         case 0:
+            switch (y) {
+            case 0: break; /* nop */
+            case 1: /* ex af,af' */
+               std::swap(regs_.a, regs_.a_alt);
+               std::swap(regs_.f, regs_.f_alt);
+               break;
+            case 2: /* djnz d */
+               {
+                  uint32_t target = rel_target();
+                  uint8_t b = reg8(0) - 1;
+                  set_reg8(0, b);
+                  ++cycles_;
+                  if (b) { Jump(target); }
+               }
+               break;
+            case 3: /* jr d */
+               Jump(rel_target());
+               break;
+            default: /* jr cc,d */
+               {
+                  uint32_t target = rel_target();
+                  if (cond(y - 4)) { Jump(target); }
+               }
+               break;
+            }
+            break;
+
+         case 1:
+            if (q == 0) {
+               rp(p) = fetch24(); /* ld rr,Mmn */
+            } else {
+               *index_ = add24(*index_, rp(p), false, false, false); /* add hl,rr */
+            }
+            break;
+
+         case 2:
+            switch (y) {
+            case 0: write8(regs_.bc, regs_.a); break; /* ld (bc),a */
+            case 1: regs_.a = read8(regs_.bc); break; /* ld a,(bc) */
+            case 2: write8(regs_.de, regs_.a); break; /* ld (de),a */
+            case 3: regs_.a = read8(regs_.de); break; /* ld a,(de) */
+            case 4: /* ld (Mmn),hl */
+               {
+                  uint32_t addr = fetch24();
+                  write24(addr, *index_);
+               }
+               break;
+            case 5: *index_ = read24(fetch24()); break; /* ld hl,(Mmn) */
+            case 6: /* ld (Mmn),a */
+               {
+                  uint32_t addr = fetch24();
+                  write8(addr, regs_.a);
+               }
+               break;
+            case 7: regs_.a = read8(fetch24()); break; /* ld a,(Mmn) */
+            }
+            break;
+
+         case 3: /* inc/dec rr */
+            rp(p) = (rp(p) + (q ? -1 : 1)) & addr_mask;
+            break;
+
+         case 4: /* inc r */
+         case 5: /* dec r */
+            if (y == 6) {
+               uint32_t addr = mem_addr();
+               uint8_t val = read8(addr);
+               write8(addr, z == 4 ? inc8(val) : dec8(val));
+               ++cycles_;
+            } else {
+               set_reg8(y, z == 4 ? inc8(reg8(y)) : dec8(reg8(y)));
+            }
+            break;
+
+         case 6: /* ld r,n */
+            if (y == 6) {
+               uint32_t addr = mem_addr();
+               write8(addr, fetch8());
+            } else {
+               set_reg8(y, fetch8());
+            }
+            break;
+
+         case 7:
+            {
+               const uint8_t a = regs_.a;
+               const uint8_t szpv = regs_.f & (FLAG_S | FLAG_Z | FLAG_PV);
+               const bool carry = regs_.f & FLAG_C;
+               switch (y) {
+               case 0: /* rlca */
+                  regs_.a = (a << 1) | (a >> 7);
+                  regs_.f = szpv | (a >> 7);
+                  break;
+               case 1: /* rrca */
+                  regs_.a = (a >> 1) | (a << 7);
+                  regs_.f = szpv | (a & 1);
+                  break;
+               case 2: /* rla */
+                  regs_.a = (a << 1) | carry;
+                  regs_.f = szpv | (a >> 7);
+                  break;
+               case 3: /* rra */
+                  regs_.a = (a >> 1) | (carry << 7);
+                  regs_.f = szpv | (a & 1);
+                  break;
+               case 4: /* daa */
+                  {
+                     uint8_t corr = 0;
+                     bool carry_out = carry;
+                     if ((regs_.f & FLAG_H) || (a & 0xf) > 9) { corr |= 0x06; }
+                     if (carry || a > 0x99) {
+                        corr |= 0x60;
+                        carry_out = true;
+                     }
+                     uint8_t res = (regs_.f & FLAG_N) ? a - corr : a + corr;
+                     regs_.f = szp(res) | ((a ^ res) & FLAG_H) | (regs_.f & FLAG_N) |
+                        (carry_out ? FLAG_C : 0);
+                     regs_.a = res;
+                  }
+                  break;
+               case 5: /* cpl */
+                  regs_.a = ~a;
+                  regs_.f |= FLAG_H | FLAG_N;
+                  break;
+               case 6: /* scf */
+                  regs_.f = szpv | FLAG_C;
+                  break;
+               case 7: /* ccf */
+                  regs_.f = szpv | (carry ? FLAG_H : FLAG_C);
+                  break;
+               }
+            }
+            break;
+         }
+         break;
+
+      case 1:
+         if (op == 0x76) { /* halt */
+            status_ = Status::HALTED;
+         } else if (op == 0x40 || op == 0x49 || op == 0x52 || op == 0x5b) {
+            Fault("memory mode suffixes are not supported");
+         } else if (y == 6) { /* ld (hl),r */
+            uint32_t addr = mem_addr();
+            write8(addr, reg8(z, false));
+         } else if (z == 6) { /* ld r,(hl) */
+            set_reg8(y, read8(mem_addr()), false);
+         } else { /* ld r,r' */
+            set_reg8(y, reg8(z));
+         }
+         break;
+
+      case 2: /* alu a,r */
+         alu(y, z == 6 ? read8(mem_addr()) : reg8(z));
+         break;
+
+      case 3:
+         switch (z) {
+         case 0: /* ret cc */
+            if (cond(y)) {
+               regs_.pc = pop24();
+               cycles_ += 2;
+            }
+            break;
+
+         case 1:
+            if (q == 0) { /* pop rr */
+               uint32_t val = pop24();
+               if (p == 3) {
+                  regs_.f = val;
+                  regs_.a = val >> 8;
+               } else {
+                  rp(p) = val;
+               }
+            } else {
+               switch (p) {
+               case 0: /* ret */
+                  regs_.pc = pop24();
+                  cycles_ += 2;
+                  break;
+               case 1: /* exx */
+                  std::swap(regs_.bc, regs_.bc_alt);
+                  std::swap(regs_.de, regs_.de_alt);
+                  std::swap(regs_.hl, regs_.hl_alt);
+                  break;
+               case 2: /* jp (hl) */
+                  regs_.pc = *index_;
+                  cycles_ += 2;
+                  break;
+               case 3: /* ld sp,hl */
+                  regs_.sp = *index_;
+                  break;
+               }
+            }
+            break;
+
+         case 2: /* jp cc,Mmn */
+            {
+               uint32_t target = fetch24();
+               if (cond(y)) { Jump(target); }
+            }
+            break;
+
+         case 3:
+            switch (y) {
+            case 0: /* jp Mmn */
+               Jump(fetch24());
+               break;
+            case 1: /* bit prefix */
+               if (index_ == &regs_.hl) {
+                  ExecBit(fetch8(), nullptr);
+               } else {
+                  uint32_t addr = disp_addr(*index_);
+                  ExecBit(fetch8(), &addr);
+               }
+               break;
+            case 2: /* out (n),a */
+               fetch8();
+               ++cycles_;
+               break;
+            case 3: /* in a,(n) */
+               fetch8();
+               ++cycles_;
+               regs_.a = 0;
+               break;
+            case 4: /* ex (sp),hl */
+               {
+                  uint32_t val = read24(regs_.sp);
+                  write24(regs_.sp, *index_);
+                  *index_ = val;
+               }
+               break;
+            case 5: /* ex de,hl */
+               std::swap(regs_.de, regs_.hl);
+               break;
+            case 6: regs_.iff = false; break; /* di */
+            case 7: regs_.iff = true; break; /* ei */
+            }
+            break;
+
+         case 4: /* call cc,Mmn */
+            {
+               uint32_t target = fetch24();
+               if (cond(y)) {
+                  push24(regs_.pc);
+                  regs_.pc = target;
+               }
+            }
+            break;
+
+         case 5:
+            if (q == 0) { /* push rr */
+               push24(p == 3 ? (regs_.a << 8) | regs_.f : rp(p));
+            } else {
+               switch (p) {
+               case 0: /* call Mmn */
+                  {
+                     uint32_t target = fetch24();
+                     push24(regs_.pc);
+                     regs_.pc = target;
+                  }
+                  break;
+               case 1:
+                  index_ = &regs_.ix;
+                  ExecIndexed(fetch8());
+                  break;
+               case 2:
+                  ExecExtended(fetch8());
+                  break;
+               case 3:
+                  index_ = &regs_.iy;
+                  ExecIndexed(fetch8());
+                  break;
+               }
+            }
+            break;
+
+         case 6: /* alu a,n */
+            alu(y, fetch8());
+            break;
+
+         case 7: /* rst */
+            push24(regs_.pc);
+            regs_.pc = y * 8;
+            cycles_ += 2;
+            break;
+         }
+         break;
+      }
+   }
+
+   void Cpu::ExecIndexed(uint8_t op) {
+      /* eZ80 multibyte loads through ix/iy; other opcodes act as on hl */
+      uint32_t& other = index_ == &regs_.ix ? regs_.iy : regs_.ix;
+      switch (op) {
+      case 0x07: regs_.bc = read24(disp_addr(*index_)); break; /* ld bc,(ix+d) */
+      case 0x17: regs_.de = read24(disp_addr(*index_)); break; /* ld de,(ix+d) */
+      case 0x27: regs_.hl = read24(disp_addr(*index_)); break; /* ld hl,(ix+d) */
+      case 0x37: *index_ = read24(disp_addr(*index_)); break; /* ld ix,(ix+d) */
+      case 0x31: other = read24(disp_addr(*index_)); break; /* ld iy,(ix+d) */
+      case 0x0f: write24(disp_addr(*index_), regs_.bc); break; /* ld (ix+d),bc */
+      case 0x1f: write24(disp_addr(*index_), regs_.de); break; /* ld (ix+d),de */
+      case 0x2f: write24(disp_addr(*index_), regs_.hl); break; /* ld (ix+d),hl */
+      case 0x3f: write24(disp_addr(*index_), *index_); break; /* ld (ix+d),ix */
+      case 0x3e: write24(disp_addr(*index_), other); break; /* ld (ix+d),iy */
+      default: ExecMain(op); break;
+      }
+   }
+
+   void Cpu::ExecBit(uint8_t op, const uint32_t *addr) {
+      const int x = op >> 6, y = (op >> 3) & 7, z = op & 7;
+      const bool mem = addr || z == 6;
+      const uint32_t mem_addr = addr ? *addr : regs_.hl;
+      if (addr && z != 6) {
+         Fault("undocumented indexed bit opcode");
+         return;
+      }
+
+      uint8_t val = mem ? read8(mem_addr) : reg8(z, false);
+      switch (x) {
+      case 0: /* rotate/shift */
+         val = rot(y, val);
+         break;
+      case 1: /* bit */
+         regs_.f = (regs_.f & FLAG_C) | FLAG_H |
+            ((val & (1 << y)) ? (y == 7 ? FLAG_S : 0) : FLAG_Z | FLAG_PV);
+         return;
+      case 2: /* res */
+         val &= ~(1 << y);
+         break;
+      case 3: /* set */
+         val |= 1 << y;
+         break;
+      }
+
+      if (mem) {
+         write8(mem_addr, val);
+         ++cycles_;
+      } else {
+         set_reg8(z, val, false);
+      }
+   }
+
+   void Cpu::ExecExtended(uint8_t op) {
+      const int x = op >> 6, y = (op >> 3) & 7, z = op & 7, p = y >> 1, q = y & 1;
+      index_ = &regs_.hl;
+
+      switch (op) {
+         /* lea rr,ix/iy+d */
+      case 0x02: regs_.bc = disp_addr(regs_.ix); return;
+      case 0x03: regs_.bc = disp_addr(regs_.iy); return;
+      case 0x12: regs_.de = disp_addr(regs_.ix); return;
+      case 0x13: regs_.de = disp_addr(regs_.iy); return;
+      case 0x22: regs_.hl = disp_addr(regs_.ix); return;
+      case 0x23: regs_.hl = disp_addr(regs_.iy); return;
+      case 0x32: regs_.ix = disp_addr(regs_.ix); return;
+      case 0x33: regs_.iy = disp_addr(regs_.iy); return;
+      case 0x54: regs_.ix = disp_addr(regs_.iy); return;
+      case 0x55: regs_.iy = disp_addr(regs_.ix); return;
+
+         /* pea ix/iy+d */
+      case 0x65: push24(disp_addr(regs_.ix)); ++cycles_; return;
+      case 0x66: push24(disp_addr(regs_.iy)); ++cycles_; return;
+
+         /* ld rr,(hl) / ld (hl),rr */
+      case 0x07: regs_.bc = read24(regs_.hl); return;
+      case 0x17: regs_.de = read24(regs_.hl); return;
+      case 0x27: regs_.hl = read24(regs_.hl); return;
+      case 0x37: regs_.ix = read24(regs_.hl); return;
+      case 0x31: regs_.iy = read24(regs_.hl); return;
+      case 0x0f: write24(regs_.hl, regs_.bc); return;
+      case 0x1f: write24(regs_.hl, regs_.de); return;
+      case 0x2f: write24(regs_.hl, regs_.hl); return;
+      case 0x3f: write24(regs_.hl, regs_.ix); return;
+      case 0x3e: write24(regs_.hl, regs_.iy); return;
+
+         /* mlt rr */
+      case 0x4c:
+      case 0x5c:
+      case 0x6c:
+      case 0x7c:
+         {
+            uint32_t& pair = rp(p);
+            pair = (pair & 0xff) * ((pair >> 8) & 0xff);
+            cycles_ += 4;
+         }
+         return;
+
+      case 0x64: /* tst a,n */
+         regs_.f = szp(regs_.a & fetch8()) | FLAG_H;
+         return;
+      case 0x74: /* tstio n */
+         fetch8();
+         ++cycles_;
+         return;
+      case 0x6d: regs_.mb = regs_.a; return; /* ld mb,a */
+      case 0x6e: regs_.a = regs_.mb; return; /* ld a,mb */
+      case 0x7d: /* stmix */
+      case 0x7e: /* rsmix */
+         return;
+      case 0x76: /* slp */
+         status_ = Status::HALTED;
+         return;
+      case 0xc7: regs_.i = regs_.hl; return; /* ld i,hl */
+      case 0xd7: regs_.hl = regs_.i; return; /* ld hl,i */
+
+         /* block transfer and search */
+      case 0xa0: /* ldi */
+      case 0xa8: /* ldd */
+      case 0xb0: /* ldir */
+      case 0xb8: /* lddr */
+         {
+            const uint32_t step = (op & 0x08) ? -1 : 1;
+            do {
+               write8(regs_.de, read8(regs_.hl));
+               ++cycles_;
+               regs_.hl = (regs_.hl + step) & addr_mask;
+               regs_.de = (regs_.de + step) & addr_mask;
+               regs_.bc = (regs_.bc - 1) & addr_mask;
+            } while ((op & 0x10) && regs_.bc);
+            regs_.f = (regs_.f & (FLAG_S | FLAG_Z | FLAG_C)) | (regs_.bc ? FLAG_PV : 0);
+         }
+         return;
+      case 0xa1: /* cpi */
+      case 0xa9: /* cpd */
+      case 0xb1: /* cpir */
+      case 0xb9: /* cpdr */
+         {
+            const uint32_t step = (op & 0x08) ? -1 : 1;
+            uint8_t val, res;
+            do {
+               val = read8(regs_.hl);
+               res = regs_.a - val;
+               ++cycles_;
+               regs_.hl = (regs_.hl + step) & addr_mask;
+               regs_.bc = (regs_.bc - 1) & addr_mask;
+            } while ((op & 0x10) && regs_.bc && res);
+            regs_.f = (regs_.f & FLAG_C) | sz(res) | ((regs_.a ^ val ^ res) & FLAG_H) |
+               (regs_.bc ? FLAG_PV : 0) | FLAG_N;
+         }
+         return;
+      }
+
+      switch (x) {
+      case 0:
+         switch (z) {
+         case 0: /* in0 r,(n) */
+            fetch8();
+            ++cycles_;
+            if (y != 6) { set_reg8(y, 0); }
+            regs_.f = (regs_.f & FLAG_C) | FLAG_Z | FLAG_PV;
+            return;
+         case 1: /* out0 (n),r */
+            fetch8();
+            ++cycles_;
+            return;
+         case 4: /* tst a,r */
+            regs_.f = szp(regs_.a & (y == 6 ? read8(regs_.hl) : reg8(y))) | FLAG_H;
+            return;
+         }
+         break;
+
+      case 1:
+         switch (z) {
+         case 0: /* in r,(c) */
+            if (y != 6) { set_reg8(y, 0); }
+            regs_.f = (regs_.f & FLAG_C) | FLAG_Z | FLAG_PV;
+            return;
+         case 1: /* out (c),r */
+            return;
+         case 2: /* sbc/adc hl,rr */
+            regs_.hl = add24(regs_.hl, rp(p), true, q == 0, true);
+            return;
+         case 3:
+            if (q == 0) { /* ld (Mmn),rr */
+               uint32_t addr = fetch24();
+               write24(addr, rp(p));
+            } else { /* ld rr,(Mmn) */
+               rp(p) = read24(fetch24());
+            }
+            return;
+         case 4:
+            if (y == 0) { /* neg */
+               uint8_t val = regs_.a;
+               regs_.a = 0;
+               alu(2, val);
+               return;
+            }
+            break;
+         case 5:
+            if (y <= 1) { /* retn/reti */
+               regs_.pc = pop24();
+               cycles_ += 2;
+               return;
+            }
+            break;
+         case 6: /* im */
+            return;
+         case 7:
+            switch (y) {
+            case 0: regs_.i = (regs_.i & ~0xffu) | regs_.a; return; /* ld i,a */
+            case 1: regs_.r = regs_.a; return; /* ld r,a */
+            case 2: /* ld a,i */
+            case 3: /* ld a,r */
+               regs_.a = y == 2 ? regs_.i : regs_.r;
+               regs_.f = (regs_.f & FLAG_C) | sz(regs_.a) | (regs_.iff ? FLAG_PV : 0);
+               return;
+            case 4: /* rrd */
+            case 5: /* rld */
+               {
+                  uint8_t val = read8(regs_.hl);
+                  uint8_t a = regs_.a;
+                  if (y == 4) {
+                     regs_.a = (a & 0xf0) | (val & 0x0f);
+                     val = (val >> 4) | (a << 4);
+                  } else {
+                     regs_.a = (a & 0xf0) | (val >> 4);
+                     val = (val << 4) | (a & 0x0f);
+                  }
+                  write8(regs_.hl, val);
+                  ++cycles_;
+                  regs_.f = (regs_.f & FLAG_C) | szp(regs_.a);
+               }
+               return;
+            }
+            break;
+         }
+         break;
+      }
+
+      Fault("invalid extended opcode " + hex(op).substr(4));
+   }
+
+}
@@ -0,0 +1,229 @@
+/* runtime library routines in ROM, simulated natively */
+
+#include <algorithm>
+
+#include "sim.hpp"
+
+namespace zc::sim {
+
+   namespace {
+
+      /* cycle estimates, matching those codegen assumes (cgen/emit.cpp) */
+      constexpr int mul_cycles = 150;
+      constexpr int div_cycles[] = {0, 100, 350, 600}; /* indexed by operand size */
+      constexpr int shift_cycles(int shift) { return 10 + 8 * shift; }
+      constexpr int logic_cycles = 10;
+
+      uint32_t mask(int bytes) { return bytes == 3 ? addr_mask : (1u << (8 * bytes)) - 1; }
+
+      int32_t sext(uint32_t val, int bytes) {
+         const int shift = 32 - 8 * bytes;
+         return static_cast<int32_t>(val << shift) >> shift;
+      }
+
+      /* operands: a and b for bytes, hl and bc otherwise */
+      uint32_t arg1(Cpu& cpu, int bytes) {
+         return (bytes == 1 ? cpu.regs().a : cpu.regs().hl) & mask(bytes);
+      }
+
+      uint32_t arg2(Cpu& cpu, int bytes) {
+         return (bytes == 1 ? cpu.regs().bc >> 8 : cpu.regs().bc) & mask(bytes);
+      }
+
+      void set_arg(uint32_t& reg, uint32_t val, int bytes, int shift = 0) {
+         const uint32_t m = mask(bytes) << shift;
+         reg = (reg & ~m) | ((val << shift) & m);
+      }
+
+      void set_arg1(Cpu& cpu, uint32_t val, int bytes) {
+         if (bytes == 1) {
+            cpu.regs().a = val;
+         } else {
+            set_arg(cpu.regs().hl, val, bytes);
+         }
+      }
+
+      void set_arg2(Cpu& cpu, uint32_t val, int bytes) {
+         set_arg(cpu.regs().bc, val, bytes, bytes == 1 ? 8 : 0);
+      }
+
+      template <int Bytes>
+      int neg(Cpu& cpu) {
+         set_arg1(cpu, -arg1(cpu, Bytes), Bytes);
+         cpu.Return();
+         return logic_cycles;
+      }
+
+      template <int Bytes>
+      int bitwise_not(Cpu& cpu) {
+         set_arg1(cpu, ~arg1(cpu, Bytes), Bytes);
+         cpu.Return();
+         return logic_cycles;
+      }
+
+      template <int Bytes, char Op>
+      int logic(Cpu& cpu) {
+         const uint32_t a = arg1(cpu, Bytes), b = arg2(cpu, Bytes);
+         set_arg1(cpu, Op == '&' ? a & b : Op == '|' ? a | b : a ^ b, Bytes);
+         cpu.Return();
+         return logic_cycles;
+      }
+
+      template <int Bytes>
+      int mul(Cpu& cpu) {
+         /* low bits of the product are the same signed or unsigned */
+         set_arg1(cpu, arg1(cpu, Bytes) * arg2(cpu, Bytes), Bytes);
+         cpu.Return();
+         return mul_cycles;
+      }
+
+      /* codegen expects the quotient in the first argument and the remainder in the second,
+       * as __bdivu in crt.z80 leaves them */
+      template <int Bytes, bool Signed>
+      int div(Cpu& cpu) {
+         const uint32_t a = arg1(cpu, Bytes), b = arg2(cpu, Bytes);
+         uint32_t quot, rem;
+         if (b == 0) {
+            quot = mask(Bytes);
+            rem = a;
+         } else if (Signed) {
+            const int32_t sa = sext(a, Bytes), sb = sext(b, Bytes);
+            quot = sa / sb;
+            rem = sa % sb;
+         } else {
+            quot = a / b;
+            rem = a % b;
+         }
+         set_arg1(cpu, quot, Bytes);
+         set_arg2(cpu, rem, Bytes);
+         cpu.Return();
+         return div_cycles[Bytes];
+      }
+
+      /* shift count in c; byte routines shift a by b */
+      template <int Bytes, char Op>
+      int shift(Cpu& cpu) {
+         const uint32_t a = arg1(cpu, Bytes);
+         const int count = (Bytes == 1 ? cpu.regs().bc >> 8 : cpu.regs().bc) & 0xff;
+         uint32_t res;
+         if (count >= 8 * Bytes) {
+            res = Op == 's' && sext(a, Bytes) < 0 ? mask(Bytes) : 0;
+         } else if (Op == '<') {
+            res = a << count;
+         } else if (Op == 's') {
+            res = sext(a, Bytes) >> count;
+         } else {
+            res = a >> count;
+         }
+         set_arg1(cpu, res, Bytes);
+         cpu.Return();
+         return shift_cycles(std::min(count, 8 * Bytes));
+      }
+
+      template <int Bytes>
+      int cmpzero(Cpu& cpu) {
+         const uint32_t val = arg1(cpu, Bytes);
+         Registers& regs = cpu.regs();
+         regs.f = (regs.f & ~(FLAG_S | FLAG_Z | FLAG_C | FLAG_PV)) | (val ? 0 : FLAG_Z) |
+            (sext(val, Bytes) < 0 ? FLAG_S : 0);
+         cpu.Return();
+         return logic_cycles;
+      }
+
+      template <bool Signed>
+      int stoi(Cpu& cpu) {
+         const uint32_t val = cpu.regs().hl & 0xffff;
+         cpu.regs().hl = (Signed ? sext(val, 2) : val) & addr_mask;
+         cpu.Return();
+         return logic_cycles;
+      }
+
+      int indcall(Cpu& cpu) {
+         /* jp (iy): the caller's return address stays on the stack */
+         cpu.regs().pc = cpu.regs().iy;
+         return 4;
+      }
+
+      /* C library routines take their arguments on the stack, above the return address */
+      uint32_t stack_arg(Cpu& cpu, int i) {
+         return cpu.mem().read24(cpu.regs().sp + 3 * (i + 1));
+      }
+
+      int memcpy(Cpu& cpu) {
+         const uint32_t dst = stack_arg(cpu, 0), src = stack_arg(cpu, 1), n = stack_arg(cpu, 2);
+         for (uint32_t i = 0; i < n; ++i) {
+            cpu.mem().write8(dst + i, cpu.mem().read8(src + i));
+         }
+         cpu.regs().hl = dst;
+         cpu.Return();
+         return 20 + 3 * n;
+      }
+
+      int memset(Cpu& cpu) {
+         const uint32_t dst = stack_arg(cpu, 0), val = stack_arg(cpu, 1), n = stack_arg(cpu, 2);
+         for (uint32_t i = 0; i < n; ++i) {
+            cpu.mem().write8(dst + i, val);
+         }
+         cpu.regs().hl = dst;
+         cpu.Return();
+         return 20 + 3 * n;
+      }
+
+      int strlen(Cpu& cpu) {
+         const uint32_t str = stack_arg(cpu, 0);
+         uint32_t len = 0;
+         while (cpu.mem().read8(str + len)) { ++len; }
+         cpu.regs().hl = len;
+         cpu.Return();
+         return 20 + 4 * len;
+      }
+
+      /* addresses from tst/ti84pce.inc; sorted by address */
+      const Routine routines[] = {
+         {"__memcpy", 0x0000a4, memcpy},
+         {"__memset", 0x0000ac, memset},
+         {"__strlen", 0x0000d4, strlen},
+         {"__bshl", 0x000100, shift<1, '<'>},
+         {"__bshru", 0x000104, shift<1, 'u'>},
+         {"__iand", 0x000134, logic<3, '&'>},
+         {"__icmpzero", 0x000138, cmpzero<3>},
+         {"__idivs", 0x00013c, div<3, true>},
+         {"__idivu", 0x000140, div<3, false>},
+         {"__imulu", 0x000154, mul<3>},
+         {"__imuls", 0x000158, mul<3>},
+         {"__indcall", 0x00015c, indcall},
+         {"__ineg", 0x000160, neg<3>},
+         {"__inot", 0x000164, bitwise_not<3>},
+         {"__ior", 0x000168, logic<3, '|'>},
+         {"__ishl", 0x000174, shift<3, '<'>},
+         {"__ishrs", 0x00017c, shift<3, 's'>},
+         {"__ishru", 0x000184, shift<3, 'u'>},
+         {"__ixor", 0x000198, logic<3, '^'>},
+         {"__sand", 0x000200, logic<2, '&'>},
+         {"__scmpzero", 0x000204, cmpzero<2>},
+         {"__sdivs", 0x000208, div<2, true>},
+         {"__sdivu", 0x00020c, div<2, false>},
+         {"__smuls", 0x000224, mul<2>},
+         {"__smulu", 0x000228, mul<2>},
+         {"__sneg", 0x00022c, neg<2>},
+         {"__snot", 0x000230, bitwise_not<2>},
+         {"__sor", 0x000234, logic<2, '|'>},
+         {"__sshl", 0x000240, shift<2, '<'>},
+         {"__sshrs", 0x000248, shift<2, 's'>},
+         {"__sshru", 0x000250, shift<2, 'u'>},
+         {"__stoi", 0x000260, stoi<true>},
+         {"__stoiu", 0x000264, stoi<false>},
+         {"__sxor", 0x000268, logic<2, '^'>},
+      };
+
+   }
+
+   const Routine *runtime_routine(uint32_t addr) {
+      auto it = std::lower_bound(std::begin(routines), std::end(routines), addr,
+                                 [](const Routine& routine, uint32_t addr) {
+                                    return routine.addr < addr;
+                                 });
+      return it != std::end(routines) && it->addr == addr ? it : nullptr;
+   }
+
+}
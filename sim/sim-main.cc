@@ -0,0 +1,156 @@
+/* zc-sim: run an assembled eZ80 binary and report cycle counts */
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include <unistd.h>
+
+#include "sim.hpp"
+
+namespace {
+
+   void usage(const char *program) {
+      std::cerr << "Usage: " << program
+                << " [-hj] [-l load_addr] [-e entry] [-s sp] [-c max_cycles] [-m addr:size]..."
+                << " file.bin" << std::endl;
+   }
+
+   bool parse_num(const char *str, uint64_t& out) {
+      char *end;
+      out = std::strtoull(str, &end, 0);
+      return *str != '\0' && *end == '\0';
+   }
+
+   const char *status_name(zc::sim::Cpu::Status status) {
+      using Status = zc::sim::Cpu::Status;
+      switch (status) {
+      case Status::RUNNING:  return "running";
+      case Status::HALTED:   return "halted";
+      case Status::RETURNED: return "returned";
+      case Status::FAULT:    return "fault";
+      case Status::TIMEOUT:  return "timeout";
+      }
+      return "unknown";
+   }
+
+   std::string hex(uint32_t val, int digits = 6) {
+      char buf[16];
+      std::snprintf(buf, sizeof(buf), "%0*x", digits, val);
+      return buf;
+   }
+
+}
+
+int main(int argc, char *argv[]) {
+   using namespace zc::sim;
+
+   uint64_t load = user_mem, entry = user_mem, sp = stack_top, max_cycles = 1000000000;
+   bool entry_set = false;
+   bool json = false;
+   std::vector<std::pair<uint64_t, uint64_t>> crcs;
+
+   int c;
+   opterr = 0;
+   while ((c = getopt(argc, argv, "l:e:s:c:m:jh")) != -1) {
+      uint64_t *num = nullptr;
+      switch (c) {
+      case 'l': num = &load; break;
+      case 'e': num = &entry; entry_set = true; break;
+      case 's': num = &sp; break;
+      case 'c': num = &max_cycles; break;
+      case 'm':
+         {
+            std::string arg = optarg;
+            auto colon = arg.find(':');
+            uint64_t addr, size;
+            if (colon == std::string::npos ||
+                !parse_num(arg.substr(0, colon).c_str(), addr) ||
+                !parse_num(arg.substr(colon + 1).c_str(), size)) {
+               std::cerr << argv[0] << ": -m: expected addr:size" << std::endl;
+               return 2;
+            }
+            crcs.push_back({addr, size});
+         }
+         break;
+      case 'j':
+         json = true;
+         break;
+      case 'h':
+         usage(argv[0]);
+         return 0;
+      default:
+         usage(argv[0]);
+         return 2;
+      }
+
+      if (num && !parse_num(optarg, *num)) {
+         std::cerr << argv[0] << ": -" << static_cast<char>(c) << ": bad number '" << optarg
+                   << "'" << std::endl;
+         return 2;
+      }
+   }
+
+   if (optind + 1 != argc) {
+      usage(argv[0]);
+      return 2;
+   }
+   if (!entry_set) { entry = load; }
+
+   std::ifstream ifs(argv[optind], std::ios::binary);
+   if (!ifs) {
+      std::cerr << argv[0] << ": cannot open '" << argv[optind] << "'" << std::endl;
+      return 2;
+   }
+   std::vector<uint8_t> image((std::istreambuf_iterator<char>(ifs)),
+                              std::istreambuf_iterator<char>());
+
+   /* 16 MiB of memory is too much for the stack */
+   auto cpu = std::make_unique<Cpu>();
+   if (!cpu->mem().Load(load, image)) {
+      std::cerr << argv[0] << ": image does not fit at " << hex(load) << std::endl;
+      return 2;
+   }
+   cpu->Call(entry, sp);
+   Cpu::Status status = cpu->Run(max_cycles);
+   bool ok = status == Cpu::Status::HALTED || status == Cpu::Status::RETURNED;
+
+   if (json) {
+      std::cout << "{\"status\": \"" << status_name(status) << "\"";
+      if (status == Cpu::Status::FAULT) {
+         std::cout << ", \"fault\": \"" << cpu->fault() << "\"";
+      }
+      std::cout << ", \"cycles\": " << cpu->cycles()
+                << ", \"instructions\": " << cpu->instrs()
+                << ", \"runtime_calls\": " << cpu->runtime_calls()
+                << ", \"hl\": " << cpu->regs().hl
+                << ", \"crc32\": [";
+      for (auto it = crcs.begin(); it != crcs.end(); ++it) {
+         std::cout << (it == crcs.begin() ? "" : ", ") << "{\"addr\": " << it->first
+                   << ", \"size\": " << it->second
+                   << ", \"value\": \"" << hex(cpu->mem().crc32(it->first, it->second), 8)
+                   << "\"}";
+      }
+      std::cout << "]}" << std::endl;
+   } else {
+      std::cout << "status\t" << status_name(status) << std::endl;
+      if (status == Cpu::Status::FAULT) {
+         std::cout << "fault\t" << cpu->fault() << std::endl;
+      }
+      std::cout << "cycles\t" << cpu->cycles() << std::endl
+                << "instructions\t" << cpu->instrs() << std::endl
+                << "runtime-calls\t" << cpu->runtime_calls() << std::endl
+                << "hl\t" << hex(cpu->regs().hl) << std::endl;
+      for (const auto& crc : crcs) {
+         std::cout << "crc32 " << hex(crc.first) << ":" << crc.second << "\t"
+                   << hex(cpu->mem().crc32(crc.first, crc.second), 8) << std::endl;
+      }
+   }
+
+   return ok ? 0 : 1;
+}
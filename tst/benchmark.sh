@@ -1,8 +1,29 @@
 #!/bin/bash
 
 # BENCHMARK FOR ZC
+# Compile each benchmark under each line of the parameters file, recording the size of the binary,
+# the static cycle estimate (zc -p cost-stats) and, for benchmarks with a main, the cycles zc-sim
+# counts running it. Results are written to OUTFILE as JSON, one result per line. Given a
+# BASELINE in the same format, fails if a metric grew by more than its threshold (in percent).
+# Fails if a benchmark's result differs between parameter lines.
 
-USAGE="$0 BENCHMARK_DIR PARAMS_FILE OUTFILE"
+USAGE="$0 [-b PCT] [-s PCT] [-c PCT] BENCHMARK_DIR PARAMS_FILE OUTFILE [BASELINE]
+-b: bytes threshold
+-s: static cycle estimate threshold
+-c: simulated cycles threshold"
+
+BYTES_PCT=1
+STATIC_PCT=1
+CYCLES_PCT=1
+while getopts "b:s:c:h" OPT; do
+    case $OPT in
+        b) BYTES_PCT="$OPTARG" ;;
+        s) STATIC_PCT="$OPTARG" ;;
+        c) CYCLES_PCT="$OPTARG" ;;
+        *) echo "$USAGE"; exit 1 ;;
+    esac
+done
+shift $((OPTIND - 1))
 
 if [[ $# -lt 3 ]]; then
     echo "$USAGE"
@@ -12,6 +33,7 @@ fi
 DIR="$1"
 PARAMSF="$2"
 OUTF="$3"
+BASEF="$4"
 
 if ! [ -d "$DIR" ]; then
     echo "$0: $DIR: directory does not exist"
@@ -23,7 +45,6 @@ if ! [ -f "$PARAMSF" ]; then
     echo "$0: $PARAMSF: file does not exist"
     exit 2
 fi
-# PARAMS=$(< "$PARAMSF")
 
 if ! [ -d "$(dirname "$OUTF")" ]; then
     echo "$0: " $(dirname "$OUTF"): directory does not exist
@@ -33,6 +54,11 @@ if [ -f "$OUTF" ]; then
     rm "$OUTF"
 fi
 
+if [[ -n "$BASEF" ]] && ! [ -f "$BASEF" ]; then
+    echo "$0: $BASEF: no baseline; not checking for regressions" >&2
+    BASEF=
+fi
+
 # $1: SRC
 # $2: PARAM
 getsize() {
@@ -45,22 +71,124 @@ getsize() {
     wc -c < "$BIN"
 }
 
-PARAM1=$(head -n1 "$PARAMSF")
-# PARAM_ARR=($PARAMS)
-# PARAM1=${PARAM_ARR[0]}
+# $1: SRC
+# $2: PARAM
+getstatic() {
+    COST="$(dirname $1)"/"$(basename $1 .c)".cost
+    rm -f "$COST"
+    make -B "$COST" $2 > /dev/null 2> /dev/null || return 1
+    awk -F'\t' 'found { print $2; exit } /^BYTES\tCYCLES$/ { found = 1 }' "$COST"
+}
+
+# $1: SRC
+# $2: PARAM
+# Prints cycles, status and result (hl), tab-separated. Run after getsize.
+getcycles() {
+    CYCLES="$(dirname $1)"/bare-"$(basename $1 .c)".cycles
+    rm -f "$CYCLES"
+    make "$CYCLES" $2 > /dev/null 2> /dev/null
+    [ -f "$CYCLES" ] || return 1
+    awk -F'\t' '{ val[$1] = $2 }
+                 END { printf "%s\t%s\t%s\n", val["cycles"], val["status"], val["hl"] }' "$CYCLES"
+}
+
+# $1: RECORD
+# $2: FIELD
+field() {
+    sed -n "s/.*\"$2\": \"\\{0,1\\}\\([^\",}]*\\).*/\\1/p" <<< "$1"
+}
 
+# $1: NEW
+# $2: BASE
+# Prints percent change, or nothing if either is missing.
+pctdiff() {
+    [[ "$1" =~ ^[0-9]+$ && "$2" =~ ^[0-9]+$ && "$2" -gt 0 ]] || return
+    awk "BEGIN {printf \"%.1f\", ($1 - $2) * 100 / $2}"
+}
+
+# $1: NAME
+# $2: PARAM
+# $3: METRIC
+# $4: PCT
+# $5: THRESHOLD
+checkdiff() {
+    if [[ -n "$4" ]] && awk "BEGIN {exit !($4 > $5)}"; then
+        echo "$1: $2: $3 regressed by $4% (threshold $5%)" >&2
+        return 1
+    fi
+}
+
+# $1: number or empty
+jsonnum() {
+    printf "%s" "${1:-null}"
+}
+
+# $1: string or empty
+jsonstr() {
+    if [[ -z "$1" ]]; then
+        printf "null"
+    else
+        printf "\"%s\"" "$1"
+    fi
+}
+
+FAIL=0
+SEP=" "
+TABLE=$(printf "NAME\tPARAM\tBYTES\tPCT-DIFF\tSTATIC\tPCT-DIFF\tCYCLES\tPCT-DIFF\tSTATUS")
+{
+    printf "{\n"
+    printf "\"thresholds\": {\"bytes\": %s, \"static_cycles\": %s, \"cycles\": %s},\n" \
+           "$BYTES_PCT" "$STATIC_PCT" "$CYCLES_PCT"
+    printf "\"results\": [\n"
+} > "$OUTF"
 
 for SRC in $SRCS; do
-    echo "$SRC" >> "$OUTF"
-    # LEGEND
-    printf "NAME\tTOTAL\tABS-DIFF\tPCT-DIFF\n" >> "$OUTF"
-    REFSIZE=$(getsize "$SRC" "$PARAM1") || exit 1
+    NAME=$(basename "$SRC" .c)
+    REFRESULT=
     while read PARAM; do
-    # for PARAM in $PARAMS; do
         SIZE=$(getsize "$SRC" "$PARAM") || continue
-        DIFF=$(($SIZE - $REFSIZE))
-        PCTDIFF=$(awk "BEGIN {print ${DIFF}*100/${REFSIZE}}")
-        printf "\t%s\t%d\t%d\t%.1f\n" $PARAM $SIZE $DIFF $PCTDIFF  >> "$OUTF"
+        STATIC=$(getstatic "$SRC" "$PARAM")
+        CYCLES= STATUS= RESULT=
+        if grep -q '\<main *(' "$SRC"; then
+            IFS=$'\t' read CYCLES STATUS RESULT <<< "$(getcycles "$SRC" "$PARAM")"
+        fi
+
+        RECORD="{\"benchmark\": \"$NAME\", \"param\": \"$PARAM\", \"bytes\": $(jsonnum "$SIZE")"
+        RECORD+=", \"static_cycles\": $(jsonnum "$STATIC"), \"cycles\": $(jsonnum "$CYCLES")"
+        RECORD+=", \"status\": $(jsonstr "$STATUS"), \"result\": $(jsonstr "$RESULT")}"
+        printf "%s%s\n" "$SEP" "$RECORD" >> "$OUTF"
+        SEP=","
+
+        if [[ -n "$STATUS" && "$STATUS" != halted && "$STATUS" != returned ]]; then
+            echo "$NAME: $PARAM: simulation $STATUS" >&2
+            FAIL=1
+        elif [[ -n "$RESULT" ]]; then
+            if [[ -z "$REFRESULT" ]]; then
+                REFRESULT="$RESULT"
+            elif [[ "$RESULT" != "$REFRESULT" ]]; then
+                echo "$NAME: $PARAM: result $RESULT differs from $REFRESULT" >&2
+                FAIL=1
+            fi
+        fi
+
+        BYTES_DIFF= STATIC_DIFF= CYCLES_DIFF=
+        if [[ -n "$BASEF" ]]; then
+            BASE=$(grep -F "\"benchmark\": \"$NAME\", \"param\": \"$PARAM\"," "$BASEF")
+            BYTES_DIFF=$(pctdiff "$SIZE" "$(field "$BASE" bytes)")
+            STATIC_DIFF=$(pctdiff "$STATIC" "$(field "$BASE" static_cycles)")
+            CYCLES_DIFF=$(pctdiff "$CYCLES" "$(field "$BASE" cycles)")
+            checkdiff "$NAME" "$PARAM" bytes "$BYTES_DIFF" "$BYTES_PCT" || FAIL=1
+            checkdiff "$NAME" "$PARAM" static_cycles "$STATIC_DIFF" "$STATIC_PCT" || FAIL=1
+            checkdiff "$NAME" "$PARAM" cycles "$CYCLES_DIFF" "$CYCLES_PCT" || FAIL=1
+        fi
+
+        TABLE+=$(printf "\n%s\t%s\t%s\t%s\t%s\t%s\t%s\t%s\t%s" "$NAME" "$PARAM" "$SIZE" \
+                        "${BYTES_DIFF:--}" "${STATIC:--}" "${STATIC_DIFF:--}" "${CYCLES:--}" \
+                        "${CYCLES_DIFF:--}" "${STATUS:--}")
     done < "$PARAMSF"
-    printf "\n" >> "$OUTF"
 done
+
+printf "]\n}\n" >> "$OUTF"
+column -t <<< "$TABLE"
+
+exit $FAIL
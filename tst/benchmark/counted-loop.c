@@ -0,0 +1,24 @@
+void copy16(char *dst, char *src) {
+   int i;
+   for (i = 0; i < 16; ++i) {
+      *dst++ = *src++;
+   }
+}
+
+void clear256(char *buf) {
+   unsigned char i;
+   for (i = 255; i != 0; --i) {
+      buf[i] = 0;
+   }
+   buf[0] = 0;
+}
+
+int sum10(int *vals) {
+   int sum;
+   char i;
+   sum = 0;
+   for (i = 10; i > 0; i--) {
+      sum = sum + *vals++;
+   }
+   return sum;
+}
@@ -0,0 +1,34 @@
+/* bitwise CRC-32 (reflected, polynomial 0xedb88320) of 256 bytes; int is 24 bits, so the
+ * register is kept as two 16-bit halves */
+void crc32_byte(unsigned short *crc, unsigned char byte) {
+   int bit;
+   unsigned short lo;
+   unsigned short hi;
+   unsigned short carry;
+
+   lo = crc[0] ^ byte;
+   hi = crc[1];
+   for (bit = 0; bit < 8; ++bit) {
+      carry = lo & 1;
+      lo = (lo >> 1) | ((hi & 1) << 15);
+      hi = hi >> 1;
+      if (carry) {
+         hi = hi ^ 60856;
+         lo = lo ^ 33568;
+      }
+   }
+   crc[0] = lo;
+   crc[1] = hi;
+}
+
+int main(void) {
+   unsigned short crc[2];
+   int i;
+
+   crc[0] = 65535;
+   crc[1] = 65535;
+   for (i = 0; i < 256; ++i) {
+      crc32_byte(crc, i * 7);
+   }
+   return ((crc[1] ^ 65535) << 8) ^ (crc[0] ^ 65535);
+}
@@ -0,0 +1,22 @@
+int digits(char *buf, unsigned short n) {
+   int len;
+   len = 0;
+   while (n) {
+      buf[len] = '0' + n % 10;
+      n = n / 10;
+      ++len;
+   }
+   return len;
+}
+
+int average(int *vals, int n) {
+   int sum;
+   int i;
+   sum = 0;
+   i = 0;
+   while (i < n) {
+      sum = sum + vals[i];
+      ++i;
+   }
+   return sum / 8;
+}
@@ -0,0 +1,11 @@
+/* naive recursive Fibonacci: call and return overhead */
+int fib(int n) {
+   if (n < 2) {
+      return n;
+   }
+   return fib(n - 1) + fib(n - 2);
+}
+
+int main(void) {
+   return fib(15);
+}
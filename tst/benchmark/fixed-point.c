@@ -0,0 +1,35 @@
+/* Mandelbrot set escape times in 16.8 fixed point; int is 24 bits */
+int escape(int cr, int ci) {
+   int zr;
+   int zi;
+   int zr2;
+   int zi2;
+   int n;
+
+   zr = 0;
+   zi = 0;
+   for (n = 0; n < 16; ++n) {
+      zr2 = (zr * zr) >> 8;
+      zi2 = (zi * zi) >> 8;
+      if (zr2 + zi2 > 1024) {
+         return n;
+      }
+      zi = ((zr * zi) >> 7) + ci;
+      zr = zr2 - zi2 + cr;
+   }
+   return n;
+}
+
+int main(void) {
+   int x;
+   int y;
+   int total;
+
+   total = 0;
+   for (y = -256; y < 256; y = y + 64) {
+      for (x = -512; x < 256; x = x + 64) {
+         total = total * 3 + escape(x, y);
+      }
+   }
+   return total;
+}
@@ -0,0 +1,36 @@
+struct point {
+   int x;
+   int y;
+};
+
+int table[8];
+
+int sum_y(struct point *pts, int n) {
+   int sum;
+   int i;
+   sum = 0;
+   for (i = 0; i < n; ++i) {
+      sum = sum + pts->y;
+      ++pts;
+   }
+   return sum;
+}
+
+void fill(int val, int n) {
+   int i;
+   for (i = 0; i < n; ++i) {
+      table[i & 7] = val;
+   }
+}
+
+int scan(int n) {
+   char buf[16];
+   int i;
+   int acc;
+   acc = 0;
+   for (i = 0; i < n; ++i) {
+      buf[i & 15] = i;
+      acc = acc + buf[(i + 1) & 15];
+   }
+   return acc;
+}
@@ -0,0 +1,29 @@
+/* byte-at-a-time copy of 512 bytes; buffers are in pixelShadow, since globals get no storage
+ * and locals are limited to the frame */
+void copy(char *dst, char *src, int n) {
+   while (n) {
+      *dst++ = *src++;
+      --n;
+   }
+}
+
+int main(void) {
+   char *src;
+   char *dst;
+   int i;
+   int sum;
+
+   src = (char *) 13644278;
+   dst = src + 512;
+   for (i = 0; i < 512; ++i) {
+      src[i] = i * 3;
+   }
+
+   copy(dst, src, 512);
+
+   sum = 0;
+   for (i = 0; i < 512; ++i) {
+      sum = sum + dst[i] * (i & 7);
+   }
+   return sum;
+}
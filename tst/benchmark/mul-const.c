@@ -0,0 +1,19 @@
+int hash(char *str) {
+   int h;
+   h = 5381;
+   while (*str) {
+      h = h * 33 + *str;
+      ++str;
+   }
+   return h;
+}
+
+int rows(int *table, int row, int col) {
+   int sum;
+   sum = 0;
+   while (row) {
+      --row;
+      sum = sum + table[row * 10 + col] * 7;
+   }
+   return sum;
+}
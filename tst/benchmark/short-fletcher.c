@@ -0,0 +1,14 @@
+unsigned short fletcher16(unsigned char *data, int n) {
+   unsigned short sum1;
+   unsigned short sum2;
+
+   sum1 = 0;
+   sum2 = 0;
+   while (n) {
+      sum1 = (sum1 + *data) % 255;
+      sum2 = (sum2 + sum1) % 255;
+      ++data;
+      --n;
+   }
+   return (sum2 * 256) | sum1;
+}
@@ -0,0 +1,10 @@
+short sum(short *arr, int n) {
+   short acc;
+   int i;
+
+   acc = 0;
+   for (i = 0; i < n; ++i) {
+      acc = acc + arr[i];
+   }
+   return acc;
+}
@@ -0,0 +1,12 @@
+void scale(short *dst, short *src, short k, int n) {
+   while (n) {
+      if (*src < 0) {
+         *dst = -(*src * k);
+      } else {
+         *dst = *src * k;
+      }
+      ++dst;
+      ++src;
+      --n;
+   }
+}
@@ -0,0 +1,41 @@
+/* insertion sort of 128 pseudo-random ints, in pixelShadow */
+void sort(int *vals, int n) {
+   int i;
+   int j;
+   int key;
+
+   for (i = 1; i < n; ++i) {
+      key = vals[i];
+      j = i - 1;
+      while (j >= 0 && vals[j] > key) {
+         vals[j + 1] = vals[j];
+         --j;
+      }
+      vals[j + 1] = key;
+   }
+}
+
+int main(void) {
+   int *vals;
+   int seed;
+   int sum;
+   int i;
+
+   vals = (int *) 13644278;
+   seed = 1;
+   for (i = 0; i < 128; ++i) {
+      seed = seed * 75 + 74;
+      vals[i] = seed & 4095;
+   }
+
+   sort(vals, 128);
+
+   sum = 0;
+   for (i = 1; i < 128; ++i) {
+      if (vals[i - 1] > vals[i]) {
+         return -1;
+      }
+      sum = sum + vals[i] * (i & 15);
+   }
+   return sum;
+}
@@ -0,0 +1,44 @@
+/* transparent 8x8 sprite blits onto a 64x32 byte-per-pixel screen, both in pixelShadow */
+void blit(unsigned char *screen, unsigned char *sprite, int x, int y) {
+   unsigned char *dst;
+   int row;
+   int col;
+
+   dst = screen + y * 64 + x;
+   for (row = 0; row < 8; ++row) {
+      for (col = 0; col < 8; ++col) {
+         if (*sprite) {
+            *dst = *sprite;
+         }
+         ++sprite;
+         ++dst;
+      }
+      dst = dst + 56;
+   }
+}
+
+int main(void) {
+   unsigned char *screen;
+   unsigned char *sprite;
+   int sum;
+   int i;
+
+   screen = (unsigned char *) 13644278;
+   sprite = screen + 2048;
+   for (i = 0; i < 2048; ++i) {
+      screen[i] = 0;
+   }
+   for (i = 0; i < 64; ++i) {
+      sprite[i] = (i * 5) & 7;
+   }
+
+   for (i = 0; i < 16; ++i) {
+      blit(screen, sprite, i * 3, i);
+   }
+
+   sum = 0;
+   for (i = 0; i < 2048; ++i) {
+      sum = sum + screen[i] * (i & 15);
+   }
+   return sum;
+}
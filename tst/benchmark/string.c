@@ -0,0 +1,56 @@
+/* C string routines over literals and a buffer in pixelShadow */
+int str_len(char *str) {
+   int len;
+   len = 0;
+   while (*str++) {
+      ++len;
+   }
+   return len;
+}
+
+void str_cpy(char *dst, char *src) {
+   while (*src) {
+      *dst++ = *src++;
+   }
+   *dst = 0;
+}
+
+void str_cat(char *dst, char *src) {
+   str_cpy(dst + str_len(dst), src);
+}
+
+int str_cmp(char *a, char *b) {
+   while (*a && *a == *b) {
+      ++a;
+      ++b;
+   }
+   return *a - *b;
+}
+
+int str_index(char *str, char c) {
+   int i;
+   for (i = 0; str[i]; ++i) {
+      if (str[i] == c) {
+         return i;
+      }
+   }
+   return -1;
+}
+
+int main(void) {
+   char *buf;
+   int hash;
+   int i;
+
+   buf = (char *) 13644278;
+   str_cpy(buf, "the quick brown fox ");
+   str_cat(buf, "jumps over the lazy dog");
+
+   hash = str_len(buf);
+   hash = hash * 3 + str_cmp(buf, "the quick brown fox jumps over the lazy cat");
+   hash = hash * 3 + str_index(buf, 'z');
+   for (i = 0; buf[i]; ++i) {
+      hash = hash * 31 + buf[i];
+   }
+   return hash;
+}
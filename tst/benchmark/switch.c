@@ -0,0 +1,33 @@
+int hexval(char c) {
+   switch (c) {
+   case '0': return 0;
+   case '1': return 1;
+   case '2': return 2;
+   case '3': return 3;
+   case '4': return 4;
+   case '5': return 5;
+   case '6': return 6;
+   case '7': return 7;
+   case '8': return 8;
+   case '9': return 9;
+   case 'a': return 10;
+   case 'b': return 11;
+   case 'c': return 12;
+   case 'd': return 13;
+   case 'e': return 14;
+   case 'f': return 15;
+   default: return -1;
+   }
+}
+
+int opcode_len(int op) {
+   switch (op) {
+   case -100: return 1;
+   case 0: return 2;
+   case 7: return 3;
+   case 64: return 1;
+   case 1000: return 4;
+   case 4096: return 2;
+   }
+   return 0;
+}
@@ -37,8 +37,12 @@ run_test() {
     OUT_ASM="${test/%.c/.z80}"
     OUT_8XP="${test/%.c/.8xp}"
 
-    # code generation
-    if ! $COMMAND -o "$OUT_ASM" "$test" >/dev/null 2>&1; then
+    # code generation, with any extra flags the test needs
+    FLAGS=""
+    if [ -f "$test".flags ]; then
+        FLAGS="$(cat "$test".flags)"
+    fi
+    if ! $COMMAND $FLAGS -o "$OUT_ASM" "$test" >/dev/null 2>&1; then
         fail "$test" "code generation failed"
         return 1
     fi
@@ -0,0 +1,13 @@
+static int sum4(int a, int b, int c, int d) {
+   return a + b + c + d;
+}
+
+int main(int argc, char **argv) {
+   int i;
+   int total;
+   total = 0;
+   for (i = 0; i < 3; ++i) {
+      total = total + sum4(i, argc, 10, 100);
+   }
+   return total;
+}
@@ -0,0 +1,59 @@
+void copy16(char *dst, char *src) {
+   int i;
+   for (i = 0; i < 16; ++i) {
+      *dst++ = *src++;
+   }
+}
+
+void clear64(char *buf) {
+   unsigned char i;
+   for (i = 63; i != 0; --i) {
+      buf[i] = 0;
+   }
+   buf[0] = 0;
+}
+
+int sum10(int *vals) {
+   int sum;
+   char i;
+   sum = 0;
+   for (i = 10; i > 0; i--) {
+      sum = sum + *vals++;
+   }
+   return sum;
+}
+
+int countdown(char n) {
+   int steps;
+   steps = 0;
+   while (n) {
+      steps = steps + n;
+      n--;
+   }
+   return steps;
+}
+
+int main(int argc, char **argv) {
+   char buf[64];
+   char src[16];
+   int vals[10];
+   int i;
+   int sum;
+
+   for (i = 0; i < 16; ++i) {
+      src[i] = i + argc;
+   }
+   for (i = 0; i < 10; ++i) {
+      vals[i] = i * argc;
+   }
+   
+   clear64(&buf[0]);
+   copy16(&buf[8], &src[0]);
+
+   sum = 0;
+   for (i = 0; i < 64; ++i) {
+      sum = sum + buf[i];
+   }
+   
+   return sum + sum10(&vals[0]) + countdown(argc);
+}
@@ -0,0 +1,17 @@
+typedef char bool;
+
+static bool isupper(char c) {
+   return c >= 'A' && c <= 'Z';
+}
+
+static char toupper(char c) {
+   if (c >= 'a' && c <= 'z') {
+      return c + ('A' - 'a');
+   } else {
+      return c;
+   }
+}
+
+int main(int argc, char **argv) {
+   return isupper(toupper(argc));
+}
@@ -0,0 +1,25 @@
+int inc(int x) {
+   return x + 1;
+}
+
+int main(int n) {
+   int a;
+   int b;
+   int c;
+   int d;
+   int e;
+   int i;
+   a = n;
+   b = n;
+   c = n;
+   d = n;
+   e = n;
+   for (i = 0; i < 4; ++i) {
+      a = inc(a);
+      b = inc(b) + a;
+      c = inc(c) + b;
+      d = inc(d) + c;
+      e = inc(e) + d;
+   }
+   return a + b + c + d + e + n;
+}
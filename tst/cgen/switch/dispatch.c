@@ -0,0 +1,68 @@
+int hexval(char c) {
+   switch (c) {
+   case '0': return 0;
+   case '1': return 1;
+   case '2': return 2;
+   case '3': return 3;
+   case '4': return 4;
+   case '5': return 5;
+   case '6': return 6;
+   case '7': return 7;
+   case '8': return 8;
+   case '9': return 9;
+   case 'a': return 10;
+   case 'b': return 11;
+   case 'c': return 12;
+   case 'd': return 13;
+   case 'e': return 14;
+   case 'f': return 15;
+   default: return -1;
+   }
+}
+
+int opcode_len(int op) {
+   int len;
+   len = 0;
+   switch (op) {
+   case -100: len = 1; break;
+   case 0: len = 2; break;
+   case 7: len = 3; break;
+   case 64: len = 1; break;
+   case 1000: len = 4; break;
+   case 4096: len = 2; break;
+   }
+   return len;
+}
+
+int octal(char c) {
+   switch (c) {
+   case '0': return 7;
+   case '1': return 6;
+   case '2': return 5;
+   case '3': return 4;
+   case '4': return 3;
+   case '5': return 2;
+   case '6': return 1;
+   case '7': return 0;
+   default: return -1;
+   }
+}
+
+int weekday(int d) {
+   switch (d) {
+   case 0: return 5;
+   case 1: return 3;
+   case 2: return 8;
+   case 3: return 1;
+   case 4: return 9;
+   case 5: return 2;
+   case 6: return 7;
+   default: return 0;
+   }
+}
+
+int main(int argc, char **argv) {
+   return hexval('7') + hexval('c') * 16 + hexval('x') * 256 +
+      opcode_len(-100) + opcode_len(7) * 8 + opcode_len(1000) * 64 + opcode_len(argc) * 512 +
+      weekday(4) * 1024 + weekday(argc) * 4096 + octal('3') * 2048 + octal('9') * 16384;
+}
@@ -0,0 +1,4 @@
+int main(int argc, char **argv) {
+case 1:
+   return 0;
+}
@@ -0,0 +1,9 @@
+int main(int argc, char **argv) {
+   switch (argc) {
+   case 1:
+      return 1;
+   case 2 - 1:
+      return 2;
+   }
+   return 0;
+}
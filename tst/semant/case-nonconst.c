@@ -0,0 +1,7 @@
+int main(int argc, char **argv) {
+   switch (argc) {
+   case argc:
+      return 1;
+   }
+   return 0;
+}
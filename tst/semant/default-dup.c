@@ -0,0 +1,9 @@
+int main(int argc, char **argv) {
+   switch (argc) {
+   default:
+      return 1;
+   default:
+      return 2;
+   }
+   return 0;
+}
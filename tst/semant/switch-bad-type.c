@@ -0,0 +1,7 @@
+int main(int argc, char **argv) {
+   switch (argv) {
+   case 0:
+      return 1;
+   }
+   return 0;
+}
@@ -0,0 +1,26 @@
+enum color {RED, GREEN, BLUE};
+
+int main(int argc, char **argv) {
+   enum color c;
+   int n;
+   c = GREEN;
+   n = 0;
+   while (argc) {
+      switch (argc) {
+      case 1:
+         n = n + 1;
+      case 2:
+      case 3:
+         break;
+      case -1:
+         continue;
+      default:
+         switch (c) {
+         case RED: n = 2; break;
+         case BLUE: n = 3; break;
+         }
+      }
+      argc = argc - 1;
+   }
+   return n;
+}
@@ -0,0 +1,160 @@
+#!/bin/bash
+
+# STRESS BENCHMARKS FOR ZC
+# Generate synthetic sources of increasing size and time how each compiler pass scales.
+# With -m, report peak resident set size (KB) instead of time.
+
+USAGE="$0 [-m] KIND ZC [SIZE...]
+KIND: dag live ralloc peephole"
+
+METRIC=time
+if [[ "$1" == "-m" ]]; then
+    METRIC=rss
+    shift
+fi
+
+if [[ $# -lt 2 ]]; then
+    echo "$USAGE"
+    exit 1
+fi
+
+KIND="$1"
+ZC="$2"
+shift 2
+SIZES="${@:-250 500 1000 2000 4000 8000}"
+
+if ! [ -x "$ZC" ]; then
+    echo "$0: $ZC: not executable"
+    exit 2
+fi
+
+TMPDIR=$(mktemp -d)
+trap 'rm -rf "$TMPDIR"' EXIT
+
+# $1: number of terms in generated expression
+# Sum of products of a small set of operands, so that the DAG pass sees both many distinct
+# nodes and many repeated subexpressions.
+gen_dag() {
+    echo "int a; int b; int c;"
+    echo "int f(void) {"
+    printf "   return 0"
+    for ((i = 0; i < $1; ++i)); do
+        printf " +\n      (a + %d) * (b - c)" $((i % 64))
+    done
+    echo ";"
+    echo "}"
+}
+
+# $1: number of statements in generated function
+# Branches and a loop over a fixed pool of locals, so that liveness sees many blocks and values
+# that stay live across them.
+gen_live() {
+    echo "int f(int n) {"
+    for ((i = 0; i < 32; ++i)); do
+        echo "   int v$i;"
+    done
+    for ((i = 0; i < 32; ++i)); do
+        echo "   v$i = n + $i;"
+    done
+    echo "   while (n) {"
+    for ((i = 0; i < $1; ++i)); do
+        printf "      if (n > %d) { v%d = v%d + v%d; } else { v%d = v%d - n; }\n" \
+               $((i % 256)) $((i % 32)) $(((i + 1) % 32)) $(((i + 7) % 32)) \
+               $(((i + 3) % 32)) $(((i + 5) % 32))
+    done
+    echo "      n = n - 1;"
+    echo "   }"
+    printf "   return v0"
+    for ((i = 1; i < 32; ++i)); do
+        printf " + v%d" $i
+    done
+    echo ";"
+    echo "}"
+}
+
+# $1: number of statements in generated block
+# One long straight-line block, so that register allocation runs over a single long stream.
+gen_ralloc() {
+    echo "int f(int n) {"
+    for ((i = 0; i < 8; ++i)); do
+        echo "   int v$i;"
+    done
+    for ((i = 0; i < 8; ++i)); do
+        echo "   v$i = n;"
+    done
+    for ((i = 0; i < $1; ++i)); do
+        printf "   v%d = v%d + v%d - %d;\n" $((i % 8)) $(((i + 1) % 8)) $(((i + 3) % 8)) $((i % 100))
+    done
+    echo "   return v0;"
+    echo "}"
+}
+
+# $1: number of statements in generated function
+# Stack-resident locals and calls, so that the peephole matcher sees many frame accesses and
+# argument pushes. Per-instruction throughput is printed by -p peephole-stats.
+gen_peephole() {
+    echo "int g(int x, int y) { return x - y; }"
+    echo "int f(int n) {"
+    for ((i = 0; i < 16; ++i)); do
+        echo "   int v$i;"
+    done
+    for ((i = 0; i < 16; ++i)); do
+        echo "   v$i = n;"
+    done
+    for ((i = 0; i < $1; ++i)); do
+        printf "   v%d = g(v%d, v%d) + v%d;\n" $((i % 16)) $(((i + 1) % 16)) $(((i + 5) % 16)) \
+               $(((i + 9) % 16))
+    done
+    echo "   return v0;"
+    echo "}"
+}
+
+# $1: source file
+# $2: compiler flags
+# prints user+system seconds, or peak RSS in KB if METRIC=rss
+timeit() {
+    local T
+    T=$( { /usr/bin/time -f "%U %S %M" "$ZC" $2 -o /dev/null < "$1" > /dev/null 2> /dev/null; } 2>&1 ) || return 1
+    if [[ "$METRIC" == rss ]]; then
+        echo "$T" | tail -n1 | awk '{print $3}'
+    else
+        echo "$T" | tail -n1 | awk '{print $1 + $2}'
+    fi
+}
+
+case "$KIND" in
+    dag)
+        GEN=gen_dag
+        REF="-O none"
+        OPT="-O none,DAG"
+        ;;
+    live)
+        GEN=gen_live
+        REF="-O none"
+        OPT="-O none -p live-info"
+        ;;
+    ralloc)
+        GEN=gen_ralloc
+        REF="-O none"
+        OPT="-O none,function-ralloc"
+        ;;
+    peephole)
+        GEN=gen_peephole
+        REF="-O none"
+        OPT="-O none,peephole -p peephole-stats"
+        ;;
+    *)
+        echo "$USAGE"
+        exit 1
+        ;;
+esac
+
+printf "SIZE\t%s\t%s\tDELTA\n" "$REF" "$OPT"
+for SIZE in $SIZES; do
+    SRC="$TMPDIR/$KIND-$SIZE.c"
+    $GEN $SIZE > "$SRC"
+    REFTIME=$(timeit "$SRC" "$REF") || { echo "$0: $SRC: zc $REF failed" >&2; exit 3; }
+    OPTTIME=$(timeit "$SRC" "$OPT") || { echo "$0: $SRC: zc $OPT failed" >&2; exit 3; }
+    DELTA=$(awk "BEGIN {print $OPTTIME - $REFTIME}")
+    printf "%d\t%s\t%s\t%s\n" $SIZE $REFTIME $OPTTIME $DELTA
+done